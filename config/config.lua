@@ -5,6 +5,47 @@ config = {
     ioThreadsCount = 2,        -- Asio I/O 线程数（<=0 会自动用 CPU 核心数）
     workerThreadsCount = 4,    -- 后台业务线程池大小（<=0 同样自动取核心数）
     IdleTimeoutMs = 60000,     -- 空闲连接超时毫秒数，超过则由 IdleConnectionManager 关闭
+
+    -- I/O 分片：每个 I/O 线程独占一个 io_context，连接终生固定在一个分片上（多核机器减少 reactor 锁竞争）
+    shardedIo = false,
+    shardPolicy = 'roundRobin', -- 新连接分配：roundRobin（轮询）/ leastConn（最少连接）
+    pinIoThreads = true,       -- 分片模式下把第 i 个 I/O 线程绑定到第 i 个 CPU 核
+
+    -- 监听：SO_REUSEPORT 多 acceptor（重连风暴时由内核分散新连接），以及每次唤醒的批量接入上限
+    reusePort = false,
+    acceptorCount = 0,         -- reusePort 时 acceptor 数量，0 表示每个 I/O 线程一个
+    acceptBatch = 16,          -- 每次唤醒最多连续 accept 的连接数
+
+    -- 自适应读缓冲：单次读取大小在 [readBufferMin, readBufferMax] 间随流量伸缩，已知帧长时按剩余帧长一次读满
+    readBufferMin = 1024,
+    readBufferMax = 65536,
+    releaseIdleReadBuffer = false, -- 空闲连接把读缓冲还给 BufferPool 以省内存；归还后下次唤醒多一次 MSG_PEEK，适合大量长连接、请求稀疏的场景
+    releaseIdleReadAfter = 8,      -- 开启时连续读空这么多次才归还，持续有请求的连接不会每次都取还
+
+    -- 写合并：单次 writev 合并的帧数/字节数上限
+    writeBatchMaxFrames = 64,
+    writeBatchMaxBytes = 262144,
+    writeCork = 'off',         -- 'off' / 'msgMore'（队列里还有数据时带 MSG_MORE）/ 'cork'（批量期间 TCP_CORK，队列清空再拔塞）
+    flushOnReadEnd = true,     -- 一轮读处理中产生的回包等本轮解析完再一次性发出（流水线请求合并成一次 syscall）
+
+    -- 大帧零拷贝发送（MSG_ZEROCOPY）：单帧 >= 该字节数时启用，0 关闭；内核回报已拷贝（如回环）时该连接自动退回普通发送
+    zeroCopyThreshold = 0,
+
+    -- 入站帧上限：帧头长度超过 maxFrameBytes 直接回 frame_too_large 并丢弃 body（不缓冲），0 不限制
+    -- 流式路由（registerStream）不受此限制，body 按块交给 handler，未消费字节达到 streamWindowBytes 时暂停读
+    maxFrameBytes = 16777216,
+    streamWindowBytes = 1048576,
+
+    -- 同一连接内的请求顺序（连接初始模式，routes[].ordering 可按路由覆盖）：
+    --   'none'    handler 并发执行，回包按完成先后发送（吞吐最高）
+    --   'strict'  同一连接的请求逐个执行，适合有状态的会话
+    --   'inOrder' handler 并发执行，回包按请求顺序发送（先完成的暂存），适合 pipeline 客户端
+    ordering = 'none',
+
+    -- socket 后端：'epoll' / 'io_uring'（需 -DDOMAIN_IO_URING=ON 构建 domain_uring；内核不支持时自动回退到 epoll 构建）
+    ioBackend = 'epoll',                        -- 环境变量 DOMAIN_IO_BACKEND 可覆盖
+    -- epollBinary = '/path/to/domain',          -- 默认与当前可执行文件同目录
+    -- ioUringBinary = '/path/to/domain_uring',
   },
 
   -- 线程池限流：控制任务队列最多能积压多少任务
@@ -18,10 +59,20 @@ config = {
     autoTune = true,
 
     -- 根据 maxQueueSize 选定水位（这里直接写数值，避免 Lua 解析时 nil）
-    highWatermark = 7000,      -- ~70% 的 maxQueueSize
-    lowWatermark = 1000,       -- ~10% 的 maxQueueSize
-    upThreshold = 3,
-    downThreshold = 10,
+    highWatermark = 7000,      -- ~70% 的 maxQueueSize，超过即视同等待超标
+    lowWatermark = 1000,       -- ~10% 的 maxQueueSize，超过时不缩容
+    upThreshold = 2,           -- 连续几个采样周期等待超标才扩容
+    downThreshold = 10,        -- 连续几个采样周期空闲才缩容
+
+    -- 按排队等待时间伸缩：p99 超过目标且线程忙就按超标倍数扩容（计算密集时不超过核数），
+    -- p99 低于目标一半且线程空闲就缩到利用率约 70%
+    queueWaitSloUs = 5000,     -- 排队等待 p99 目标（微秒）
+    autoTuneIntervalMs = 100,  -- 采样周期
+
+    -- 空闲策略：取不到任务先自旋再休眠，中等负载下省掉每个请求的 futex 休眠/唤醒（单核机器自动不自旋）
+    idleSpinUs = 50,           -- 0 = 直接休眠
+
+    frameBatchSize = 32,       -- 与内置默认值相同，取值含义见 README（threadPool.frameBatchSize）
   },
 
   -- 全局限制
@@ -66,11 +117,25 @@ config = {
   -- 按 IP 限制：连接数 / QPS
   ipLimit = {
     maxConnPerIp = 200,      -- 0 表示关闭
-    maxQpsPerIp = 0,         -- 0 表示关闭
-    whitelist = {  },  -- 白名单 IP 不限流
+    maxQpsPerIp = 0,         -- 0 表示关闭（GCRA 平滑限速，不是固定 1 秒窗口）
+    qpsBurst = 0,            -- 允许的突发请求数，0 表示等于 maxQpsPerIp
+    whitelist = {  },  -- 白名单 IP 不限流（精确 IP）
+    -- CIDR 访问控制，accept 阶段按最长前缀匹配（更具体的规则优先，同一前缀 deny 优先）；
+    -- 运行中可在本机 POST http://127.0.0.1:9100/acl/reload 重新加载本段，GET /acl 查看规则与命中数
+    allow = {  },  -- 可信网段（如 { "10.0.0.0/8", "::1/128" }）：跳过连接数 / QPS 限制，默认不信任任何来源
+    deny = {  },   -- 黑名单网段：直接关闭连接
     stateTtlSec = 300,       -- IP 计数状态 TTL（秒），0 表示不过期
   },
 
+  -- 流量分析：固定内存统计每分钟的 Top-K 源 IP / 会话（按帧数、字节数）与去重 IP / 会话数，
+  -- GET http://127.0.0.1:9100/traffic 查看
+  analytics = {
+    enabled = true,
+    topK = 20,               -- 每个榜单展示的条数
+    capacity = 256,          -- 每个榜单监控的键数（SpaceSaving），越大越准
+    hllPrecision = 12,       -- HyperLogLog 精度 p（4~16），去重数相对误差约 1.04/sqrt(2^p)
+  },
+
   -- 标准错误帧定义（客户端可按 msgType 识别原因）
   errorFrames = {
     ipConnLimitMsgType = 65000,
@@ -81,10 +146,27 @@ config = {
     inflightLimitBody = 'inflight_limit',
     msgRateLimitMsgType = 65003,
     msgRateLimitBody = 'msg_rate_limit',
+    frameTooLargeMsgType = 65005,
+    frameTooLargeBody = 'frame_too_large',
     backpressureMsgType = 65535,
     backpressureBody = 'backpressure',
   },
 
+  -- 独立线程池（舱壁）：重路由用 dedicated 策略绑到这里，不占共享线程池
+  workerPools = {
+    heavy = { threads = 2, maxQueueSize = 1000 },
+  },
+
+  -- 路由执行策略（覆盖代码里注册时的默认值）：
+  --   'inline'    在连接 I/O strand 上直接执行，适合心跳/echo 这类极轻的 handler
+  --   'worker'    在共享线程池（threadPool）上执行
+  --   'dedicated' 在 pool 指定的独立线程池上执行
+  routes = {
+    [1] = { policy = 'inline' },
+    [2] = { policy = 'inline' },
+    -- [200] = { policy = 'dedicated', pool = 'heavy' },
+  },
+
   -- 按 msgType 的限流配置
   messageLimits = {
     -- 心跳：一般不单独限流（enabled=false）
@@ -104,6 +186,8 @@ config = {
       maxQps = 100,
       burst = 100,
       maxConcurrent = 10,
+      maxQueue = 50,        -- 并发满时最多 50 个请求排队等待名额（0 = 直接拒绝）
+      queueTimeoutMs = 200, -- 排队超过 200ms 才拒绝
     } 
   }
 
@@ -0,0 +1,107 @@
+// 线程池空闲策略基准：模拟 worker 路由上的 echo 请求，
+// 单个 I/O 线程按固定速率投递请求到线程池，handler 拷贝 body 后 post 回 I/O 线程“发送”，
+// 统计从投递到回到 I/O 线程的延迟 p50/p99，以及期间的休眠次数，对比
+//   1) park ：取不到任务直接在 cv 上休眠（旧行为）
+//   2) spin ：先自旋 spinUs 再休眠（自旋线程数自动：核数的一半，单核不自旋）
+//   3) spin1：同上但强制允许 1 个线程自旋（单核机器上观察自旋的代价）
+// 用法：idle_spin_bench [seconds=2] [spinUs=50] [poolThreads=4]
+
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Metrics.h"
+#include "ThreadPool.h"
+
+namespace asio = boost::asio;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        double p50Us;
+        double p99Us;
+        std::size_t done;
+        std::int64_t parks;
+        std::int64_t spinHits;
+    };
+
+    Result run(ThreadPool& pool, std::size_t ratePerSec, std::chrono::seconds duration) {
+        asio::io_context io;
+        std::vector<double> latUs;
+        latUs.reserve(ratePerSec * duration.count() + 16);
+        const std::string body(64, 'x');
+        auto& m = MetricsRegistry::Instance();
+        const auto parks0 = m.workerParks().value();
+        const auto hits0 = m.workerSpinHits().value();
+
+        // 每 200us 一个节拍，按速率累计应发的请求数
+        constexpr auto kTick = std::chrono::microseconds(200);
+        const double perTick = static_cast<double>(ratePerSec) * 200 / 1e6;
+        const auto stopAt = Clock::now() + duration;
+
+        asio::co_spawn(
+            io,
+            [&]() -> asio::awaitable<void> {
+                auto ex = co_await asio::this_coro::executor;
+                asio::steady_timer timer(ex);
+                auto due = Clock::now();
+                double credit = 0;
+                while (Clock::now() < stopAt) {
+                    credit += perTick;
+                    for (; credit >= 1; credit -= 1) {
+                        auto t0 = Clock::now();
+                        pool.post([&, ex, t0] {
+                            std::string reply(body);  // echo handler
+                            asio::post(ex, [&, t0, reply = std::move(reply)] {
+                                latUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+                            });
+                        });
+                    }
+                    due += kTick;
+                    timer.expires_at(due);
+                    co_await timer.async_wait(asio::use_awaitable);
+                }
+                // 等在途请求回来
+                timer.expires_after(std::chrono::milliseconds(50));
+                co_await timer.async_wait(asio::use_awaitable);
+            },
+            asio::detached);
+        io.run();
+
+        std::sort(latUs.begin(), latUs.end());
+        auto pct = [&](double p) { return latUs.empty() ? 0.0 : latUs[std::min(latUs.size() - 1, static_cast<std::size_t>(p * latUs.size()))]; };
+        return {pct(0.50), pct(0.99), latUs.size(), m.workerParks().value() - parks0, m.workerSpinHits().value() - hits0};
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::chrono::seconds duration(argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 2);
+    std::chrono::microseconds spin(argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 50);
+    std::size_t poolThreads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4;
+
+    std::printf("duration=%llds spin=%lldus poolThreads=%zu hardware_concurrency=%u\n", static_cast<long long>(duration.count()),
+                static_cast<long long>(spin.count()), poolThreads, std::thread::hardware_concurrency());
+    std::printf("%8s %6s %10s %10s %10s %10s %10s\n", "rate/s", "mode", "p50(us)", "p99(us)", "done", "parks", "spinHits");
+
+    struct Mode {
+        const char* name;
+        std::chrono::microseconds spin;
+        std::size_t maxSpinners;
+    };
+    const Mode modes[] = {{"park", std::chrono::microseconds(0), 0}, {"spin", spin, 0}, {"spin1", spin, 1}};
+    for (std::size_t rate : {1000, 5000, 20000, 50000}) {
+        for (const auto& mode : modes) {
+            ThreadPool pool(poolThreads);
+            pool.setIdleSpin(mode.spin, mode.maxSpinners);
+            auto r = run(pool, rate, duration);
+            std::printf("%8zu %6s %10.1f %10.1f %10zu %10lld %10lld\n", rate, mode.name, r.p50Us, r.p99Us, r.done, static_cast<long long>(r.parks),
+                        static_cast<long long>(r.spinHits));
+        }
+    }
+    return 0;
+}
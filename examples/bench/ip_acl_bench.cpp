@@ -0,0 +1,128 @@
+// IpAcl 查找基准：rules 条随机 CIDR（IPv4 /8~/32 与 IPv6 /32~/128 各半），对随机 IP 做最长前缀匹配，对比
+//   1) linear：逐条比较所有规则取最长匹配（不建索引的做法）
+//   2) trie  ：IpAcl 的压缩前缀树
+// 每次查找的 IP 预先生成（含一半落在规则内的地址），统计每次查找的平均耗时。
+// 用法：ip_acl_bench [rules=10000] [lookups=2000000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "IpAcl.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Cidr {
+        std::uint64_t hi;
+        std::uint64_t lo;
+        std::uint32_t len;
+        bool deny;
+    };
+
+    void ToWords(const IpKey& key, std::uint64_t& hi, std::uint64_t& lo) {
+        hi = lo = 0;
+        for (int i = 0; i < 8; ++i) {
+            hi = (hi << 8) | key.bytes[i];
+            lo = (lo << 8) | key.bytes[8 + i];
+        }
+    }
+
+    bool Matches(std::uint64_t hi, std::uint64_t lo, const Cidr& c) {
+        if (c.len <= 64) {
+            return c.len == 0 || ((hi ^ c.hi) >> (64 - c.len)) == 0;
+        }
+        return hi == c.hi && (c.len == 128 ? lo == c.lo : ((lo ^ c.lo) >> (128 - c.len)) == 0);
+    }
+
+    std::string V4(std::uint32_t a) {
+        return std::to_string(a >> 24) + "." + std::to_string((a >> 16) & 0xff) + "." + std::to_string((a >> 8) & 0xff) + "." + std::to_string(a & 0xff);
+    }
+
+    std::string V6(std::mt19937_64& rng) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "2001:db8:%x:%x:%x:%x:%x:%x", unsigned(rng() & 0xffff), unsigned(rng() & 0xffff), unsigned(rng() & 0xffff),
+                      unsigned(rng() & 0xffff), unsigned(rng() & 0xffff), unsigned(rng() & 0xffff));
+        return buf;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t rules = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+    std::mt19937_64 rng(42);
+    IpLimitConfig cfg;
+    std::vector<std::string> hosts;  // 规则覆盖的地址，用来生成命中的查找
+    for (std::size_t i = 0; i < rules; ++i) {
+        bool deny = i % 3 != 0;
+        std::string text;
+        std::string host;
+        if (i % 2 == 0) {
+            auto addr = static_cast<std::uint32_t>(rng());
+            host = V4(addr);
+            text = host + "/" + std::to_string(8 + rng() % 25);
+        } else {
+            host = V6(rng);
+            text = host + "/" + std::to_string(32 + rng() % 97);
+        }
+        (deny ? cfg.deny : cfg.allow).insert(text);
+        hosts.push_back(host);
+    }
+    IpAcl::Instance().update(cfg);
+
+    // 线性扫描的对照组用同样的规则
+    std::vector<Cidr> linear;
+    for (const auto* list : {&cfg.deny, &cfg.allow}) {
+        for (const auto& text : *list) {
+            auto slash = text.find('/');
+            auto key = *IpKey::Parse(text.substr(0, slash));
+            Cidr c{};
+            ToWords(key, c.hi, c.lo);
+            auto bits = static_cast<std::uint32_t>(std::stoul(text.substr(slash + 1)));
+            c.len = text.find(':') == std::string::npos ? 96 + bits : bits;
+            c.deny = list == &cfg.deny;
+            linear.push_back(c);
+        }
+    }
+
+    std::vector<IpKey> probes;
+    probes.reserve(1 << 16);
+    for (std::size_t i = 0; i < (1 << 16); ++i) {
+        probes.push_back(i % 2 == 0 ? *IpKey::Parse(hosts[rng() % hosts.size()]) : *IpKey::Parse(V4(static_cast<std::uint32_t>(rng()))));
+    }
+
+    std::size_t linearLookups = std::max<std::size_t>(1, lookups / std::max<std::size_t>(1, rules / 100));
+    std::size_t hitsLinear = 0;
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < linearLookups; ++i) {
+        std::uint64_t hi;
+        std::uint64_t lo;
+        ToWords(probes[i & 0xffff], hi, lo);
+        const Cidr* best = nullptr;
+        for (const auto& c : linear) {
+            if (Matches(hi, lo, c) && (!best || c.len > best->len)) {
+                best = &c;
+            }
+        }
+        hitsLinear += best != nullptr;
+    }
+    double linearNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / linearLookups;
+
+    std::size_t hitsTrie = 0;
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < lookups; ++i) {
+        hitsTrie += IpAcl::Instance().check(probes[i & 0xffff]) != IpAcl::Verdict::None;
+    }
+    double trieNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / lookups;
+
+    std::printf("rules=%zu (after dedup %zu)\n", rules, IpAcl::Instance().ruleCount());
+    std::printf("linear: %10.1f ns/lookup  (hit rate %.2f, %zu lookups)\n", linearNs, double(hitsLinear) / linearLookups, linearLookups);
+    std::printf("trie  : %10.1f ns/lookup  (hit rate %.2f, %zu lookups)\n", trieNs, double(hitsTrie) / lookups, lookups);
+    return 0;
+}
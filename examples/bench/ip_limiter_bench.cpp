@@ -0,0 +1,151 @@
+// IpLimiter 基准：threads 个线程对 ips 个不同源 IP 并发执行 allowQps，对比
+//   1) mutex：旧实现（全局 mutex + unordered_map<string>，秒级窗口，system_clock，TTL 到期时整表扫描）
+//   2) shard：IpLimiter（16 字节二进制键、64 个分片、GCRA、每次访问增量清理少量哈希桶）
+// 两种方式都传入预先格式化好的 IP（旧实现用字符串，新实现用 IpKey），不计解析开销。
+// TTL 设为 1 秒，让旧实现在测量期间多次触发整表 GC；统计吞吐与单次调用的最大耗时（停顿）。
+// 用法：ip_limiter_bench [ips=500000] [seconds=3] [threads=8]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Config.h"
+#include "IpLimiter.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // 旧 IpLimiter::allowQps 路径（含懒触发的整表 GC），作为对照组
+    class MutexIpLimiter {
+      public:
+        MutexIpLimiter(std::size_t maxQps, std::uint64_t ttlSec) : maxQps_(maxQps), ttlSec_(ttlSec) {}
+
+        bool allowQps(const std::string& ip) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            std::uint64_t sec = std::chrono::duration_cast<std::chrono::seconds>(now).count();
+            gcIfNeeded(sec);
+
+            auto& st = qps_[ip];
+            if (st.windowSec != sec) {
+                st.windowSec = sec;
+                st.count = 0;
+            }
+            if (st.count >= maxQps_) {
+                return false;
+            }
+            ++st.count;
+            st.lastAccess = sec;
+            return true;
+        }
+
+      private:
+        struct QpsState {
+            std::uint64_t windowSec{0};
+            std::size_t count{0};
+            std::uint64_t lastAccess{0};
+        };
+
+        void gcIfNeeded(std::uint64_t nowSec) {
+            if (lastGcSec_ != 0 && nowSec - lastGcSec_ < ttlSec_) {
+                return;
+            }
+            lastGcSec_ = nowSec;
+            for (auto it = qps_.begin(); it != qps_.end();) {
+                if (nowSec - it->second.lastAccess > ttlSec_) {
+                    it = qps_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        std::mutex mtx_;
+        std::size_t maxQps_;
+        std::uint64_t ttlSec_;
+        std::uint64_t lastGcSec_{0};
+        std::unordered_map<std::string, QpsState> qps_;
+    };
+
+    struct Result {
+        double perSec;
+        double maxUs;
+    };
+
+    template <typename Call>
+    Result run(std::size_t threads, double seconds, Call call) {
+        std::atomic<bool> go{false};
+        std::atomic<bool> stop{false};
+        std::atomic<std::uint64_t> ops{0};
+        std::atomic<std::int64_t> maxNs{0};
+        std::vector<std::thread> ts;
+        for (std::size_t t = 0; t < threads; ++t) {
+            ts.emplace_back([&, t] {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                std::uint64_t local = 0;
+                std::int64_t localMax = 0;
+                std::uint64_t i = t * 7919;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto t0 = Clock::now();
+                    call(i++);
+                    localMax = std::max<std::int64_t>(localMax, (Clock::now() - t0).count());
+                    ++local;
+                }
+                ops.fetch_add(local, std::memory_order_relaxed);
+                std::int64_t cur = maxNs.load();
+                while (localMax > cur && !maxNs.compare_exchange_weak(cur, localMax)) {
+                }
+            });
+        }
+        auto t0 = Clock::now();
+        go.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop.store(true);
+        for (auto& t : ts) {
+            t.join();
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        return {ops.load() / secs, maxNs.load() / 1000.0};
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t ips = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000;
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 3.0;
+    std::size_t threads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+
+    std::vector<std::string> texts;
+    std::vector<IpKey> keys;
+    texts.reserve(ips);
+    keys.reserve(ips);
+    for (std::size_t i = 0; i < ips; ++i) {
+        // 一半 IPv4、一半 IPv6
+        std::string text = (i % 2 == 0) ? "10." + std::to_string((i >> 16) & 0xff) + "." + std::to_string((i >> 8) & 0xff) + "." + std::to_string(i & 0xff)
+                                        : "2001:db8::" + std::to_string(i % 10000) + ":" + std::to_string(i / 10000);
+        keys.push_back(*IpKey::Parse(text));
+        texts.push_back(std::move(text));
+    }
+
+    IpLimitConfig cfg;
+    cfg.maxQpsPerIp = 1000;
+    cfg.stateTtlSec = 1;
+    IpLimiter::Instance().updateConfig(cfg);
+    MutexIpLimiter oldLimiter(cfg.maxQpsPerIp, cfg.stateTtlSec);
+
+    std::printf("ips=%zu seconds=%.1f threads=%zu hardware_concurrency=%u ttl=1s\n", ips, seconds, threads, std::thread::hardware_concurrency());
+    auto m = run(threads, seconds, [&](std::uint64_t i) { oldLimiter.allowQps(texts[i % ips]); });
+    auto s = run(threads, seconds, [&](std::uint64_t i) { IpLimiter::Instance().allowQps(keys[i % ips]); });
+    std::printf("%6s %14s %14s\n", "", "ops/s", "max call us");
+    std::printf("%6s %14.0f %14.1f\n", "mutex", m.perSec, m.maxUs);
+    std::printf("%6s %14.0f %14.1f\n", "shard", s.perSec, s.maxUs);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// MessageLimiter 争用基准：threads 个线程并发执行 allow + onFinish，对比
+//   1) mutex：旧实现（全局 mutex 下 unordered_map 查状态，每个状态一把 mutex 保护令牌）
+//   2) flat ：MessageLimiter（按 msgType 下标的扁平表，缓存行对齐的 GCRA 桶，只用原子操作）
+// 两种负载：
+//   one ：所有线程打同一个 msgType（单桶争用上限）
+//   many：每个线程轮流打 64 个 msgType（不同类型之间不应互相干扰）
+// 策略为开启、QPS 很高（几乎都放行）且带并发上限，覆盖 QPS 与并发两条检查路径。
+// 用法：limiter_bench [opsPerThread=200000] [threads=32]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MessageLimiter.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::uint16_t kBaseType = 1000;
+    constexpr std::uint16_t kManyTypes = 64;
+
+    // 旧 MessageLimiter 的 allow/onFinish 路径，作为对照组
+    class MutexLimiter {
+      public:
+        void update(const std::unordered_map<std::uint16_t, MsgLimitConfig>& limits) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            for (const auto& [type, cfg] : limits) {
+                auto st = std::make_shared<State>();
+                st->cfg = cfg;
+                st->lastRefillNs = nowNs();
+                st->tokens = cfg.burst > 0 ? cfg.burst : cfg.maxQps;
+                states_[type] = std::move(st);
+            }
+        }
+
+        bool allow(std::uint16_t type) {
+            auto st = get(type);
+            const auto cfg = st->cfg;
+            if (!cfg.enabled) {
+                return true;
+            }
+            if (cfg.maxQps > 0) {
+                const double capacity = cfg.burst > 0 ? cfg.burst : cfg.maxQps;
+                std::lock_guard<std::mutex> lock(st->mtx);
+                auto now = nowNs();
+                st->tokens = std::min(capacity, st->tokens + static_cast<double>(now - st->lastRefillNs) * cfg.maxQps / 1e9);
+                st->lastRefillNs = now;
+                if (st->tokens < 1.0) {
+                    return false;
+                }
+                st->tokens -= 1.0;
+            }
+            if (cfg.maxConcurrent > 0 && st->concurrent.fetch_add(1, std::memory_order_relaxed) >= cfg.maxConcurrent) {
+                st->concurrent.fetch_sub(1, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(st->mtx);
+                st->tokens += 1.0;
+                return false;
+            }
+            return true;
+        }
+
+        void onFinish(std::uint16_t type) {
+            auto st = get(type);
+            if (st->cfg.enabled && st->cfg.maxConcurrent > 0) {
+                st->concurrent.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+      private:
+        struct State {
+            MsgLimitConfig cfg;
+            std::atomic<int> concurrent{0};
+            std::mutex mtx;
+            double tokens{0};
+            std::int64_t lastRefillNs{0};
+        };
+
+        static std::int64_t nowNs() { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(); }
+
+        std::shared_ptr<State> get(std::uint16_t type) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto& st = states_[type];
+            if (!st) {
+                st = std::make_shared<State>();
+            }
+            return st;
+        }
+
+        std::mutex mtx_;
+        std::unordered_map<std::uint16_t, std::shared_ptr<State>> states_;
+    };
+
+    template <typename Limiter>
+    double run(Limiter& limiter, std::size_t threads, std::size_t ops, bool many, std::uint64_t& allowed) {
+        std::atomic<std::uint64_t> ok{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> ts;
+        for (std::size_t t = 0; t < threads; ++t) {
+            ts.emplace_back([&, t] {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                std::uint64_t local = 0;
+                for (std::size_t i = 0; i < ops; ++i) {
+                    auto type = static_cast<std::uint16_t>(many ? kBaseType + (t + i) % kManyTypes : kBaseType);
+                    if (limiter.allow(type)) {
+                        ++local;
+                        limiter.onFinish(type);
+                    }
+                }
+                ok.fetch_add(local, std::memory_order_relaxed);
+            });
+        }
+        auto t0 = Clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& t : ts) {
+            t.join();
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        allowed = ok.load();
+        return threads * ops / secs;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 32;
+
+    std::unordered_map<std::uint16_t, MsgLimitConfig> limits;
+    for (std::uint16_t i = 0; i < kManyTypes; ++i) {
+        limits[kBaseType + i] = MsgLimitConfig{true, 1'000'000'000, 1 << 20, 1 << 20};
+    }
+
+    std::printf("opsPerThread=%zu threads=%zu hardware_concurrency=%u\n", ops, threads, std::thread::hardware_concurrency());
+    std::printf("%6s %16s %16s\n", "load", "mutex", "flat");
+    for (bool many : {false, true}) {
+        MutexLimiter oldLimiter;
+        oldLimiter.update(limits);
+        MessageLimiter newLimiter;
+        newLimiter.update(limits);
+
+        std::uint64_t okOld = 0, okNew = 0;
+        double m = run(oldLimiter, threads, ops, many, okOld);
+        double f = run(newLimiter, threads, ops, many, okNew);
+        std::printf("%6s %14.0f/s %14.0f/s   (allowed %llu / %llu)\n", many ? "many" : "one", m, f, static_cast<unsigned long long>(okOld),
+                    static_cast<unsigned long long>(okNew));
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+// I/O 线程延迟基准：单个 I/O 线程上跑一个 1ms 周期的探测定时器（代表同一线程上其他连接的读写），
+// 同时以固定速率执行 CPU 密集的 handler 协程，对比
+//   1) inline ：重活直接在 I/O 线程上算
+//   2) offload：co_await pool.schedule() 切到线程池计算，算完 post 回 I/O 线程
+// 统计探测定时器的迟到时间（p50/p99/max）与完成的 handler 数。
+// 用法：offload_bench [seconds=2] [workUs=2000] [periodUs=5000] [poolThreads=2]
+
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace asio = boost::asio;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // 忙等模拟 CPU 密集计算
+    void burn(std::chrono::microseconds us) {
+        auto end = Clock::now() + us;
+        volatile std::uint64_t x = 0;
+        while (Clock::now() < end) {
+            x = x + 1;
+        }
+    }
+
+    struct Result {
+        double p50Us;
+        double p99Us;
+        double maxUs;
+        std::size_t handled;
+    };
+
+    Result run(bool offload, ThreadPool& pool, std::chrono::seconds duration, std::chrono::microseconds work, std::chrono::microseconds period) {
+        asio::io_context io;
+        std::vector<double> lateUs;
+        std::size_t handled = 0;
+        const auto stopAt = Clock::now() + duration;
+
+        // 探测：每 1ms 醒一次，记录相对预定时间的迟到
+        asio::co_spawn(
+            io,
+            [&]() -> asio::awaitable<void> {
+                asio::steady_timer timer(co_await asio::this_coro::executor);
+                auto due = Clock::now();
+                while (Clock::now() < stopAt) {
+                    due += std::chrono::milliseconds(1);
+                    timer.expires_at(due);
+                    co_await timer.async_wait(asio::use_awaitable);
+                    lateUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - due).count());
+                }
+            },
+            asio::detached);
+
+        // 负载：每 period 启动一个 handler
+        asio::co_spawn(
+            io,
+            [&]() -> asio::awaitable<void> {
+                auto ex = co_await asio::this_coro::executor;
+                asio::steady_timer timer(ex);
+                while (Clock::now() < stopAt) {
+                    asio::co_spawn(
+                        ex,
+                        [&, ex]() -> asio::awaitable<void> {
+                            if (offload) {
+                                co_await pool.schedule(asio::use_awaitable);
+                                burn(work);
+                                co_await asio::post(ex, asio::use_awaitable);
+                            } else {
+                                burn(work);
+                            }
+                            ++handled;  // 回到 I/O 线程后计数
+                        },
+                        asio::detached);
+                    timer.expires_after(period);
+                    co_await timer.async_wait(asio::use_awaitable);
+                }
+            },
+            asio::detached);
+
+        io.run();
+
+        std::sort(lateUs.begin(), lateUs.end());
+        auto pct = [&](double p) { return lateUs.empty() ? 0.0 : lateUs[std::min(lateUs.size() - 1, static_cast<std::size_t>(p * lateUs.size()))]; };
+        return {pct(0.50), pct(0.99), lateUs.empty() ? 0.0 : lateUs.back(), handled};
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::chrono::seconds duration(argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 2);
+    std::chrono::microseconds work(argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 2000);
+    std::chrono::microseconds period(argc > 3 ? std::strtoll(argv[3], nullptr, 10) : 5000);
+    std::size_t poolThreads = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 2;
+
+    ThreadPool pool(poolThreads);
+    std::printf("duration=%llds work=%lldus period=%lldus poolThreads=%zu\n", static_cast<long long>(duration.count()), static_cast<long long>(work.count()),
+                static_cast<long long>(period.count()), poolThreads);
+
+    auto in = run(false, pool, duration, work, period);
+    auto off = run(true, pool, duration, work, period);
+    std::printf("inline : probe late p50=%8.0fus p99=%8.0fus max=%8.0fus handled=%zu\n", in.p50Us, in.p99Us, in.maxUs, in.handled);
+    std::printf("offload: probe late p50=%8.0fus p99=%8.0fus max=%8.0fus handled=%zu\n", off.p50Us, off.p99Us, off.maxUs, off.handled);
+    return 0;
+}
@@ -0,0 +1,172 @@
+// 发送队列微基准：N 个生产者线程向同一连接发送小帧，统计每秒 send 次数。
+//   1) handoff：只比较交接机制本身——每帧 post 一个 lambda vs MpscQueue 入队 + 空闲时 post
+//   2) conn：真实 AsioConnection::sendBuffer 经回环 TCP 发出，对端线程读空统计
+// 用法：send_queue_bench [producers=4] [framesPerProducer=200000] [frameBytes=64]
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AsioConnection.h"
+#include "BufferPool.h"
+#include "MpscQueue.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double>(b - a).count(); }
+
+    template <typename Fn>
+    void runProducers(int producers, Fn&& fn) {
+        std::vector<std::thread> ts;
+        for (int p = 0; p < producers; ++p) {
+            ts.emplace_back([&fn, p] { fn(p); });
+        }
+        for (auto& t : ts) {
+            t.join();
+        }
+    }
+
+    // 旧路径：每帧一次 post（lambda 捕获 shared_ptr + buffer）
+    double benchPostPerFrame(int producers, std::size_t frames) {
+        boost::asio::io_context io;
+        auto guard = boost::asio::make_work_guard(io);
+        std::thread consumer([&] { io.run(); });
+
+        auto holder = std::make_shared<std::deque<BufferPool::Ptr>>();
+        std::atomic<std::size_t> consumed{0};
+        auto buf = BufferPool::Instance().acquire(64);
+
+        auto t0 = Clock::now();
+        runProducers(producers, [&](int) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                boost::asio::post(io, [holder, buf, &consumed] {
+                    holder->push_back(buf);
+                    holder->pop_front();
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+        while (consumed.load() < producers * frames) {
+            std::this_thread::yield();
+        }
+        double elapsed = seconds(t0, Clock::now());
+        guard.reset();
+        consumer.join();
+        return elapsed;
+    }
+
+    // 新路径：MpscQueue 入队，仅在消费者空闲时 post
+    double benchMpsc(int producers, std::size_t frames) {
+        boost::asio::io_context io;
+        auto guard = boost::asio::make_work_guard(io);
+        std::thread consumer([&] { io.run(); });
+
+        MpscQueue<BufferPool::Ptr> q;
+        std::atomic<bool> scheduled{false};
+        std::atomic<std::size_t> consumed{0};
+        auto buf = BufferPool::Instance().acquire(64);
+
+        std::function<void()> drain = [&] {
+            for (;;) {
+                BufferPool::Ptr b;
+                while (q.pop(b)) {
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                scheduled.store(false, std::memory_order_seq_cst);
+                if (q.empty() || scheduled.exchange(true, std::memory_order_seq_cst)) {
+                    return;
+                }
+            }
+        };
+
+        auto t0 = Clock::now();
+        runProducers(producers, [&](int) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                q.push(buf);
+                if (!scheduled.exchange(true, std::memory_order_seq_cst)) {
+                    boost::asio::post(io, drain);
+                }
+            }
+        });
+        while (consumed.load() < producers * frames) {
+            std::this_thread::yield();
+        }
+        double elapsed = seconds(t0, Clock::now());
+        guard.reset();
+        consumer.join();
+        return elapsed;
+    }
+
+    // 真实连接：sendBuffer -> 写协程 -> 回环 TCP -> 对端读空
+    double benchConnection(int producers, std::size_t frames, std::size_t frameBytes) {
+        using boost::asio::ip::tcp;
+        boost::asio::io_context io;
+        auto guard = boost::asio::make_work_guard(io);
+
+        tcp::acceptor acceptor(io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        tcp::socket client(io);
+        client.connect(acceptor.local_endpoint());
+        tcp::socket serverSock = acceptor.accept();
+
+        const std::size_t total = producers * frames * frameBytes;
+        auto conn = std::make_shared<AsioConnection>(io, std::move(serverSock), total * 2);
+        conn->start();
+        std::thread ioThread([&] { io.run(); });
+
+        std::atomic<bool> drained{false};
+        Clock::time_point drainedAt;
+        std::thread reader([&] {
+            std::vector<char> sink(256 * 1024);
+            std::size_t got = 0;
+            boost::system::error_code ec;
+            while (got < total && !ec) {
+                got += client.read_some(boost::asio::buffer(sink), ec);
+            }
+            drainedAt = Clock::now();
+            drained.store(true);
+        });
+
+        std::string payload(frameBytes, 'x');
+        auto t0 = Clock::now();
+        runProducers(producers, [&](int) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                auto b = BufferPool::Instance().acquire(frameBytes);
+                b->append(payload.data(), payload.size());
+                conn->sendBuffer(b);
+            }
+        });
+        reader.join();
+
+        conn->close();
+        guard.reset();
+        io.stop();
+        ioThread.join();
+        return seconds(t0, drainedAt);
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    int producers = argc > 1 ? std::atoi(argv[1]) : 4;
+    std::size_t frames = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    std::size_t frameBytes = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    const double n = static_cast<double>(producers) * frames;
+
+    std::printf("producers=%d framesPerProducer=%zu frameBytes=%zu\n", producers, frames, frameBytes);
+
+    double tPost = benchPostPerFrame(producers, frames);
+    double tMpsc = benchMpsc(producers, frames);
+    std::printf("handoff  post-per-frame : %10.0f sends/s\n", n / tPost);
+    std::printf("handoff  mpsc+idle-post : %10.0f sends/s\n", n / tMpsc);
+
+    double tConn = benchConnection(producers, frames, frameBytes);
+    std::printf("conn     sendBuffer     : %10.0f sends/s (%.1f MB/s)\n", n / tConn, n * frameBytes / tConn / 1e6);
+    return 0;
+}
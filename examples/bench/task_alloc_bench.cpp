@@ -0,0 +1,168 @@
+// 线程池投递路径的堆分配基准：计数版 operator new 统计稳态下每帧的分配次数与吞吐，对比
+//   1) submit   ：packaged_task + future（shared_ptr 控制块、共享状态、包装闭包），闭包模拟 weak_ptr<连接> + msgType + FrameBody
+//   2) post     ：同一闭包经 Task 小缓冲内联存储，不创建 future
+//   3) FrameJob ：InitServer 实际投递的单帧任务（frameBatchSize = 1），真实 AsioConnection 的 weak_ptr + RoutedFrame
+//   4) BatchJob ：InitServer 实际投递的多帧任务（FrameBatchJob，每任务 batch 帧，分配摊到每帧）
+// 3/4 只测投递与任务执行本身：FrameRunner 换成计数桩，不启动 handler 协程。
+// 用法：task_alloc_bench [tasks=1000000] [threads=4] [batch=8]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "AsioConnection.h"
+#include "FrameBody.h"
+#include "FrameJob.h"
+#include "ThreadPool.h"
+
+namespace {
+    std::atomic<std::uint64_t> g_allocs{0};
+}
+
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        double perSec;
+        double allocsPerTask;
+    };
+
+    // 与 InitServer::runFrames/dropFrames 的入口一致，只计数
+    class CountingRunner : public FrameRunner {
+      public:
+        explicit CountingRunner(std::atomic<std::uint64_t>& done) : done_(done) {}
+
+        void runFrames(const std::weak_ptr<AsioConnection>& conn, ThreadPool&, RoutedFrame* frames, std::size_t n) override {
+            if (auto c = conn.lock()) {
+                std::size_t bytes = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    bytes += frames[i].body.size() + frames[i].msgType;
+                }
+                volatile std::size_t sink = bytes;
+                (void)sink;
+            }
+            done_.fetch_add(n, std::memory_order_relaxed);
+        }
+        void dropFrames(RoutedFrame*, std::size_t n) noexcept override { done_.fetch_add(n, std::memory_order_relaxed); }
+
+      private:
+        std::atomic<std::uint64_t>& done_;
+    };
+
+    // 与 InitServer::submitFrame/submitFrames 相同的投递：单帧进 FrameJob，多帧进 FrameBatchJob
+    Result runFrames(ThreadPool& pool, std::size_t batch, std::size_t frames, const ConnectionPtr& conn, const FrameBody& body) {
+        constexpr std::size_t kWindow = 1024;
+        std::atomic<std::uint64_t> done{0};
+        CountingRunner runner(done);
+        std::weak_ptr<AsioConnection> weak = conn;
+
+        auto t0 = Clock::now();
+        std::uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < frames; i += batch) {
+            while (i - done.load(std::memory_order_relaxed) >= kWindow) {
+                std::this_thread::yield();
+            }
+            auto make = [&](std::size_t k) {
+                return RoutedFrame{.body = body, .ordering = nullptr, .seq = 0, .msgType = static_cast<std::uint16_t>(i + k), .strict = false};
+            };
+            if (batch == 1) {
+                pool.post(FrameJob(runner, pool, weak, make(0)));
+            } else {
+                std::vector<RoutedFrame> chunk;
+                chunk.reserve(batch);
+                for (std::size_t k = 0; k < batch; ++k) {
+                    chunk.push_back(make(k));
+                }
+                pool.post(FrameBatchJob(runner, pool, weak, std::move(chunk)));
+            }
+        }
+        const std::size_t total = (frames + batch - 1) / batch * batch;
+        while (done.load(std::memory_order_relaxed) < total) {
+            std::this_thread::yield();
+        }
+        std::uint64_t a1 = g_allocs.load(std::memory_order_relaxed);
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        return {total / secs, static_cast<double>(a1 - a0) / total};
+    }
+
+    // mode 0 = submit，1 = post；window 控制在途任务数，让队列容量在预热后稳定
+    Result run(ThreadPool& pool, int mode, std::size_t tasks, const std::shared_ptr<int>& conn, const FrameBody& body) {
+        constexpr std::size_t kWindow = 1024;
+        std::atomic<std::uint64_t> done{0};
+        std::weak_ptr<int> weak = conn;
+
+        auto t0 = Clock::now();
+        std::uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < tasks; ++i) {
+            while (i - done.load(std::memory_order_relaxed) >= kWindow) {
+                std::this_thread::yield();
+            }
+            auto task = [weak, msgType = static_cast<std::uint16_t>(i), body, &done] {
+                if (auto c = weak.lock()) {
+                    volatile std::size_t sink = body.size() + msgType + static_cast<std::size_t>(*c);
+                    (void)sink;
+                }
+                done.fetch_add(1, std::memory_order_relaxed);
+            };
+            if (mode == 0) {
+                pool.submit(std::move(task));
+            } else {
+                pool.post(std::move(task));
+            }
+        }
+        while (done.load(std::memory_order_relaxed) < tasks) {
+            std::this_thread::yield();
+        }
+        std::uint64_t a1 = g_allocs.load(std::memory_order_relaxed);
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        return {tasks / secs, static_cast<double>(a1 - a0) / tasks};
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    std::size_t batch = argc > 3 ? std::max<std::size_t>(2, std::strtoull(argv[3], nullptr, 10)) : 8;
+
+    ThreadPool pool(threads);
+    auto conn = std::make_shared<int>(1);
+    FrameBody body = FrameBody::copyOf(std::string(600, 'x'));
+
+    // 真实连接对象（未连接的 socket，不启动读写），任务里持有的是它的 weak_ptr
+    boost::asio::io_context io;
+    auto realConn = std::make_shared<AsioConnection>(io, boost::asio::ip::tcp::socket(io));
+
+    // 预热：让各线程的环形队列、窃取暂存区涨到稳态容量
+    run(pool, 0, 100000, conn, body);
+    run(pool, 1, 100000, conn, body);
+    runFrames(pool, 1, 100000, realConn, body);
+    runFrames(pool, batch, 100000, realConn, body);
+
+    auto s = run(pool, 0, tasks, conn, body);
+    auto p = run(pool, 1, tasks, conn, body);
+    auto f = runFrames(pool, 1, tasks, realConn, body);
+    auto b = runFrames(pool, batch, tasks, realConn, body);
+    std::printf("tasks=%zu threads=%zu sizeof(Task)=%zu sizeof(FrameJob)=%zu sizeof(FrameBatchJob)=%zu\n", tasks, threads, sizeof(Task), sizeof(FrameJob),
+                sizeof(FrameBatchJob));
+    std::printf("submit (future): %10.0f tasks/s   %5.2f allocs/task\n", s.perSec, s.allocsPerTask);
+    std::printf("post           : %10.0f tasks/s   %5.2f allocs/task\n", p.perSec, p.allocsPerTask);
+    std::printf("FrameJob       : %10.0f frames/s  %5.2f allocs/frame\n", f.perSec, f.allocsPerTask);
+    std::printf("FrameBatchJob  : %10.0f frames/s  %5.2f allocs/frame (batch=%zu)\n", b.perSec, b.allocsPerTask, batch);
+    return 0;
+}
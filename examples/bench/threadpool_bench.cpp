@@ -0,0 +1,168 @@
+// 线程池扩展性微基准：线程数 1 -> 64，对比
+//   1) mutex  ：旧实现（三条优先级队列 + 一把 mutex + 一个 condition_variable，提交/取任务全池串行）
+//   2) stealing：ThreadPool（每线程本地队列 + 随机窃取，只有休眠/唤醒走全局锁）
+// 两种负载：
+//   external：producers 个外部线程（模拟 I/O 线程）持续提交小任务
+//   fanout  ：每个根任务在池内再提交 fanout 个子任务（池内提交进本地队列）
+// 统计每秒完成的任务数。
+// 用法：threadpool_bench [tasksPerRun=400000] [producers=4] [maxThreads=64]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // 旧 ThreadPool 的提交/取任务路径（去掉伸缩与过载策略），作为对照组
+    class MutexPool {
+      public:
+        explicit MutexPool(std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                workers_.emplace_back([this] { loop(); });
+            }
+        }
+
+        ~MutexPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            for (auto& t : workers_) {
+                t.join();
+            }
+        }
+
+        template <typename F>
+        std::future<void> submit(F&& f) {
+            auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+            auto fut = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                normalQ_.emplace([task] { (*task)(); });
+                ++total_;
+                MetricsRegistry::Instance().workerQueueSize().inc();
+            }
+            cv_.notify_one();
+            return fut;
+        }
+
+      private:
+        void loop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this] { return stopping_ || total_ > 0; });
+                    if (stopping_ && total_ == 0) {
+                        return;
+                    }
+                    auto& q = !highQ_.empty() ? highQ_ : (!normalQ_.empty() ? normalQ_ : lowQ_);
+                    task = std::move(q.front());
+                    q.pop();
+                    --total_;
+                    MetricsRegistry::Instance().workerQueueSize().inc(-1);
+                }
+                task();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::queue<std::function<void()>> highQ_, normalQ_, lowQ_;
+        std::size_t total_{0};
+        bool stopping_{false};
+        std::vector<std::thread> workers_;
+    };
+
+    // 任务本身只做一点计算，突出调度开销
+    void work(std::atomic<std::uint64_t>& done) {
+        volatile std::uint64_t x = 0;
+        for (int i = 0; i < 64; ++i) {
+            x = x + i;
+        }
+        done.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void waitDone(const std::atomic<std::uint64_t>& done, std::uint64_t total) {
+        while (done.load(std::memory_order_relaxed) < total) {
+            std::this_thread::yield();
+        }
+    }
+
+    template <typename Pool>
+    double runExternal(Pool& pool, std::size_t tasks, std::size_t producers) {
+        std::atomic<std::uint64_t> done{0};
+        const std::size_t perProducer = tasks / producers;
+        auto t0 = Clock::now();
+        std::vector<std::thread> ps;
+        for (std::size_t p = 0; p < producers; ++p) {
+            ps.emplace_back([&] {
+                for (std::size_t i = 0; i < perProducer; ++i) {
+                    pool.submit([&done] { work(done); });
+                }
+            });
+        }
+        for (auto& t : ps) {
+            t.join();
+        }
+        waitDone(done, perProducer * producers);
+        return perProducer * producers / std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    template <typename Pool>
+    double runFanout(Pool& pool, std::size_t tasks) {
+        constexpr std::size_t kFanout = 16;
+        std::atomic<std::uint64_t> done{0};
+        const std::size_t roots = tasks / (kFanout + 1);
+        auto t0 = Clock::now();
+        for (std::size_t r = 0; r < roots; ++r) {
+            pool.submit([&pool, &done] {
+                for (std::size_t i = 0; i < kFanout; ++i) {
+                    pool.submit([&done] { work(done); });
+                }
+                work(done);
+            });
+        }
+        waitDone(done, roots * (kFanout + 1));
+        return roots * (kFanout + 1) / std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 400000;
+    std::size_t producers = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+    std::size_t maxThreads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    if (producers == 0) {
+        producers = 1;
+    }
+
+    std::printf("tasks=%zu producers=%zu hardware_concurrency=%u\n", tasks, producers, std::thread::hardware_concurrency());
+    std::printf("%8s %16s %16s %16s %16s\n", "threads", "external/mutex", "external/steal", "fanout/mutex", "fanout/steal");
+    for (std::size_t n = 1; n <= maxThreads; n *= 2) {
+        double em, es, fm, fs;
+        {
+            MutexPool pool(n);
+            em = runExternal(pool, tasks, producers);
+            fm = runFanout(pool, tasks);
+        }
+        {
+            ThreadPool pool(n);
+            es = runExternal(pool, tasks, producers);
+            fs = runFanout(pool, tasks);
+        }
+        std::printf("%8zu %14.0f/s %14.0f/s %14.0f/s %14.0f/s\n", n, em, es, fm, fs);
+    }
+    return 0;
+}
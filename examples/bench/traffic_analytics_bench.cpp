@@ -0,0 +1,133 @@
+// TrafficAnalytics 基准：ips 个源 IP、每 IP 若干会话，按 Zipf(s) 分布产生 records 次“一次读取”（每次 1~8 帧），对比
+//   1) exact：unordered_map 精确计数（内存随键数增长，即现在按 IP 建表的做法）
+//   2) sketch：TrafficAnalytics（SpaceSaving + Count-Min + HyperLogLog，固定内存）
+// 统计每次 record 的平均耗时、Top-K 召回率与计数相对误差、去重数估计误差。
+// 用法：traffic_analytics_bench [ips=200000] [records=5000000] [zipf=1.1]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Config.h"
+#include "TrafficAnalytics.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::uint32_t ip;
+        std::uint32_t session;
+        std::uint32_t frames;
+        std::uint64_t bytes;
+    };
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::size_t ips = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::size_t records = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000000;
+    double s = argc > 3 ? std::strtod(argv[3], nullptr) : 1.1;
+
+    std::mt19937_64 rng(7);
+    std::vector<IpKey> keys;
+    std::vector<std::string> texts;
+    keys.reserve(ips);
+    for (std::size_t i = 0; i < ips; ++i) {
+        std::string text = "10." + std::to_string((i >> 16) & 0xff) + "." + std::to_string((i >> 8) & 0xff) + "." + std::to_string(i & 0xff);
+        keys.push_back(*IpKey::Parse(text));
+        texts.push_back(std::move(text));
+    }
+    // 每个 IP 4 个会话
+    std::vector<std::string> sessions;
+    for (std::size_t i = 0; i < ips * 4; ++i) {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%08x-0000-4000-8000-%012zx", static_cast<unsigned>(rng()), i);
+        sessions.emplace_back(buf);
+    }
+
+    // Zipf 分布按累计权重二分抽样
+    std::vector<double> cdf(ips);
+    double acc = 0.0;
+    for (std::size_t i = 0; i < ips; ++i) {
+        acc += 1.0 / std::pow(static_cast<double>(i + 1), s);
+        cdf[i] = acc;
+    }
+    std::uniform_real_distribution<double> uni(0.0, acc);
+    std::vector<Event> events(records);
+    for (auto& e : events) {
+        e.ip = static_cast<std::uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), uni(rng)) - cdf.begin());
+        e.session = e.ip * 4 + static_cast<std::uint32_t>(rng() % 4);
+        e.frames = 1 + static_cast<std::uint32_t>(rng() % 8);
+        e.bytes = e.frames * (64 + rng() % 1024);
+    }
+
+    // 1) 精确计数
+    struct Exact {
+        std::uint64_t frames{0};
+        std::uint64_t bytes{0};
+    };
+    std::unordered_map<std::string, Exact> exactIps;
+    std::unordered_map<std::string, Exact> exactSessions;
+    auto t0 = Clock::now();
+    for (const auto& e : events) {
+        auto& a = exactIps[texts[e.ip]];
+        a.frames += e.frames;
+        a.bytes += e.bytes;
+        auto& b = exactSessions[sessions[e.session]];
+        b.frames += e.frames;
+        b.bytes += e.bytes;
+    }
+    double exactNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / records;
+
+    // 2) 草图（固定在同一分钟）
+    AnalyticsConfig cfg;
+    TrafficAnalytics::Instance().configure(cfg);
+    const std::int64_t minute = TrafficAnalytics::MinuteNow();
+    t0 = Clock::now();
+    for (const auto& e : events) {
+        TrafficAnalytics::Instance().recordAt(minute, keys[e.ip], sessions[e.session], e.frames, e.bytes);
+    }
+    double sketchNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / records;
+    auto report = TrafficAnalytics::Instance().report(minute);
+
+    // 与精确结果对比：Top-K 召回率与榜单内的最大相对误差
+    auto compare = [&](const char* name, const std::vector<TrafficAnalytics::HeavyHitter>& got, const std::unordered_map<std::string, Exact>& exact,
+                       bool bytes) {
+        std::vector<std::pair<std::uint64_t, std::string>> truth;
+        for (const auto& [k, v] : exact) {
+            truth.emplace_back(bytes ? v.bytes : v.frames, k);
+        }
+        std::size_t k = std::min(got.size(), truth.size());
+        std::partial_sort(truth.begin(), truth.begin() + static_cast<std::ptrdiff_t>(k), truth.end(), std::greater<>());
+        std::unordered_set<std::string> top;
+        for (std::size_t i = 0; i < k; ++i) {
+            top.insert(truth[i].second);
+        }
+        std::size_t hit = 0;
+        double maxErr = 0.0;
+        for (const auto& h : got) {
+            hit += top.count(h.key);
+            double real = static_cast<double>(bytes ? exact.at(h.key).bytes : exact.at(h.key).frames);
+            maxErr = std::max(maxErr, (static_cast<double>(h.estimate) - real) / real);
+        }
+        std::printf("  %-20s recall %zu/%zu  max rel err %.4f%%\n", name, hit, k, maxErr * 100);
+    };
+
+    std::printf("ips=%zu sessions=%zu records=%zu zipf=%.2f topK=%zu capacity=%zu hllPrecision=%u\n", ips, sessions.size(), records, s, cfg.topK,
+                cfg.capacity, cfg.hllPrecision);
+    std::printf("exact : %8.1f ns/record  keys=%zu\n", exactNs, exactIps.size() + exactSessions.size());
+    std::printf("sketch: %8.1f ns/record\n", sketchNs);
+    compare("ips by frames", report.ipsByFrames, exactIps, false);
+    compare("ips by bytes", report.ipsByBytes, exactIps, true);
+    compare("sessions by frames", report.sessionsByFrames, exactSessions, false);
+    compare("sessions by bytes", report.sessionsByBytes, exactSessions, true);
+    std::printf("  unique ips      %zu ~ %llu\n", exactIps.size(), static_cast<unsigned long long>(report.uniqueIps));
+    std::printf("  unique sessions %zu ~ %llu\n", exactSessions.size(), static_cast<unsigned long long>(report.uniqueSessions));
+    return 0;
+}
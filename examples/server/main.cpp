@@ -6,9 +6,10 @@
 #include "Config.h"
 #include "CrashHandler.h"
 #include "InitServer.h"
+#include "IoBackend.h"
 #include "Logging.h"
 
-int main() {
+int main(int /*argc*/, char** argv) {
     CrashHandler::init();
 
     //  加载 Lua 配置
@@ -18,6 +19,12 @@ int main() {
     }
     Logging::InitFromConfig();
 
+    // 必须在创建任何 io_context 之前确认 socket 后端可用（可能 exec 到另一构建）
+    if (!IoBackend::select(cfg.server(), argv)) {
+        Logging::shutdown();
+        return 1;
+    }
+
     const auto& sc = cfg.server();
 
     try {
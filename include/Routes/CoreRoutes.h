@@ -2,28 +2,73 @@
 
 #include "Codec.h"
 #include "RouteRegistry.h"
+#include "ThreadPool.h"
 #include <boost/asio/awaitable.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <cstdio>
 
 enum : std::uint16_t {
     MSG_HEARTBEAT = 1,
     MSG_ECHO = 2,
     MSG_JSON_ECHO = 3,
     MSG_PROTO_PING = 4,
+    MSG_UPLOAD = 5,
+    MSG_DIGEST = 6,
 };
 
 namespace CoreRoutes {
-    inline void Register(RouteRegistry& registry) {
-        // 心跳
-        registry.add(MSG_HEARTBEAT, "heartbeat", [](const ConnectionPtr& /*conn*/, std::string_view /*body*/) -> boost::asio::awaitable<void> {
-            co_return;
-        });
+    // offloadPool：CPU 密集示例路由切过去做重活的线程池
+    inline void Register(RouteRegistry& registry, std::shared_ptr<ThreadPool> offloadPool) {
+        // 心跳（极轻，直接在 I/O strand 上执行）
+        registry.add(
+            MSG_HEARTBEAT, "heartbeat", [](const ConnectionPtr& /*conn*/, std::string_view /*body*/) -> boost::asio::awaitable<void> { co_return; }, RoutePolicy::Inline);
+
+        // echo（极轻，直接在 I/O strand 上执行）
+        registry.add(
+            MSG_ECHO, "echo",
+            [](const ConnectionPtr& conn, std::string_view body) -> boost::asio::awaitable<void> {
+                std::string resp = "echo";
+                resp.append(body);
+                LengthHeaderCodec::send(conn, MSG_ECHO, resp);
+                co_return;
+            },
+            RoutePolicy::Inline);
+
+        // 卸载示例：handler 在 I/O strand 上开始，CPU 密集部分切到线程池，算完切回 strand 发送，
+        // 期间 strand 上的其他连接不受影响（offload 只对 Inline 路由有意义，线程池路由本就在池线程上执行）
+        registry.add(
+            MSG_DIGEST, "digest",
+            [pool = std::move(offloadPool)](const ConnectionPtr& conn, std::string_view body) -> boost::asio::awaitable<void> {
+                auto strand = co_await boost::asio::this_coro::executor;
+                std::string data(body);
+
+                co_await pool->schedule(boost::asio::use_awaitable);
+                // 多轮 FNV-1a，模拟 CPU 密集计算
+                std::uint64_t h = 1469598103934665603ULL;
+                for (int round = 0; round < 1000; ++round) {
+                    for (unsigned char c : data) {
+                        h = (h ^ c) * 1099511628211ULL;
+                    }
+                }
+
+                co_await boost::asio::post(strand, boost::asio::use_awaitable);
+                char hex[17];
+                std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+                LengthHeaderCodec::send(conn, MSG_DIGEST, hex);
+            },
+            RoutePolicy::Inline);
 
-        // echo
-        registry.add(MSG_ECHO, "echo", [](const ConnectionPtr& conn, std::string_view body) -> boost::asio::awaitable<void> {
-            std::string resp = "echo";
-            resp.append(body);
-            LengthHeaderCodec::send(conn, MSG_ECHO, resp);
-            co_return;
+        // 流式上传示例：逐块读取 body，只统计字节数，收完后回复总长度
+        registry.addStream(MSG_UPLOAD, "upload", [](const ConnectionPtr& conn, FrameStreamPtr stream) -> boost::asio::awaitable<void> {
+            std::uint64_t received = 0;
+            while (auto chunk = co_await stream->next()) {
+                received += chunk->size();
+            }
+            if (!stream->aborted()) {
+                LengthHeaderCodec::send(conn, MSG_UPLOAD, std::to_string(received));
+            }
         });
     }
 }  // namespace CoreRoutes
@@ -12,17 +12,34 @@ struct RouteEntry {
     std::uint16_t msgType;
     std::string name;
     CoMessageHandler handler;
+    RoutePolicy policy{RoutePolicy::Worker};  // 默认执行位置，可被 config.lua 的 routes 覆盖
+    std::string pool;                          // Dedicated 时的独立线程池名
+};
+
+struct StreamRouteEntry {
+    std::uint16_t msgType;
+    std::string name;
+    CoStreamHandler handler;
 };
 
 class RouteRegistry {
   public:
-    void add(std::uint16_t msgType, std::string name, CoMessageHandler handler) {
-        entries_.push_back({msgType, std::move(name), std::move(handler)});
+    void add(std::uint16_t msgType, std::string name, CoMessageHandler handler, RoutePolicy policy = RoutePolicy::Worker, std::string pool = {}) {
+        entries_.push_back({msgType, std::move(name), std::move(handler), policy, std::move(pool)});
+    }
+
+    // 流式路由（大 body 分块交给 handler，见 FrameStream）
+    void addStream(std::uint16_t msgType, std::string name, CoStreamHandler handler) {
+        streamEntries_.push_back({msgType, std::move(name), std::move(handler)});
     }
 
     void applyTo(MessageRouter& router) const {
         for (auto& e : entries_) {
             router.registerHandler(e.msgType, e.handler);
+            router.setRoutePolicy(e.msgType, e.policy, e.pool);
+        }
+        for (auto& e : streamEntries_) {
+            router.registerStream(e.msgType, e.handler);
         }
     }
 
@@ -30,4 +47,5 @@ class RouteRegistry {
 
   private:
     std::vector<RouteEntry> entries_;
+    std::vector<StreamRouteEntry> streamEntries_;
 };
@@ -9,20 +9,24 @@
 #include <deque>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <random>
 #include <string_view>
 
 #include "Buffer.h"
 #include "IpLimiter.h"
+#include "MpscQueue.h"
 #include "ThreadPool.h"
 
 class AsioConnection;
+class ConnectionOrdering;
 using ConnectionPtr = std::shared_ptr<AsioConnection>;
 
 /**
  * @brief 单 TCP 连接封装。
  * @details 负责异步读写、发送队列管理、小包合并与背压水位控制、最近活动时间记录。
- *          线程安全性：对外暴露的 send/touch 等可跨线程调用，内部通过 io_context 串行执行读写。
+ *          线程安全性：对外暴露的 send/touch 等可跨线程调用；发送经无锁 MPSC 队列交给写协程，
+ *          仅在写协程空闲时 post 一次唤醒，读写本身在连接 executor 上串行执行。
  */
 class AsioConnection : public std::enable_shared_from_this<AsioConnection> {
   public:
@@ -31,6 +35,9 @@ class AsioConnection : public std::enable_shared_from_this<AsioConnection> {
     using MessageCallback = std::function<void(const ConnectionPtr&, Buffer&)>;
     using CloseCallback = std::function<void(const ConnectionPtr&)>;
 
+    // 写合并时的 cork 策略
+    enum class CorkMode { Off, MsgMore, Cork };
+
     explicit AsioConnection(boost::asio::io_context& io_context, tcp::socket socket, size_t maxSendBufferBytes = 4 * 1024 * 1024);
 
     // 启动读写循环。
@@ -49,6 +56,14 @@ class AsioConnection : public std::enable_shared_from_this<AsioConnection> {
     void setMessageCallback(MessageCallback cb);
     // 设置关闭回调。
     void setCloseCallback(CloseCallback cb);
+    // 设置零拷贝发送阈值（字节，0 关闭），需在 start() 之前调用。
+    void setZeroCopyThreshold(std::size_t bytes);
+    // 设置自适应读缓冲参数，需在 start() 之前调用。releaseIdleAfter > 0 时连续这么多次读空才归还读缓冲，0 不归还。
+    void setReadBufferLimits(std::size_t minBytes, std::size_t maxBytes, std::uint32_t releaseIdleAfter);
+    // 设置写合并参数，需在 start() 之前调用。
+    void setWriteCoalescing(std::size_t maxFrames, std::size_t maxBytes, CorkMode cork, bool flushOnReadEnd);
+    // 由 Codec 在 I/O 线程上告知当前帧还差多少字节（0 表示没有半包），下一次读取按此一次读满。
+    void setReadHint(std::size_t pendingBytes);
 
     tcp::socket& socket();
 
@@ -58,44 +73,112 @@ class AsioConnection : public std::enable_shared_from_this<AsioConnection> {
     std::uint64_t lastActiveMs() const;
     // 远端 IP（缓存）。
     std::string remoteIp() const;
+    // 远端 IP 的二进制键（取不到远端地址时为空），供按 IP 限流/统计使用，避免逐帧拷贝字符串
+    const std::optional<IpKey>& remoteIpKey() const { return remoteIpKey_; }
+    // 远端 IP 命中 IpAcl 的 allow 规则：不受 IpLimiter 的连接数/QPS 限制（accept 时、start 之前设置）
+    void setIpTrusted(bool trusted) { ipTrusted_ = trusted; }
+    bool ipTrusted() const { return ipTrusted_; }
     // 会话 ID（用于日志追踪）。
-    std::string sessionId() const;
+    const std::string& sessionId() const;
     // traceId（默认等于 sessionId，可被上游覆盖）。
     std::string traceId() const;
     // 是否处于背压暂停读
     bool isReadPaused() const;
+    // 当前读缓冲（仅在消息回调内、I/O 线程上使用）。Codec 据此让帧 body 直接引用读缓冲。
+    const BufferPool::Ptr& readBufferOwner() const;
+    // 上层流控：holdRead 暂停读，直到对应次数的 releaseRead（与发送背压相互独立，可跨线程调用）。
+    void holdRead();
+    void releaseRead();
+    // Codec 私有的每连接状态（仅在连接 executor 上访问）。
+    std::shared_ptr<void>& codecState();
+    // 顺序控制状态（见 ReplySequencer.h）：首帧时在 I/O 线程上创建，此后不再替换，handler 中可读取以切换连接级模式。
+    std::shared_ptr<ConnectionOrdering>& orderingState();
 
   private:
     // 异步读循环（协程）。
     boost::asio::awaitable<void> readLoop();
     // 异步写循环（协程，含小包合并/背压）。
     boost::asio::awaitable<void> writeLoop();
+    // 写协程未运行时启动写协程（在连接 executor 上调用）。
+    void startWriteLoop();
+    // 发送队列降到低水位以下时恢复读（在连接 executor 上调用）。
+    void resumeReadIfDrained();
+    // 发送一批缓冲（flags 非 0 时逐次 async_send 直到写完）。
+    boost::asio::awaitable<void> writeBatch(std::vector<boost::asio::const_buffer>& bufs, int flags);
+    // 设置 TCP_CORK。
+    void setCork(bool on);
+    // 以 MSG_ZEROCOPY 发送单个大帧，缓冲挂入 zcPending_ 直到内核完成通知。
+    boost::asio::awaitable<void> sendZeroCopy(const BufferPool::Ptr& buf);
+    // 非阻塞读取错误队列中的零拷贝完成通知，释放对应缓冲。
+    void reapZeroCopy();
+    // 仍有未完成的零拷贝发送时，定时收割完成通知（协程）。
+    boost::asio::awaitable<void> zeroCopyReapLoop();
+    // 关闭前等待零拷贝缓冲被内核释放（协程）。
+    boost::asio::awaitable<void> drainZeroCopyAndClose();
+    // 根据上一次读取的字节数调整下一次读取大小。
+    void adaptReadSize(std::size_t lastRead);
+    // 发送完成后的统计与背压恢复。
+    void onBytesSent(std::size_t bytes);
     // 关闭处理。
     void handleClose();
 
   private:
+    static constexpr std::size_t kMaxHintRead = 4 * 1024 * 1024;  // 按帧长一次读取的上限，防止伪造超大长度
+    static constexpr std::uint32_t kShrinkAfterSmallReads = 8;    // 连续多少次小读后收缩
+
     boost::asio::io_context& io_context_;  // I/O 上下文
     boost::asio::ip::tcp::socket socket_;  // 套接字
     boost::asio::steady_timer pauseTimer_; // 背压等待唤醒定时器
 
-    BufferPool::Ptr readBuf_;  // 读缓冲
+    BufferPool::Ptr readBuf_;  // 读缓冲（空闲时可能为空，见 releaseIdleAfter_）
+
+    // 自适应读取：无帧长提示时按 readSize_ 读取，读满则翻倍、连续小读则减半
+    std::size_t readSizeMin_{1024};
+    std::size_t readSizeMax_{64 * 1024};
+    std::size_t readSize_{4096};
+    std::size_t readHint_{0};       // Codec 告知的当前帧剩余字节
+    std::uint32_t smallReads_{0};   // 连续小读次数
+    std::uint32_t releaseIdleAfter_{0};  // 连续读空多少次后归还读缓冲，0 不归还
+    std::uint32_t idleReads_{0};    // 连续读空（没读满且缓冲已处理完）次数
     std::atomic<bool> readPaused_{false};   // 背压暂停读标记
+    std::atomic<std::uint32_t> readHolds_{0};  // 上层流控暂停读计数（见 holdRead）
+    std::shared_ptr<void> codecState_;      // Codec 每连接状态（如进行中的流式帧）
+    std::shared_ptr<ConnectionOrdering> ordering_;  // 每连接顺序控制（见 orderingState）
 
     std::size_t highWatermark_{0};  // 发送队列高水位（暂停读）
     std::size_t lowWatermark_{0};   // 发送队列低水位（恢复读）
 
-    std::deque<BufferPool::Ptr> sendQueue_;  // 待发送队列
-    std::size_t sendQueueBytes_{0};          // 待发送字节总量
+    MpscQueue<BufferPool::Ptr> incoming_;            // 生产者无锁入队，任意线程
+    std::atomic<bool> writerScheduled_{false};       // 写协程已调度/运行中，生产者无需再 post
+    std::deque<BufferPool::Ptr> sendQueue_;          // 写协程私有的待发送队列
+    std::atomic<std::size_t> sendQueueBytes_{0};     // 待发送字节总量（含 incoming_，入队前记账）
 
     MessageCallback messageCallback_;  // 消息回调
     CloseCallback closeCallback_;      // 关闭回调
 
-    bool closing_{false};   // 是否正在关闭
+    // 写合并
+    std::size_t writeMaxFrames_{64};         // 单次写最多合并帧数
+    std::size_t writeMaxBytes_{256 * 1024};  // 单次写最多合并字节数
+    CorkMode corkMode_{CorkMode::Off};       // cork 策略
+    bool corked_{false};                     // 当前是否已 TCP_CORK
+    bool flushOnReadEnd_{false};             // 读处理期间推迟启动写协程
+
+    std::atomic<bool> closing_{false};  // 是否正在关闭
     bool writing_{false};   // 是否正在写
     size_t maxSendBuf_{0};  // 单连接发送缓冲上限
 
+    // MSG_ZEROCOPY：内核按 send 调用顺序分配 32 位序号，完成通知以 [lo, hi] 区间返回
+    std::size_t zeroCopyThreshold_{0};                            // 零拷贝阈值，0 表示关闭
+    bool zeroCopyEnabled_{false};                                 // SO_ZEROCOPY 是否已生效
+    std::uint32_t zcNextSeq_{0};                                  // 下一次 send 的通知序号
+    std::deque<std::pair<std::uint32_t, BufferPool::Ptr>> zcPending_;  // 等待完成通知的缓冲
+    bool zcReaping_{false};                                       // 收割协程是否在运行
+    boost::asio::steady_timer zcTimer_;                           // 收割轮询定时器
+
     std::atomic<std::uint64_t> lastActiveMs_{0};  // 最近活动时间
     std::string remoteIp_;                        // 缓存远端 IP
+    std::optional<IpKey> remoteIpKey_;            // 缓存远端 IP 的二进制键
+    bool ipTrusted_{false};                       // 是否为可信 IP（IpAcl allow）
     std::string sessionId_;                       // 会话 ID
     std::string traceId_;                         // Trace ID（默认=sessionId）
 };
@@ -20,6 +20,9 @@
  * @details 负责监听、连接接入/移除、闲置连接回收、指标定时上报，以及 I/O 线程生命周期管理。
  *          线程安全性：公共 API（run/stop/stopAccept/closeAllConnections/set callbacks）可从外部线程调用，
  *          通过 io_context 保证事件串行；内部状态修改集中在 I/O 线程。
+ *          I/O 模型：默认所有 I/O 线程共享一个 io_context，每个连接一个 strand；
+ *          开启 server.shardedIo 后每个 I/O 线程独占一个 io_context（可绑核），
+ *          新连接按 roundRobin/leastConn 选择分片，并终生停留在该分片上。
  */
 class AsioServer {
   public:
@@ -48,24 +51,62 @@ class AsioServer {
     // 当前活跃连接数。
     std::size_t connectionCount() const;
 
-    // 暴露 io_context 供外部组件使用。
+    // 暴露 io_context 供外部组件使用（分片模式下为 0 号分片，承载 acceptor 与定时器）。
     boost::asio::io_context& ioContext();
+    // 分片数量（非分片模式为 1）。
+    std::size_t shardCount() const;
+    // 第 idx 个分片的 io_context。
+    boost::asio::io_context& ioContext(std::size_t idx);
 
     // 是否还在接受新连接。
     bool isAccepting() const;
 
   private:
-    // 异步接受新连接（协程入口）。
+    // 单个 I/O 分片：io_context + 当前承载的连接数（leastConn 策略使用）
+    struct IoShard {
+        boost::asio::io_context* io{nullptr};
+        std::atomic<std::size_t> connections{0};
+    };
+
+    // 单个监听 socket（reusePort 时有多个）：所在分片 + 接入统计
+    struct Listener {
+        std::unique_ptr<tcp::acceptor> acceptor;
+        std::size_t shardIdx{0};
+        AcceptorStats* stats{nullptr};
+    };
+
+    // 按配置创建监听 socket（单个，或 N 个 SO_REUSEPORT）。
+    void openListeners(unsigned short port);
+    // 异步接受新连接（协程入口），每个 Listener 一个 acceptLoop。
     void doAccept();
-    boost::asio::awaitable<void> acceptLoop();
+    boost::asio::awaitable<void> acceptLoop(std::size_t idx);
+    // 处理一个已接入的 socket：IP 限制、创建连接、注册回调。
+    void onAccepted(tcp::socket socket, std::size_t shardIdx);
+    // 采样监听 socket 的内核 accept 队列长度。
+    void sampleBacklog(Listener& listener);
+    // 为新连接挑选分片。
+    std::size_t pickShard();
+    // 新连接落在哪个分片：每分片一个 acceptor 时就地留在 acceptor 所在分片，否则按策略挑选。
+    std::size_t connectionShard(const Listener& listener);
+    // 新连接 socket 使用的 executor（分片模式直接用分片 io_context，否则包一层 strand）。
+    boost::asio::any_io_executor connectionExecutor(std::size_t shardIdx);
     // 定时输出指标。
     void scheduleMetricsReport();
     // 定时检查闲置连接。
     void scheduleIdleCheck();
 
   private:
-    boost::asio::io_context io_context_;                // 主 I/O 上下文
-    boost::asio::ip::tcp::acceptor acceptor_;           // 监听套接字
+    boost::asio::io_context io_context_;                // 主 I/O 上下文（分片模式下即 0 号分片）
+    std::vector<Listener> listeners_;                   // 监听套接字（reusePort 时多个）
+    std::size_t acceptBatch_{16};                       // 每次唤醒最多接入的连接数
+
+    bool sharded_{false};                                                  // 是否启用 I/O 分片
+    bool leastConn_{false};                                                // 分片选择：最少连接 / 轮询
+    bool pinIoThreads_{false};                                             // 是否绑核
+    std::vector<std::unique_ptr<boost::asio::io_context>> extraContexts_;  // 1..N-1 号分片的 io_context
+    std::vector<std::unique_ptr<IoShard>> shards_;                         // 所有分片（0 号指向 io_context_）
+    std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> shardGuards_;  // 防止空闲分片 run() 提前返回
+    std::atomic<std::size_t> nextShard_{0};                                // 轮询游标
 
     std::size_t ioThreadsCount_{0};                     // I/O 线程数量
     std::vector<std::thread> ioThreads_;                // I/O 线程对象
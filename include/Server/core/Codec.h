@@ -5,19 +5,47 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "AsioConnection.h"
-#include "Metrics.h"
 #include "Buffer.h"
+#include "FrameBody.h"
+#include "FrameStream.h"
+#include "Metrics.h"
+
+struct InboundBody;
+
+// 解出的一帧（批量投递用）
+struct DecodedFrame {
+    std::uint16_t msgType;
+    FrameBody body;
+};
 
 // 长度头 + 消息类型的简单协议：
 // [4字节len][2字节msgType][Body...]
 // len = 2 + body.size()
 class LengthHeaderCodec {
   public:
-    using FrameCallback = std::function<void(const ConnectionPtr&, uint16_t /*msgType*/, const std::string& /*body*/)>;
+    // body 引用连接的读缓冲（小 body 为独立拷贝），回调方可以按值持有，不再需要拷贝字节
+    using FrameCallback = std::function<void(const ConnectionPtr&, uint16_t /*msgType*/, const FrameBody& /*body*/)>;
+
+    // 批量回调：一次 onMessage 解出的所有完整帧一起交付（frames 可被移走）
+    using FrameBatchCallback = std::function<void(const ConnectionPtr&, std::vector<DecodedFrame>& /*frames*/)>;
+
+    // 流式路由判定：帧头到达时调用。返回 false 表示按普通帧缓冲整帧（此时同一帧可能被多次询问，不得有副作用）；
+    // 返回 true 表示该帧按流式处理，out 为接收 body 的流，out 为空表示拒绝（body 到达即丢弃）
+    using StreamOpener = std::function<bool(const ConnectionPtr&, uint16_t /*msgType*/, uint32_t /*bodyLen*/, FrameStreamPtr& /*out*/)>;
+
+    // 超长帧回调：帧头长度超过 maxFrameBytes 时调用（用于回错误帧），body 由 Codec 丢弃
+    using OversizeCallback = std::function<void(const ConnectionPtr&, uint16_t /*msgType*/, uint32_t /*len*/)>;
 
     explicit LengthHeaderCodec(FrameCallback cb);
+    explicit LengthHeaderCodec(FrameBatchCallback cb);
+
+    // 入站帧上限（帧头 len 字段，0 不限制），需在收包前设置
+    void setMaxFrameBytes(std::size_t bytes, OversizeCallback onOversize = {});
+    // 流式路由判定，需在收包前设置
+    void setStreamOpener(StreamOpener opener);
 
     // 接收原始数据（AsioConnection onMessage 里调用）
     void onMessage(const ConnectionPtr& conn, Buffer& buf);
@@ -31,6 +59,16 @@ class LengthHeaderCodec {
     static std::string encodeFrame(uint16_t msgType, const std::string& body);
 
   private:
+    // 开始一个流式（或丢弃中的）帧 body，记在连接的 codecState 上
+    static InboundBody* beginInbound(const ConnectionPtr& conn, FrameStreamPtr stream, std::uint64_t bodyLen);
+    // 流式帧 body 收完
+    static void endInbound(const ConnectionPtr& conn);
+    // 引用读缓冲或拷贝出一段 body
+    static FrameBody makeBody(const BufferPool::Ptr* owner, const char* p, std::size_t n);
+
+    // 批量模式：把本次读取解出的帧一次交给上层
+    void deliverBatch(const ConnectionPtr& conn, std::vector<DecodedFrame>& batch);
+
     // 编码/解码辅助函数
     static uint32_t decodeUint32(const char* p);
     static uint16_t decodeUint16(const char* p);
@@ -38,5 +76,13 @@ class LengthHeaderCodec {
     static void encodeUint16(char* p, uint16_t v);
 
   private:
+    // 小于该长度的 body 直接拷贝：避免一个几十字节的帧把整块读缓冲钉住
+    static constexpr std::size_t kSliceMinBytes = 512;
+
     FrameCallback frameCallback_;
+    FrameBatchCallback batchCallback_;
+
+    std::size_t maxFrameBytes_{0};
+    OversizeCallback oversizeCallback_;
+    StreamOpener streamOpener_;
 };
\ No newline at end of file
@@ -13,6 +13,45 @@ struct ServerConfig {
     std::size_t maxQueueSize = 10000;
     int maxInflight = 10000;
     std::size_t maxSendBufferBytes = 4 * 1024 * 1024;
+
+    // I/O 分片：每个 I/O 线程独占一个 io_context，连接终生固定在所属分片
+    bool shardedIo = false;
+    std::string shardPolicy = "roundRobin";  // 新连接分配策略：roundRobin / leastConn
+    bool pinIoThreads = true;                // 分片模式下把 I/O 线程绑定到 CPU 核
+
+    // 监听：SO_REUSEPORT 多 acceptor，由内核在多个监听 socket 间分散新连接
+    bool reusePort = false;
+    std::size_t acceptorCount = 0;  // reusePort 时的 acceptor 数量，0 表示每个 I/O 线程一个
+    std::size_t acceptBatch = 16;   // 每次唤醒最多连续接入的连接数
+
+    // Socket 后端：epoll / io_uring（io_uring 需 -DDOMAIN_IO_URING=ON 构建出 domain_uring）
+    std::string ioBackend = "epoll";
+    std::string epollBinary;    // epoll 构建路径（io_uring 不可用时回退），空表示与当前可执行文件同目录的 domain
+    std::string ioUringBinary;  // io_uring 构建路径，空表示同目录的 domain_uring
+
+    // 自适应读缓冲：每次读取大小在 [min, max] 间按实际读到的字节数伸缩；已知待收帧长时一次读满
+    std::size_t readBufferMin = 1024;
+    std::size_t readBufferMax = 64 * 1024;
+    bool releaseIdleReadBuffer = false;     // 空闲连接归还读缓冲，不占内存（代价：归还后下次唤醒多一次 MSG_PEEK 与池的取还）
+    std::uint32_t releaseIdleReadAfter = 8;  // 连续读空多少次才归还（releaseIdleReadBuffer 开启时生效）
+
+    // 写合并：单次 writev 最多合并的帧数/字节数；cork 策略 off / msgMore / cork（TCP_CORK）
+    std::size_t writeBatchMaxFrames = 64;
+    std::size_t writeBatchMaxBytes = 256 * 1024;
+    std::string writeCork = "off";
+    bool flushOnReadEnd = true;  // 一轮读处理期间产生的回包推迟到该轮结束再统一发送
+
+    // 大帧发送走 MSG_ZEROCOPY（Linux >= 4.14），单帧字节数 >= 阈值时生效，0 表示关闭
+    std::size_t zeroCopyThreshold = 0;
+
+    // 入站帧上限：帧头声明的长度超过该值时直接拒绝并丢弃 body（不缓冲），0 表示不限制；流式路由不受此限制
+    std::size_t maxFrameBytes = 16 * 1024 * 1024;
+    // 流式路由的每连接窗口：已到达未被 handler 消费的 body 字节达到窗口时暂停读
+    std::size_t streamWindowBytes = 1024 * 1024;
+
+    // 同一连接内的请求顺序：none（并发执行、回包不保序）/ strict（逐个执行）/ inOrder（并发执行、按请求顺序回包）
+    // 作为每个连接的初始模式，routes[].ordering 可按路由覆盖
+    std::string ordering = "none";
 };
 
 struct ThreadPoolConfig {
@@ -25,8 +64,18 @@ struct ThreadPoolConfig {
 
     std::size_t highWatermark = 2000;
     std::size_t lowWatermark = 0;
-    int upThreshold = 3;
+    int upThreshold = 2;
     int downThreshold = 10;
+
+    // 自动伸缩目标：排队等待 p99 不超过 queueWaitSloUs，每 autoTuneIntervalMs 采样一次
+    std::size_t queueWaitSloUs = 5000;
+    std::size_t autoTuneIntervalMs = 100;
+
+    // 空闲策略：取不到任务时先自旋 idleSpinUs 再休眠（0 = 直接休眠；单核机器自动不自旋）
+    std::size_t idleSpinUs = 50;
+
+    // 一次读取解出的多帧每 N 帧合并成一个任务投递（取值说明见 README 的 threadPool.frameBatchSize）
+    std::size_t frameBatchSize = 32;
 };
 
 struct Limits {
@@ -52,6 +101,21 @@ struct MsgLimitConfig {
     int maxQps = 0;
     int maxConcurrent = 0;
     int burst = 0;  // 令牌桶容量（0 表示使用 maxQps）
+    int maxQueue = 0;        // 并发满时最多排队的请求数（0 表示直接拒绝，需配合 maxConcurrent）
+    int queueTimeoutMs = 0;  // 排队最长等待时间，超时拒绝
+};
+
+// 路由执行策略：inline（在连接 I/O strand 上直接执行）/ worker（共享线程池）/ dedicated（独立线程池，隔离重路由）
+struct RouteConfig {
+    std::string policy;  // 空表示沿用代码注册时的默认值
+    std::string pool;  // dedicated 时使用的 workerPools 名称
+    std::string ordering;  // none / strict / inOrder，空表示沿用连接的模式（server.ordering）
+};
+
+// 独立线程池（舱壁）
+struct WorkerPoolConfig {
+    std::size_t threads = 2;
+    std::size_t maxQueueSize = 1000;  // 0 表示不限制
 };
 
 struct BackpressureConfig {
@@ -67,10 +131,21 @@ struct BackpressureConfig {
 struct IpLimitConfig {
     std::size_t maxConnPerIp = 0;   // 0 表示不限制
     std::size_t maxQpsPerIp = 0;    // 0 表示不限制
-    std::unordered_set<std::string> whitelist;
+    std::size_t qpsBurst = 0;       // 允许的突发请求数（0 表示等于 maxQpsPerIp）
+    std::unordered_set<std::string> whitelist;  // 精确 IP，等同于 allow 中的 /32、/128
+    std::unordered_set<std::string> allow;      // CIDR 可信列表：跳过连接数/QPS 限制
+    std::unordered_set<std::string> deny;       // CIDR 黑名单：accept 后立即关闭
     std::uint64_t stateTtlSec = 300;  // IP 状态过期时间，0 表示不清理
 };
 
+// 流量分析（见 TrafficAnalytics.h）：固定内存统计每分钟的 Top-K 源 IP / 会话与去重数
+struct AnalyticsConfig {
+    bool enabled = true;
+    std::size_t topK = 20;            // /traffic 每个榜单展示的条数
+    std::size_t capacity = 256;       // 每个榜单监控的键数（SpaceSaving 容量），越大越准
+    std::uint32_t hllPrecision = 12;  // HyperLogLog 寄存器数为 2^p，相对误差约 1.04/sqrt(2^p)
+};
+
 struct ErrorFrames {
     std::uint16_t ipConnLimitMsgType = 65000;
     std::string ipConnLimitBody = "ip_conn_limit";
@@ -84,6 +159,9 @@ struct ErrorFrames {
     std::uint16_t msgRateLimitMsgType = 65003;
     std::string msgRateLimitBody = "msg_rate_limit";
 
+    std::uint16_t frameTooLargeMsgType = 65005;
+    std::string frameTooLargeBody = "frame_too_large";
+
     std::uint16_t backpressureMsgType = 65535;
     std::string backpressureBody = "backpressure";
 };
@@ -93,6 +171,10 @@ class Config {
     static Config& Instance();
 
     bool loadFromFile(const std::string& path);
+    // 最近一次 loadFromFile 的路径（未加载过为空）
+    const std::string& sourcePath() const;
+    // 重新读取配置文件中的 ipLimit 段（不修改当前 Config），文件无法加载时返回 false
+    static bool ReadIpLimit(const std::string& path, IpLimitConfig& out);
 
     const ServerConfig& server() const;
     const LogConfig& log() const;
@@ -100,8 +182,11 @@ class Config {
     const Limits& limits() const;
     const BackpressureConfig& backpressure() const;
     const IpLimitConfig& ipLimit() const;
+    const AnalyticsConfig& analytics() const;
     const ErrorFrames& errorFrames() const;
     const std::unordered_map<std::uint16_t, MsgLimitConfig>& msgLimits() const;
+    const std::unordered_map<std::uint16_t, RouteConfig>& routes() const;
+    const std::unordered_map<std::string, WorkerPoolConfig>& workerPools() const;
 
   private:
     Config() = default;
@@ -109,12 +194,16 @@ class Config {
     bool parseLuaConfig(void* L);
 
   private:
+    std::string sourcePath_;
     ServerConfig serverCfg_;
     LogConfig logCfg_;
     ThreadPoolConfig threadPoolCfg_;
     Limits limitscfg_;
     BackpressureConfig backpressureCfg_;
     IpLimitConfig ipLimitCfg_;
+    AnalyticsConfig analyticsCfg_;
     ErrorFrames errorFrames_;
     std::unordered_map<std::uint16_t, MsgLimitConfig> msgLimitsCfg_;
+    std::unordered_map<std::uint16_t, RouteConfig> routesCfg_;
+    std::unordered_map<std::string, WorkerPoolConfig> workerPoolsCfg_;
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "AsioConnection.h"
+#include "FrameBody.h"
+#include "ReplySequencer.h"
+#include "Task.h"
+
+class ThreadPool;
+
+// 一帧及其顺序控制信息：ordering 非空表示该帧已占回包序号 seq。字段按大小排列，单帧任务才放得进 Task 的内联缓冲
+struct RoutedFrame {
+    FrameBody body;
+    std::shared_ptr<ConnectionOrdering> ordering;
+    std::uint64_t seq{0};
+    std::uint16_t msgType{0};
+    bool strict{false};  // Strict：经连接的串行队列执行
+};
+
+/**
+ * @brief 线程池帧任务的执行方（由 InitServer 实现）。
+ * @details 任务只持有它的指针，不拷贝执行逻辑；执行方须比所有投递出去的任务活得久。
+ */
+class FrameRunner {
+  public:
+    virtual ~FrameRunner() = default;
+
+    // 在 pool 上启动 frames 的 handler；连接已断开时交还顺序与 in-flight 计数
+    virtual void runFrames(const std::weak_ptr<AsioConnection>& conn, ThreadPool& pool, RoutedFrame* frames, std::size_t n) = 0;
+    // 任务没执行就被销毁（投递失败、过载丢弃、线程池停止）：交还有序帧的回包序号与 in-flight 计数
+    virtual void dropFrames(RoutedFrame* frames, std::size_t n) noexcept = 0;
+};
+
+// 投递到线程池的单帧：帧直接存在任务里（frameBatchSize = 1，或一次读取只凑出一帧时），不经过 vector
+class FrameJob {
+  public:
+    FrameJob(FrameRunner& runner, ThreadPool& pool, std::weak_ptr<AsioConnection> conn, RoutedFrame frame)
+        : runner_(&runner), pool_(&pool), conn_(std::move(conn)), frame_(std::move(frame)) {}
+    FrameJob(FrameJob&& other) noexcept
+        : runner_(std::exchange(other.runner_, nullptr)), pool_(other.pool_), conn_(std::move(other.conn_)), frame_(std::move(other.frame_)) {}
+    FrameJob(const FrameJob&) = delete;
+
+    ~FrameJob() {
+        if (runner_) {
+            runner_->dropFrames(&frame_, 1);
+        }
+    }
+
+    void operator()() { std::exchange(runner_, nullptr)->runFrames(conn_, *pool_, &frame_, 1); }
+
+  private:
+    FrameRunner* runner_;  // 执行或移走后置空，兼作“尚未执行”标记
+    ThreadPool* pool_;
+    std::weak_ptr<AsioConnection> conn_;
+    RoutedFrame frame_;
+};
+
+// 投递到线程池的一组帧（一次读取同一线程池的多帧合并成一个任务）
+class FrameBatchJob {
+  public:
+    FrameBatchJob(FrameRunner& runner, ThreadPool& pool, std::weak_ptr<AsioConnection> conn, std::vector<RoutedFrame> frames)
+        : runner_(&runner), pool_(&pool), conn_(std::move(conn)), frames_(std::move(frames)) {}
+    FrameBatchJob(FrameBatchJob&& other) noexcept
+        : runner_(std::exchange(other.runner_, nullptr)), pool_(other.pool_), conn_(std::move(other.conn_)), frames_(std::move(other.frames_)) {}
+    FrameBatchJob(const FrameBatchJob&) = delete;
+
+    ~FrameBatchJob() {
+        if (runner_) {
+            runner_->dropFrames(frames_.data(), frames_.size());
+        }
+    }
+
+    void operator()() { std::exchange(runner_, nullptr)->runFrames(conn_, *pool_, frames_.data(), frames_.size()); }
+
+  private:
+    FrameRunner* runner_;
+    ThreadPool* pool_;
+    std::weak_ptr<AsioConnection> conn_;
+    std::vector<RoutedFrame> frames_;
+};
+
+// 两种任务都必须走 Task 的内联存储，投递一帧/一组帧时除 vector 本身外不再分配（task_alloc_bench 实测）
+static_assert(Task::FitsInline<FrameJob>(), "FrameJob must fit Task inline storage");
+static_assert(Task::FitsInline<FrameBatchJob>(), "FrameBatchJob must fit Task inline storage");
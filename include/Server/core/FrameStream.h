@@ -0,0 +1,66 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+
+#include "AsioConnection.h"
+#include "FrameBody.h"
+
+/**
+ * @brief 流式路由的入站帧：大 body 按到达顺序分块交给协程 handler。
+ * @details Codec 解出帧头后创建 FrameStream，之后每次读到的 body 字节都以 chunk 形式 push 进来，
+ *          不再在读缓冲里攒整帧。已缓冲未消费的字节达到窗口时暂停连接读，handler 消费到半窗口以下再恢复，
+ *          因此单连接内存上限约为一个窗口。
+ *          线程模型：push/finish/abort 由 Codec 在连接 executor 上调用，handler 也在同一 executor 上运行，无需加锁。
+ */
+class FrameStream {
+  public:
+    FrameStream(const ConnectionPtr& conn, std::uint16_t msgType, std::uint64_t totalBytes, std::size_t windowBytes);
+    ~FrameStream();
+
+    FrameStream(const FrameStream&) = delete;
+    FrameStream& operator=(const FrameStream&) = delete;
+
+    std::uint16_t msgType() const { return msgType_; }
+    // 帧头声明的 body 总长度
+    std::uint64_t totalBytes() const { return totalBytes_; }
+    // 已交给 handler 的字节数
+    std::uint64_t consumedBytes() const { return consumed_; }
+    // 连接关闭导致流中断（此时 body 不完整）
+    bool aborted() const { return aborted_; }
+
+    // handler 侧：取下一块 body，流结束或中断时返回 std::nullopt
+    boost::asio::awaitable<std::optional<FrameBody>> next();
+
+    // Codec 侧：追加一块 body
+    void push(FrameBody chunk);
+    // Codec 侧：body 已全部到达
+    void finish();
+    // Codec 侧：连接关闭，唤醒 handler 并释放读暂停
+    void abort();
+
+  private:
+    void wake();
+    void holdRead();
+    void releaseRead();
+
+  private:
+    std::weak_ptr<AsioConnection> conn_;
+    std::uint16_t msgType_;
+    std::uint64_t totalBytes_;
+    std::size_t window_;
+
+    boost::asio::steady_timer signal_;  // handler 等待新数据（cancel 即唤醒）
+    std::deque<FrameBody> chunks_;      // 已到达未消费的 body 块
+    std::size_t buffered_{0};           // chunks_ 中的字节数
+    std::uint64_t consumed_{0};
+    bool holding_{false};   // 是否因窗口满暂停了连接读
+    bool finished_{false};
+    bool aborted_{false};
+};
+
+using FrameStreamPtr = std::shared_ptr<FrameStream>;
@@ -10,10 +10,15 @@ class HttpControlServer {
   public:
     using tcp = boost::asio::ip::tcp;
     using readyCallback = std::function<bool()>;
+    // 重新加载 IP 访问控制规则：返回是否成功，message 写入给调用方的说明
+    using aclReloadCallback = std::function<bool(std::string& message)>;
 
     HttpControlServer(unsigned short port, readyCallback readyCheck);
     ~HttpControlServer();
 
+    // 启用 POST /acl/reload（需在 start 之前设置；只接受来自本机回环地址的请求）
+    void setAclReloadCallback(aclReloadCallback cb);
+
     void start();
     void stop();
 
@@ -21,7 +26,7 @@ class HttpControlServer {
     void doAccept();
     boost::asio::awaitable<void> acceptLoop();
     boost::asio::awaitable<void> handleSession(std::shared_ptr<tcp::socket> sock);
-    std::string handleRequest(const std::string& request);
+    std::string handleRequest(const std::string& request, bool fromLoopback);
     std::string buildResponse(int statusCode, const std::string& statusText, const std::string& body,
                               const std::string& contentType = "text/plain; charset=utf-8");
 
@@ -31,6 +36,7 @@ class HttpControlServer {
 
     tcp::acceptor acceptor_;
     readyCallback readyCheck_;
+    aclReloadCallback aclReload_;
     std::thread thread_;
     std::atomic<bool> running_{false};
 };
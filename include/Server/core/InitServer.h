@@ -4,14 +4,17 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <string>
+#include <unordered_map>
 
 #include "AsioServer.h"
 #include "Codec.h"
 #include "Config.h"
+#include "FrameJob.h"
 #include "HttpControlServer.h"
 #include "MessageRouter.h"
 
-class InitServer {
+class InitServer : private FrameRunner {
   public:
     explicit InitServer(const Config& cfg);
 
@@ -22,6 +25,22 @@ class InitServer {
   private:
     std::shared_ptr<MessageRouter> buildRouter(const Config& cfg);
     std::shared_ptr<LengthHeaderCodec> buildCodec(const std::shared_ptr<MessageRouter>& router, const Config& cfg);
+    // 单帧准入：per-IP QPS + 全局 in-flight，放行时 in-flight 已计入
+    bool admitFrame(const ConnectionPtr& conn, uint16_t msgType, const Config& cfg);
+    // 归还 n 帧的 in-flight 计数
+    void releaseFrames(std::size_t n);
+
+    // 以协程在 exec 上执行一帧（不阻塞调用线程），handler 结束后调用 onDone
+    void spawnFrame(boost::asio::any_io_executor exec, const ConnectionPtr& conn, RoutedFrame f, std::function<void()> onDone);
+    // 有序帧未执行就被丢弃时交还序号，否则其后的回包会一直被扣住
+    static void abandonFrame(const RoutedFrame& f);
+    // 投递到线程池：单帧直接放进任务，多帧才用 vector；投递失败时任务析构里交还
+    void submitFrame(const std::shared_ptr<ThreadPool>& pool, const ConnectionPtr& conn, RoutedFrame f);
+    void submitFrames(const std::shared_ptr<ThreadPool>& pool, const ConnectionPtr& conn, std::vector<RoutedFrame> frames);
+    // FrameRunner：线程池上的帧任务经这两个入口执行/交还
+    void runFrames(const std::weak_ptr<AsioConnection>& conn, ThreadPool& pool, RoutedFrame* frames, std::size_t n) override;
+    void dropFrames(RoutedFrame* frames, std::size_t n) noexcept override;
+
     std::shared_ptr<AsioServer> buildServer(const ServerConfig& sc, const std::shared_ptr<LengthHeaderCodec>& codec);
     std::shared_ptr<HttpControlServer> buildHttpControlServer(const Config& cfg);
 
@@ -42,5 +61,6 @@ class InitServer {
     std::thread signalThread_;
 
     std::shared_ptr<ThreadPool> workerPool_;
+    std::unordered_map<std::string, std::shared_ptr<ThreadPool>> dedicatedPools_;  // 独立线程池（名字 -> 池）
     std::atomic<int> inflight_{0};
 };
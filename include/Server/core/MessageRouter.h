@@ -1,46 +1,92 @@
 #pragma once
 
 #include <cstdint>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/co_spawn.hpp>
 #include <google/protobuf/message.h>
 #include <nlohmann/json.hpp>
 
 #include "AsioConnection.h"
+#include "EpochDomain.h"
+#include "FrameBody.h"
+#include "FrameStream.h"
+#include "ReplySequencer.h"
 
 struct MessageContext {
     ConnectionPtr conn;
     std::uint16_t msgType;
-    std::shared_ptr<std::string> body;
+    FrameBody body;  // 引用读缓冲中的原始字节，拷贝 ctx 或 body 都不拷贝数据
     std::string traceId;  // 优先用上游透传的 traceId，默认用 sessionId
 };
 
 using CoMessageHandler = std::function<boost::asio::awaitable<void>(const ConnectionPtr&, std::string_view)>;
+// 流式 handler：body 经 stream->next() 按块读取，适合大上传；不经过中间件链
+using CoStreamHandler = std::function<boost::asio::awaitable<void>(const ConnectionPtr&, FrameStreamPtr)>;
 using CoNextFunc = std::function<boost::asio::awaitable<void>(std::shared_ptr<MessageContext>)>;
 using CoMiddleware = std::function<boost::asio::awaitable<void>(std::shared_ptr<MessageContext>, CoNextFunc)>;
 
-enum class PayloadFormat { Raw, Json, Proto };
+using CoDefaultHandler = std::function<boost::asio::awaitable<void>(const ConnectionPtr&, std::uint16_t, const std::string&)>;
+
+// Stream：流式路由（不走 dispatch）；Fallback：未注册 msgType，调用 defaultHandler
+enum class PayloadFormat { Raw, Json, Proto, Stream, Fallback };
+
+// 路由执行策略：Inline 在连接 I/O strand 上执行（极轻 handler）；Worker 在共享线程池执行；Dedicated 在独立线程池执行（舱壁）
+enum class RoutePolicy { Inline, Worker, Dedicated };
 
 struct HandlerEntry {
     PayloadFormat fmt{PayloadFormat::Raw};  // 负责编码/解码的格式
+    RoutePolicy policy{RoutePolicy::Worker};  // 执行位置
+    std::shared_ptr<ThreadPool> pool;         // Dedicated 时的独立线程池（发布路由表时按名字解析）
+    OrderingMode ordering{OrderingMode::Default};  // 同一连接内的顺序语义，Default 沿用连接的模式
     CoMessageHandler rawHandler;            // 直接使用 std::string 的处理器
     std::function<boost::asio::awaitable<void>(const ConnectionPtr&, const nlohmann::json&)> jsonHandler;  // JSON 处理器
     std::function<boost::asio::awaitable<void>(const ConnectionPtr&, google::protobuf::Message&)> protoHandler;  // Protobuf 处理器
     std::function<std::unique_ptr<google::protobuf::Message>()> protoFactory;  // Proto 实例工厂（用于反序列化）
+    CoStreamHandler streamHandler;          // 流式处理器
+    CoDefaultHandler defaultHandler;        // 兜底处理器（仅 Fallback）
+};
+
+/**
+ * @brief 只读路由表：msgType 直接下标定位，每次注册/变更后由 MessageRouter 重新编译并原子替换。
+ * @details 表本身发布后不再修改，读者在 EpochDomain 读区间内无锁查表；被替换的旧表等读区间结束后释放。
+ *          entry 以 shared_ptr 持有，执行中的 handler 协程拿一份引用，旧表释放后仍可安全跑完。
+ */
+struct RouteTable {
+    std::vector<std::uint32_t> slots;  // msgType -> entries 下标 + 1，0 表示未注册；长度为最大已注册 msgType + 1
+    std::vector<std::shared_ptr<const HandlerEntry>> entries;
+    std::shared_ptr<const HandlerEntry> fallback;  // 未注册 msgType 的兜底（包装 defaultHandler，随表构建一次），始终非空
+
+    const std::shared_ptr<const HandlerEntry>& find(std::uint16_t msgType) const {
+        if (msgType < slots.size()) {
+            std::uint32_t idx = slots[msgType];
+            if (idx != 0) {
+                return entries[idx - 1];
+            }
+        }
+        return fallback;
+    }
 };
 
+class MiddlewarePipeline;
+template <typename... Stages>
+class FusedPipeline;
+
 // 消息路由器：按 msgType 分发，支持中间件链、JSON/Proto/Raw 三种格式。
+// 路由类接口（注册 handler、策略、顺序、独立池、兜底）随时可调用：每次变更重新编译路由表并原子替换，分发侧无锁查表。
 class MessageRouter {
   public:
-    MessageRouter() = default;
+    MessageRouter();
 
     // 注册一个 msgType 对应的 raw handler（线程安全）
     void registerHandler(std::uint16_t msgType, CoMessageHandler handler);
@@ -50,28 +96,80 @@ class MessageRouter {
     template <typename ProtoT>
     void registerProto(std::uint16_t msgType, std::function<boost::asio::awaitable<void>(const ConnectionPtr&, const ProtoT&)> handler);
 
+    // 注册流式 handler：该 msgType 的 body 不整帧缓冲，边收边交给 handler（线程安全）
+    void registerStream(std::uint16_t msgType, CoStreamHandler handler);
+
+    // 是否为流式路由
+    bool isStreamRoute(std::uint16_t msgType) const;
+    // 为一个流式帧创建 FrameStream 并在连接 executor 上启动 handler，handler 结束后调用 onDone
+    FrameStreamPtr openStream(const ConnectionPtr& conn, std::uint16_t msgType, std::uint64_t bodyLen, std::size_t windowBytes, std::function<void()> onDone = {});
+
+    // 设置路由执行策略（可先于或晚于 handler 注册，重新注册 handler 不会丢失）；Dedicated 需给出 addWorkerPool 注册过的池名
+    void setRoutePolicy(std::uint16_t msgType, RoutePolicy policy, std::string pool = {});
+    // 设置路由的顺序语义（覆盖连接级模式）；与执行策略一样可先于 handler 注册
+    void setRouteOrdering(std::uint16_t msgType, OrderingMode mode);
+    // 注册一个独立线程池供 Dedicated 路由使用
+    void addWorkerPool(const std::string& name, std::shared_ptr<ThreadPool> pool);
+
+    // 在读区间内以路由 entry 调用 f 并返回其结果（无锁）；未注册的 msgType 传兜底 entry。
+    // entry 引用只在 f 内有效，f 不能挂起，也不要把引用带出去
+    template <typename F>
+    decltype(auto) withRoute(std::uint16_t msgType, F&& f) const {
+        EpochDomain::ReadGuard guard(epoch_);
+        return std::forward<F>(f)(*table_.load(std::memory_order_acquire)->find(msgType));
+    }
+
     // 设置一个默认 handler：当 msgType 未注册时调用（可选）
-    void setDefaultHandler(std::function<boost::asio::awaitable<void>(const ConnectionPtr&, std::uint16_t, const std::string&)> handler);
+    void setDefaultHandler(CoDefaultHandler handler);
 
     // 注册中间件（建议在服务器启动阶段调用）
     void use(CoMiddleware mw);
-
-    // Codec 解出一帧后调用
+    // 设置预编译的融合管线（见 MiddlewarePipeline.h），先于 use() 注册的中间件执行；仅在启动阶段调用
+    void usePipeline(std::shared_ptr<const MiddlewarePipeline> pipeline);
+
+    // 在调用方协程里执行一条消息：管线 -> 动态中间件 -> handler
+    boost::asio::awaitable<void> process(MessageContext ctx);
+
+    // Codec 解出一帧后调用：在连接 executor 上异步执行
+    void onMessage(const ConnectionPtr& conn, std::uint16_t msgType, FrameBody body);
+    // 在 exec 上以协程执行整条链（线程池路由传线程池的 executor，handler 挂起时不占线程），
+    // handler 结束（含异常、协程未跑完即被销毁）后调用一次 onDone
+    void spawn(boost::asio::any_io_executor exec, const ConnectionPtr& conn, std::uint16_t msgType, FrameBody body, std::function<void()> onDone);
+    // 兼容旧接口：拷贝一份 body
     void onMessage(const ConnectionPtr& conn, std::uint16_t msgType, const std::string& body);
 
   private:
+    template <typename... Stages>
+    friend class FusedPipeline;
+
+    // 管线之后的部分：有动态中间件时走 dispatch，否则直接调用 handler
+    boost::asio::awaitable<void> runHandler(MessageContext& ctx);
+    // 按 payload 格式解码并调用 handler
+    boost::asio::awaitable<void> invokeHandler(MessageContext& ctx);
+
     // 实际执行链：从第 idx 个 middleware 开始
     boost::asio::awaitable<void> dispatch(std::size_t idx, std::shared_ptr<MessageContext> ctx);
 
-    // 取出一个 handler（上读锁）
-    HandlerEntry getHandler(std::uint16_t msgType);
+    // 取出一个 handler 的引用计数副本（无锁），供跨挂起点使用
+    std::shared_ptr<const HandlerEntry> getHandler(std::uint16_t msgType) const;
+
+    // 由 handlers_/policies_ 等编译新路由表并替换当前表，等旧表的读者离开后释放（需持有 mtx_）
+    void publishLocked();
 
   private:
-    mutable std::mutex mtx_;  // 保护 handlers_，middlewares_ 在启动期构建后只读
-    std::unordered_map<std::uint16_t, HandlerEntry> handlers_;  // msgType -> handler
-    std::function<boost::asio::awaitable<void>(const ConnectionPtr&, std::uint16_t, const std::string&)> defaultHandler_;  // 未注册 msgType 的兜底处理
+    mutable std::mutex mtx_;  // 保护写侧 handlers_/defaultHandler_ 等并串行化发布，middlewares_ 在启动期构建后只读
+    std::unordered_map<std::uint16_t, HandlerEntry> handlers_;  // msgType -> handler（写侧，发布时编译进路由表）
+    std::unordered_map<std::uint16_t, std::pair<RoutePolicy, std::string>> policies_;  // msgType -> 执行策略 + 池名
+    std::unordered_map<std::uint16_t, OrderingMode> orderings_;  // msgType -> 顺序语义
+    std::unordered_map<std::string, std::shared_ptr<ThreadPool>> pools_;  // 独立线程池
+    CoDefaultHandler defaultHandler_;  // 未注册 msgType 的兜底处理
+
+    std::unique_ptr<const RouteTable> current_;     // table_ 指向的表（写侧持有，需持有 mtx_）
+    std::atomic<const RouteTable*> table_{nullptr};  // 当前路由表（读侧），构造后始终非空
+    EpochDomain epoch_;                              // 读者查表的读区间，替换后据此回收旧表
 
     std::vector<CoMiddleware> middlewares_;
+    std::shared_ptr<const MiddlewarePipeline> pipeline_;  // 启动期设置后只读
 };
 
 template <typename ProtoT>
@@ -88,4 +186,5 @@ void MessageRouter::registerProto(std::uint16_t msgType, std::function<boost::as
     };
     std::lock_guard<std::mutex> lock(mtx_);
     handlers_[msgType] = std::move(entry);
+    publishLocked();
 }
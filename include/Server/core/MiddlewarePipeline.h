@@ -0,0 +1,164 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "MessageRouter.h"
+
+/**
+ * @brief 预编译的中间件管线（MessageRouter::usePipeline）。
+ * @details 管线中的每个阶段（Stage）是一个普通对象，需线程安全且方法为 const：
+ *            bool enter(MessageContext&) const —— 返回 false 拦截该消息，不再执行后续阶段和 handler；
+ *                                                也可返回 Admission，Wait 表示需要排队；
+ *            awaitable<bool> wait(MessageContext&) const —— 可选，enter 返回 Wait 时挂起等待，
+ *                                                true 视为放行，false 视为拦截；
+ *            void leave(MessageContext&) const —— 可选，handler 结束（含异常）或被后续阶段拦截后按逆序调用，
+ *                                                只对 enter 放行过的阶段调用。
+ *          FusedPipeline 用折叠表达式把所有阶段展开在同一个协程里，阶段之间没有 CoNextFunc、协程帧或
+ *          shared_ptr<MessageContext> 拷贝；enter 恒为 true 且没有 leave 的空阶段内联后不产生任何代码。
+ *          整条管线只有一次虚调用；没有阶段实现 wait 时不产生任何排队相关的代码。
+ */
+class MiddlewarePipeline {
+  public:
+    virtual ~MiddlewarePipeline() = default;
+
+    // 执行整条管线，全部放行后交给 router 的 handler（以及 use() 注册的动态中间件）
+    virtual boost::asio::awaitable<void> run(MessageRouter& router, MessageContext& ctx) const = 0;
+};
+
+// 阶段 enter 的判定结果
+enum class Admission {
+    Reject,  // 拦截
+    Pass,    // 放行
+    Wait,    // 暂时不能放行，调用阶段的 wait() 挂起等待
+};
+
+namespace pipeline_detail {
+    template <typename S, typename = void>
+    struct HasLeave : std::false_type {};
+
+    template <typename S>
+    struct HasLeave<S, std::void_t<decltype(std::declval<const S&>().leave(std::declval<MessageContext&>()))>> : std::true_type {};
+
+    template <typename S, typename = void>
+    struct HasWait : std::false_type {};
+
+    template <typename S>
+    struct HasWait<S, std::void_t<decltype(std::declval<const S&>().wait(std::declval<MessageContext&>()))>> : std::true_type {};
+
+    constexpr Admission ToAdmission(bool pass) { return pass ? Admission::Pass : Admission::Reject; }
+    constexpr Admission ToAdmission(Admission admission) { return admission; }
+
+    inline boost::asio::awaitable<bool> Rejected() { co_return false; }
+}  // namespace pipeline_detail
+
+template <typename... Stages>
+class FusedPipeline final : public MiddlewarePipeline {
+  public:
+    explicit FusedPipeline(Stages... stages) : stages_(std::move(stages)...) {}
+
+    boost::asio::awaitable<void> run(MessageRouter& router, MessageContext& ctx) const override {
+        std::size_t entered = 0;
+        Admission admission = enterFrom(ctx, entered, std::index_sequence_for<Stages...>{});
+        if constexpr ((pipeline_detail::HasWait<Stages>::value || ...)) {
+            // 第 entered 个阶段要求排队：等到放行后从它的下一个阶段继续 enter
+            while (admission == Admission::Wait) {
+                if (!co_await waitAt<0>(ctx, entered)) {
+                    admission = Admission::Reject;
+                    break;
+                }
+                ++entered;
+                admission = enterFrom(ctx, entered, std::index_sequence_for<Stages...>{});
+            }
+        }
+        if (admission != Admission::Pass) {
+            leaveAll(ctx, entered, std::index_sequence_for<Stages...>{});
+            co_return;
+        }
+        try {
+            co_await router.runHandler(ctx);
+        } catch (...) {
+            leaveAll(ctx, entered, std::index_sequence_for<Stages...>{});
+            throw;
+        }
+        leaveAll(ctx, entered, std::index_sequence_for<Stages...>{});
+    }
+
+  private:
+    // 从第 entered 个阶段起按顺序 enter，&& 短路：第一个未放行的阶段之后都不执行；
+    // entered 记录放行的阶段数，返回值为第一个未放行阶段的判定（全部放行为 Pass）
+    template <std::size_t... I>
+    Admission enterFrom(MessageContext& ctx, std::size_t& entered, std::index_sequence<I...>) const {
+        Admission result = Admission::Pass;
+        ((I < entered || ((result = pipeline_detail::ToAdmission(std::get<I>(stages_).enter(ctx))) == Admission::Pass && (entered = I + 1, true))) &&
+         ...);
+        return result;
+    }
+
+    // 调用第 index 个阶段的 wait（编译期展开成按下标分派）
+    template <std::size_t I>
+    boost::asio::awaitable<bool> waitAt(MessageContext& ctx, std::size_t index) const {
+        if constexpr (I == sizeof...(Stages)) {
+            return pipeline_detail::Rejected();
+        } else {
+            if constexpr (pipeline_detail::HasWait<std::tuple_element_t<I, std::tuple<Stages...>>>::value) {
+                if (I == index) {
+                    return std::get<I>(stages_).wait(ctx);
+                }
+            }
+            return waitAt<I + 1>(ctx, index);
+        }
+    }
+
+    // 逆序 leave 已放行的阶段
+    template <std::size_t... I>
+    void leaveAll(MessageContext& ctx, std::size_t entered, std::index_sequence<I...>) const {
+        (leaveOne<sizeof...(Stages) - 1 - I>(ctx, entered), ...);
+    }
+
+    template <std::size_t I>
+    void leaveOne(MessageContext& ctx, std::size_t entered) const {
+        using Stage = std::tuple_element_t<I, std::tuple<Stages...>>;
+        if constexpr (pipeline_detail::HasLeave<Stage>::value) {
+            if (I < entered) {
+                std::get<I>(stages_).leave(ctx);
+            }
+        }
+    }
+
+  private:
+    std::tuple<Stages...> stages_;
+};
+
+// 由若干阶段构造一条融合管线
+template <typename... Stages>
+std::shared_ptr<const MiddlewarePipeline> MakePipeline(Stages&&... stages) {
+    return std::make_shared<const FusedPipeline<std::decay_t<Stages>...>>(std::forward<Stages>(stages)...);
+}
+
+// 把一个阶段包装成传统 CoMiddleware，供 router.use() 动态组合
+template <typename Stage>
+CoMiddleware MakeStageMiddleware(Stage stage) {
+    return [stage = std::move(stage)](std::shared_ptr<MessageContext> ctx, CoNextFunc next) -> boost::asio::awaitable<void> {
+        Admission admission = pipeline_detail::ToAdmission(stage.enter(*ctx));
+        if constexpr (pipeline_detail::HasWait<Stage>::value) {
+            if (admission == Admission::Wait && co_await stage.wait(*ctx)) {
+                admission = Admission::Pass;
+            }
+        }
+        if (admission != Admission::Pass) {
+            co_return;
+        }
+        if constexpr (pipeline_detail::HasLeave<Stage>::value) {
+            // next 抛异常时也要归还
+            std::shared_ptr<void> leaveGuard(nullptr, [&stage, ctx](void*) { stage.leave(*ctx); });
+            co_await next(ctx);
+        } else {
+            co_await next(ctx);
+        }
+    };
+}
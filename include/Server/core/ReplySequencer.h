@@ -0,0 +1,142 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/execution.hpp>
+#include <boost/asio/query.hpp>
+#include <boost/asio/require.hpp>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "AsioConnection.h"
+#include "BufferPool.h"
+
+// 单连接内请求的顺序语义
+enum class OrderingMode {
+    Default,  // 路由未指定：沿用连接的模式
+    None,     // 不保证：handler 并发执行，回包谁先完成谁先发
+    Strict,   // 严格顺序：同一连接的请求逐个执行，回包自然有序
+    InOrder,  // 并发执行、按请求顺序回包：先完成的回包暂存，直到之前的回包都已发出
+};
+
+// 配置字符串（none / strict / inOrder）转 OrderingMode，其余返回 Default
+OrderingMode ParseOrderingMode(const std::string& name);
+
+/**
+ * @brief 有序请求的回包槽。
+ * @details Scope 生效期间，LengthHeaderCodec::send 发往该连接的帧写入槽内缓冲而不是直接发送，
+ *          请求结束后由 ConnectionOrdering 按序号整体发出。Scope 是线程局部的，
+ *          请求的协程经 ReplySlotExecutor 执行时每段执行都会重新装上自己的槽（见下）。
+ */
+class ReplySlot {
+  public:
+    explicit ReplySlot(const AsioConnection* conn) : conn_(conn) {}
+
+    bool owns(const AsioConnection* conn) const { return conn == conn_; }
+    void append(const void* data, std::size_t len);
+    BufferPool::Ptr take() { return std::move(buf_); }
+
+    // 本线程当前生效的槽（没有则为 nullptr）
+    static ReplySlot* current();
+
+    class Scope {
+      public:
+        explicit Scope(ReplySlot& slot);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        ReplySlot* prev_;
+    };
+
+  private:
+    const AsioConnection* conn_;
+    BufferPool::Ptr buf_;
+};
+
+/**
+ * @brief 把回包槽绑在一个请求上的 executor：经它执行的每一段（协程首次运行、每次挂起后的恢复）都装上该请求的槽。
+ * @details 有序请求的 handler 协程以它为 executor 运行，限流排队、定时器等挂起后在任意线程恢复，回包仍进入本请求的槽，
+ *          同一线程上交替执行的其他请求互不串槽。经 ThreadPool::schedule 切到线程池的区间不经过协程的 executor，
+ *          不在覆盖范围内：应像 MSG_DIGEST 那样切回原 executor 之后再发送。
+ */
+class ReplySlotExecutor {
+  public:
+    ReplySlotExecutor(boost::asio::any_io_executor inner, std::shared_ptr<ReplySlot> slot) : inner_(std::move(inner)), slot_(std::move(slot)) {}
+
+    boost::asio::execution_context& query(boost::asio::execution::context_t) const noexcept {
+        return boost::asio::query(inner_, boost::asio::execution::context);
+    }
+
+    ReplySlotExecutor require(boost::asio::execution::blocking_t::never_t) const {
+        return ReplySlotExecutor(boost::asio::require(inner_, boost::asio::execution::blocking.never), slot_);
+    }
+
+    template <typename F>
+    void execute(F&& f) const {
+        inner_.execute([slot = slot_, f = std::forward<F>(f)]() mutable {
+            ReplySlot::Scope scope(*slot);
+            std::move(f)();
+        });
+    }
+
+    friend bool operator==(const ReplySlotExecutor& a, const ReplySlotExecutor& b) noexcept { return a.inner_ == b.inner_ && a.slot_ == b.slot_; }
+    friend bool operator!=(const ReplySlotExecutor& a, const ReplySlotExecutor& b) noexcept { return !(a == b); }
+
+  private:
+    boost::asio::any_io_executor inner_;
+    std::shared_ptr<ReplySlot> slot_;
+};
+
+/**
+ * @brief 单连接的顺序控制：InOrder 的回包排序器 + Strict 的串行执行队列。
+ * @details reserve() 在 I/O 线程上按帧到达顺序发号；complete() 可在任意线程调用，
+ *          序号连续的已完成回包在锁内依次交给连接发送，保证对端看到的回包顺序与请求顺序一致。
+ */
+class ConnectionOrdering : public std::enable_shared_from_this<ConnectionOrdering> {
+  public:
+    ConnectionOrdering(const ConnectionPtr& conn, OrderingMode mode);
+
+    // 连接级模式（路由为 Default 时使用），可由 handler 切换
+    OrderingMode mode() const;
+    void setMode(OrderingMode mode);
+
+    // I/O 线程：为一个请求占号
+    std::uint64_t reserve();
+    // 任意线程：请求 seq 结束，slot 中是它产生的回包（可为空）
+    void complete(std::uint64_t seq, ReplySlot& slot);
+
+    // Strict：把一个请求排进串行队列。轮到它时调用 run（pool 为空表示在调用线程上就地调用，即 inline 路由），
+    // run 只负责启动请求，请求真正结束（handler 协程完成）时必须调用 strictDone 放行下一个；
+    // 线程池任务没执行就被销毁（投递失败、过载丢弃、线程池停止）时调用 drop，并自动放行下一个
+    void runStrict(std::shared_ptr<ThreadPool> pool, std::function<void()> run, std::function<void()> drop);
+    // 当前 Strict 请求结束，开始队列中的下一个
+    void strictDone();
+
+  private:
+    void runNextStrict();
+
+  private:
+    struct StrictJob {
+        std::shared_ptr<ThreadPool> pool;
+        std::function<void()> run;
+        std::function<void()> drop;
+    };
+
+    std::weak_ptr<AsioConnection> conn_;
+    std::atomic<OrderingMode> mode_;
+
+    std::mutex replyMtx_;
+    std::uint64_t nextSeq_{0};                         // 下一个可分配的序号（仅 I/O 线程）
+    std::uint64_t nextSend_{0};                        // 下一个应发出的序号
+    std::map<std::uint64_t, BufferPool::Ptr> held_;    // 已完成但前面还有未完成请求的回包
+
+    std::mutex strictMtx_;
+    std::deque<StrictJob> strictQueue_;
+    bool strictRunning_{false};
+};
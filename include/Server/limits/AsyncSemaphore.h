@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief 协程信号量：permits 个名额，名额用尽时请求以挂起的协程在有界 FIFO 中排队。
+ * @details tryAcquire 是无锁快路径（有人排队时不插队）；acquire 在队列未满时挂起，
+ *          直到 release 把名额直接转交给队头，或等待超过 timeout 后放弃。
+ *          排队的请求只是一个挂起的协程加一个定时器，不占任何线程；定时器的 async_wait 与 cancel 都在 mtx_ 内调用，
+ *          转交与超时谁先到由锁内的 result 判定，协程统一经定时器的完成回调在自己的 executor 上恢复，
+ *          因此等待者可以位于线程池这类多线程 executor 上。锁只出现在排队/转交的慢路径上。
+ */
+class AsyncSemaphore {
+  public:
+    AsyncSemaphore(std::size_t permits, std::size_t maxQueue, std::chrono::milliseconds timeout);
+
+    // 调整名额、队列上限与等待时长（已在等待的请求沿用原超时）；名额变大时立即唤醒可放行的等待者
+    void setLimits(std::size_t permits, std::size_t maxQueue, std::chrono::milliseconds timeout);
+
+    enum class AcquireResult {
+        Acquired,   // 拿到名额，之后需 release
+        QueueFull,  // 队列已满，未等待
+        TimedOut,   // 排队超过 timeout
+    };
+
+    bool tryAcquire();
+    boost::asio::awaitable<AcquireResult> acquire();
+    // 归还一个名额，有等待者时直接转交给队头
+    void release();
+
+    std::size_t inUse() const { return inUse_.load(std::memory_order_relaxed); }
+    std::size_t waiting() const { return waiting_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Waiter {
+        explicit Waiter(boost::asio::steady_timer timer) : timer(std::move(timer)) {}
+        boost::asio::steady_timer timer;       // 超时与唤醒共用：转交时取消它，完成回调里恢复协程（受 mtx_ 保护）
+        std::optional<AcquireResult> result;   // 转交或超时先到者写入（受 mtx_ 保护）
+    };
+
+    bool tryTake();
+    // 已入队的等待者挂起，直到被转交名额或超时
+    boost::asio::awaitable<AcquireResult> waitFor(std::shared_ptr<Waiter> waiter);
+    // 把空出的名额依次转交给队头并取消其定时器（需持有 mtx_）
+    void grantLocked();
+
+    std::atomic<std::size_t> permits_;
+    std::atomic<std::size_t> maxQueue_;
+    std::atomic<std::int64_t> timeoutMs_;
+    std::atomic<std::size_t> inUse_{0};
+    std::atomic<std::size_t> waiting_{0};  // 队列中的等待者数，release 据此跳过加锁
+
+    std::mutex mtx_;
+    std::deque<std::shared_ptr<Waiter>> queue_;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "EpochDomain.h"
+#include "IpKey.h"
+
+struct IpLimitConfig;
+
+/**
+ * @brief 按 CIDR 的 IP 访问控制（allow/deny 列表），在 accept 阶段、创建 AsioConnection 之前判定。
+ *
+ * 规则编译成一棵路径压缩的二叉前缀树（Patricia）：IPv4 前缀映射到 ::ffff:0:0/96 之下，与 IPv6 共用一棵树；
+ * 节点存放在连续数组里，每个节点用两个 64 位字比较整段前缀，一次查找只走过“有规则或有分叉”的节点。
+ * 判定按最长前缀匹配：更具体的规则优先（deny 10.0.0.0/8 + allow 10.1.2.0/24 即放行后者）；
+ * 同一前缀同时出现在两个列表时 deny 优先。都不匹配时返回 None，按普通连接处理。
+ * allow 命中的 IP 视为可信，跳过 IpLimiter 的连接数 / QPS 限制（ipLimit.whitelist 中的精确 IP 按 /32、/128 并入 allow）。
+ * 每条规则单独计数命中次数。规则集以不可变快照原子发布，reload 不阻塞查找，
+ * 被替换的快照等进行中的查找结束后即释放（EpochDomain）；内容相同的规则沿用原有计数。
+ */
+class IpAcl {
+  public:
+    enum class Verdict { None, Allow, Deny };
+
+    static IpAcl& Instance();
+
+    // 从 ipLimit 配置（allow/deny/whitelist）重新编译规则集；非法条目告警后跳过
+    void update(const IpLimitConfig& cfg);
+
+    // 最长前缀匹配，命中时累加该规则的计数
+    Verdict check(const IpKey& ip) const;
+
+    std::size_t ruleCount() const;
+
+    // 规则及命中数（文本，供 HTTP /acl 查看）
+    void print(std::ostream& os) const;
+    // server_ip_acl_hits_total{rule="...",action="allow|deny"}
+    void printPrometheus(std::ostream& os) const;
+
+  private:
+    IpAcl() = default;
+
+    struct Rule {
+        std::string cidr;  // 规范化后的文本，如 10.0.0.0/8
+        bool deny{false};
+        std::atomic<std::uint64_t>* hits{nullptr};  // 指向 counters_ 中的计数，reload 间共享
+    };
+
+    // 解析后的一条前缀（前缀按大端存成两个 64 位字，len 为 128 位空间中的长度）
+    struct Prefix {
+        std::uint64_t hi{0};
+        std::uint64_t lo{0};
+        std::uint32_t len{0};
+        bool deny{false};
+        std::string cidr;
+    };
+
+    // 压缩前缀树节点：前缀 = (hi, lo) 的高 len 位；child 为 kNil 表示没有该分支
+    struct Node {
+        std::uint64_t hi{0};
+        std::uint64_t lo{0};
+        std::uint32_t len{0};
+        std::int32_t rule{-1};
+        std::uint32_t child[2]{kNil, kNil};
+    };
+
+    struct Table {
+        std::vector<Rule> rules;
+        std::vector<Node> nodes;  // nodes[0] 为根，为空表示没有规则
+    };
+
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    // 解析 "a.b.c.d/n"、"x:y::/n" 或单个 IP，非法返回 false
+    static bool ParsePrefix(const std::string& text, bool deny, Prefix& out);
+    // 把前缀集合编译成压缩前缀树（需持有 updateMtx_，计数从 counters_ 取）
+    std::unique_ptr<Table> compile(std::vector<Prefix> prefixes);
+
+    // 查找路径需在 EpochDomain::ReadGuard 内调用；持有 updateMtx_ 时快照不会被替换
+    const Table* table() const { return table_.load(std::memory_order_acquire); }
+
+    std::atomic<const Table*> table_{nullptr};
+    EpochDomain epoch_;
+
+    mutable std::mutex updateMtx_;  // 串行化 reload，并保护 current_ / counters_
+    std::unique_ptr<const Table> current_;  // table_ 指向的快照
+    // 计数按“动作 + 规则文本”复用，reload 后 Prometheus 计数保持单调
+    std::unordered_map<std::string, std::unique_ptr<std::atomic<std::uint64_t>>> counters_;
+};
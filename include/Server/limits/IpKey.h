@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <boost/asio/ip/address.hpp>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 定长二进制 IP 键：IPv4 统一映射为 ::ffff:a.b.c.d，与 IPv6 共用 16 字节表示。
+ * @details 替代以 std::string 作为 IP 状态表的键：比较/哈希只是两个 64 位字，不分配内存；
+ *          同一地址的 IPv4 与 IPv4-mapped IPv6 写法得到同一个键。
+ */
+struct IpKey {
+    std::array<std::uint8_t, 16> bytes{};
+
+    static IpKey FromAddress(const boost::asio::ip::address& addr) {
+        IpKey key;
+        if (addr.is_v4()) {
+            key.bytes = boost::asio::ip::make_address_v6(boost::asio::ip::v4_mapped, addr.to_v4()).to_bytes();
+        } else {
+            key.bytes = addr.to_v6().to_bytes();
+        }
+        return key;
+    }
+
+    // 解析文本形式的 IPv4/IPv6 地址，非法返回 nullopt
+    static std::optional<IpKey> Parse(std::string_view text) {
+        boost::system::error_code ec;
+        auto addr = boost::asio::ip::make_address(std::string(text), ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        return FromAddress(addr);
+    }
+
+    bool isV4() const {
+        static constexpr std::uint8_t kV4Prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+        return std::memcmp(bytes.data(), kV4Prefix, sizeof(kV4Prefix)) == 0;
+    }
+
+    std::string toString() const {
+        if (isV4()) {
+            return boost::asio::ip::address_v4({bytes[12], bytes[13], bytes[14], bytes[15]}).to_string();
+        }
+        return boost::asio::ip::address_v6(bytes).to_string();
+    }
+
+    std::uint64_t hi() const {
+        std::uint64_t v;
+        std::memcpy(&v, bytes.data(), sizeof(v));
+        return v;
+    }
+    std::uint64_t lo() const {
+        std::uint64_t v;
+        std::memcpy(&v, bytes.data() + 8, sizeof(v));
+        return v;
+    }
+
+    bool operator==(const IpKey& other) const { return bytes == other.bytes; }
+    bool operator!=(const IpKey& other) const { return bytes != other.bytes; }
+};
+
+struct IpKeyHash {
+    std::size_t operator()(const IpKey& key) const noexcept {
+        // 两个字混合后做一次 murmur 风格的末端扰动，低位和高位都分布均匀（高位用于选分片）
+        std::uint64_t h = key.hi() * 0x9E3779B97F4A7C15ULL ^ key.lo();
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+};
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
+
+#include "EpochDomain.h"
+#include "IpKey.h"
 
 struct IpLimitConfig;
 
@@ -13,51 +19,86 @@ struct IpLimitConfig;
  *
  * 目标：防止单个 IP 的连接洪泛或高频请求压垮服务。
  * 特性：
- *  - 白名单：跳过限流。
  *  - 连接数限制：accept 阶段拒绝超限连接。
- *  - QPS 限制：秒级窗口计数，超限直接拒绝该帧。
- *  - 状态 TTL：按最近访问时间懒触发 GC，避免状态无限增长。
- * 线程安全：内部加锁，所有接口可并发调用。
+ *  - QPS 限制：GCRA 平滑限速（maxQpsPerIp 为稳态速率，qpsBurst 为允许的突发），超限直接拒绝该帧。
+ *  - 状态 TTL：每个分片按创建顺序维护一条到期队列，每次访问顺带检查队头的少量元素，
+ *    增量清理长时间无访问且无连接的 IP，不做整表扫描。
+ * 状态以 16 字节二进制 IP（IpKey）为键，按哈希分到 kShards 个缓存行对齐的分片，每个分片一把锁；
+ * 阈值以不可变快照原子发布，判定路径不碰全局锁；被替换的快照等进行中的判定结束后即释放。
+ * 白名单 / 可信网段由 IpAcl 在 accept 阶段判定，可信连接不经过本限流器。
+ * 线程安全：所有接口可并发调用。
  */
 class IpLimiter {
   public:
     // 获取单例
     static IpLimiter& Instance();
 
-    // 从配置更新限流阈值/白名单/TTL
+    // 从配置更新限流阈值/TTL
     void updateConfig(const IpLimitConfig& cfg);
 
     // 检查并计数：是否允许新连接
-    bool allowConn(const std::string& ip);
+    bool allowConn(const IpKey& ip);
     // 连接关闭时归还计数
-    void onConnClose(const std::string& ip);
+    void onConnClose(const IpKey& ip);
 
     // 检查并计数：是否允许当前请求（QPS）
-    bool allowQps(const std::string& ip);
+    bool allowQps(const IpKey& ip);
 
     // 获取某 IP 当前连接数（仅用于观测/测试）
+    std::size_t connCount(const IpKey& ip) const;
+
+    // 文本 IP 版本（解析失败时放行 / 视为 0）
+    bool allowConn(const std::string& ip);
+    void onConnClose(const std::string& ip);
+    bool allowQps(const std::string& ip);
     std::size_t connCount(const std::string& ip) const;
 
   private:
-    // 根据 TTL 触发一次状态清理（懒触发，避免频繁扫描）
-    void gcIfNeeded(std::uint64_t nowSec);
-    // 记录 IP 最近访问时间（用于 GC 判定）
-    void touch(const std::string& ip, std::uint64_t nowSec);
-
     IpLimiter() = default;
 
-    struct QpsState {
-        std::uint64_t windowSec{0};   // 当前秒级窗口
-        std::size_t count{0};         // 窗口内计数
-        std::uint64_t lastAccess{0};  // 最近访问时间（秒）
+    // 一份生效中的配置（发布后不再修改）
+    struct Settings {
+        std::size_t maxConnPerIp{0};  // 每 IP 最大连接数
+        std::int64_t emissionNs{0};   // 每个请求消耗的时间额度 = 1s / maxQpsPerIp，0 表示不限 QPS
+        std::int64_t toleranceNs{0};  // 允许的突发额度 = emissionNs * burst
+        std::int64_t ttlNs{0};        // 状态 TTL，0 表示不清理
     };
 
-    mutable std::mutex mtx_;                          // 保护内部状态
-    std::unordered_set<std::string> whitelist_;       // 白名单 IP
-    std::size_t maxConnPerIp_{0};                     // 每 IP 最大连接数
-    std::size_t maxQpsPerIp_{0};                      // 每 IP 最大 QPS
-    std::uint64_t stateTtlSec_{300};                  // 状态 TTL（秒）
-    std::uint64_t lastGcSec_{0};                      // 上次 GC 时间（秒）
-    std::unordered_map<std::string, std::size_t> connCount_;  // IP → 连接数
-    std::unordered_map<std::string, QpsState> qpsCount_;      // IP → QPS 状态
+    struct State {
+        std::size_t conns{0};          // 当前连接数
+        std::int64_t tatNs{0};         // GCRA 理论到达时间
+        std::int64_t lastAccessNs{0};  // 最近访问时间（用于 TTL 判定）
+    };
+
+    // 到期队列元素：stampNs 是入队时该 IP 的最近访问时间，stampNs + ttl 之前不用去查状态表
+    struct Expiry {
+        IpKey ip;
+        std::int64_t stampNs;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<IpKey, State, IpKeyHash> states;
+        std::deque<Expiry> expiry;  // 按 stampNs 近似有序
+    };
+
+    static constexpr std::size_t kShardBits = 6;
+    static constexpr std::size_t kShards = std::size_t{1} << kShardBits;
+    static constexpr std::size_t kGcPerCall = 2;  // 每次访问最多顺带检查的到期队列元素数
+
+    // 需在 EpochDomain::ReadGuard 内调用
+    const Settings* settings() const { return settings_.load(std::memory_order_acquire); }
+    Shard& shardFor(const IpKey& ip) const { return shards_[IpKeyHash{}(ip) >> (64 - kShardBits)]; }
+    // 在持有分片锁时取出（必要时创建）ip 的状态，并推进一步增量清理
+    State& stateFor(Shard& shard, const IpKey& ip, const Settings& s, std::int64_t now);
+    void gcStep(Shard& shard, const Settings& s, std::int64_t now);
+
+    static std::int64_t nowNs();
+
+    mutable Shard shards_[kShards];
+
+    std::atomic<const Settings*> settings_{nullptr};
+    EpochDomain epoch_;
+    std::mutex updateMtx_;  // 串行化配置更新，保护 current_
+    std::unique_ptr<const Settings> current_;  // settings_ 指向的快照
 };
@@ -1,26 +1,51 @@
 #pragma once
 
 #include <atomic>
+#include <boost/asio/awaitable.hpp>
 #include <chrono>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
+#include "AsyncSemaphore.h"
 #include "Config.h"
+#include "EpochDomain.h"
 
 // 按 msgType 做限流：
 //   - maxConcurrent：同时在处理的请求数
-//   - maxQps：简单的“每秒最多请求数”，滑窗粒度为 1 秒
-// 内部自己维护 per-msg 的计数 & 简单统计。
+//   - maxQps + burst：令牌桶（以 GCRA 实现：每个桶只有一个原子“理论到达时间”，CAS 推进）
+//   - maxQueue + queueTimeoutMs：并发满时不直接拒绝，在有界 FIFO 中挂起等待名额（AsyncSemaphore），
+//     超时或队列已满才拒绝
+// 状态是按 msgType 下标的扁平表：65536 个槽位分 256 页，页在首次用到时无锁安装；
+// 每个槽位独占缓存行，allow/onFinish 只做原子操作，不加锁。
+// 配置以不可变快照按槽位原子发布，更新不阻塞正在判定的请求；被替换的快照等进行中的判定结束后即释放。
 class MessageLimiter {
   public:
     MessageLimiter() = default;
+    ~MessageLimiter();
+
+    MessageLimiter(const MessageLimiter&) = delete;
+    MessageLimiter& operator=(const MessageLimiter&) = delete;
 
     // 从 Config 加载一份 msgType 的限流策略
     void updateFromConfig(const Config& cfg);
+    // 直接按 msgType -> 策略更新（未列出的 msgType 保持原策略）
+    void update(const std::unordered_map<std::uint16_t, MsgLimitConfig>& limits);
+
+    enum class Verdict {
+        Accept,  // 放行（设置了 maxConcurrent 时已占用一个并发名额）
+        Reject,
+        Queue,   // QPS 已通过但并发已满，且该 msgType 允许排队：调用 waitForSlot 等待名额
+    };
 
-    // 判断是否允许这个 msgType 通过（不做并发计数自增）
+    // 判定这个 msgType 能否通过，不等待
+    Verdict admit(std::uint16_t msgType);
+    // admit 返回 Queue 后挂起等待并发名额；超时或队列已满返回 false（同时计为拒绝）
+    boost::asio::awaitable<bool> waitForSlot(std::uint16_t msgType);
+
+    // 判断是否允许这个 msgType 通过，需要排队的也视为拒绝（设置了 maxConcurrent 时通过即占用一个并发名额）
     bool allow(std::uint16_t msgType);
 
     // 请求执行结束（handler 返回后调用）
@@ -30,32 +55,52 @@ class MessageLimiter {
         std::uint64_t accepted = 0;
         std::uint64_t dropped = 0;
         std::uint64_t concurrent = 0;
+        std::uint64_t queued = 0;
         std::uint64_t qps = 0;
     };
 
     States getStats(std::uint16_t msgType) const;
 
   private:
-    struct PerMsgState {
-        MsgLimitConfig cfg;
-        std::atomic<int> concurrent{0};
-
-        std::mutex mtx;                      // 保护 tokens/lastRefillNs
-        double tokens{0};                       // 当前令牌数
-        std::int64_t lastRefillNs{0};        // 上次补充时间（纳秒）
+    // 一份生效中的策略（发布后不再修改）
+    struct Limit {
+        bool enabled{false};
+        std::int64_t emissionNs{0};   // 每个请求消耗的时间额度 = 1s / maxQps，0 表示不限 QPS
+        std::int64_t toleranceNs{0};  // 允许的突发额度 = emissionNs * burst
+        int maxConcurrent{0};
+        int maxQueue{0};  // > 0 时并发满的请求排队等待
+    };
 
+    struct alignas(64) Bucket {
+        std::atomic<const Limit*> limit{nullptr};  // nullptr = 未配置，直接放行
+        std::atomic<std::int64_t> tatNs{0};         // GCRA 理论到达时间：tat - now 即已透支的额度
+        std::atomic<int> concurrent{0};
+        // 配置过排队的 msgType 才有；一旦创建，并发名额改由它计数（不再用 concurrent）
+        std::atomic<AsyncSemaphore*> sem{nullptr};
         std::atomic<std::uint64_t> accepted{0};
         std::atomic<std::uint64_t> dropped{0};
     };
 
-    using StatePtr = std::shared_ptr<PerMsgState>;
+    static constexpr std::size_t kPageBits = 8;
+    static constexpr std::size_t kPageSize = std::size_t{1} << kPageBits;
+    static constexpr std::size_t kPages = 65536 / kPageSize;
 
-    StatePtr getState(std::uint16_t msgType) const;
-    StatePtr getOrCreateState(std::uint16_t msgType);
+    // 取 msgType 的槽位；页不存在时 create=false 返回 nullptr，create=true 则无锁安装一页
+    Bucket* bucket(std::uint16_t msgType, bool create) const;
+
+    // 并发检查失败：计入拒绝并回滚已扣掉的 QPS 额度（emissionNs 为判定时扣掉的那份）
+    static void rejectConcurrent(Bucket* b, std::int64_t emissionNs);
+    // 当前策略的 emissionNs（未配置为 0），读取后不再持有快照，可跨协程挂起点使用
+    std::int64_t emissionOf(Bucket* b) const;
 
     static std::int64_t nowNs();
 
   private:
-    mutable std::mutex mtx_;
-    std::unordered_map<std::uint16_t, StatePtr> states_;
+    mutable std::atomic<Bucket*> pages_[kPages]{};
+
+    // 读 Bucket::limit 的区间（不跨挂起点）在 epoch_ 的 ReadGuard 内，更新时据此回收被替换的策略
+    EpochDomain epoch_;
+    std::mutex updateMtx_;
+    std::unordered_map<std::uint16_t, std::unique_ptr<const Limit>> limits_;  // 各槽位当前策略
+    std::vector<std::unique_ptr<AsyncSemaphore>> sems_;  // 每个配置过排队的 msgType 一个，创建后不替换
 };
@@ -3,17 +3,21 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Counter {
   public:
     Counter();
     void inc(std::int64_t n = 1);
+    void set(std::int64_t v);  // Gauge 直接覆盖
     std::int64_t value() const;
     std::int64_t fetchAdd(std::int64_t n);
 
@@ -49,6 +53,48 @@ class LatencyMetric {
     std::atomic<std::uint64_t> buckets_[5];
 };
 
+// 通用直方图：桶上界在构造时给定（升序），末尾隐含 +Inf 桶
+// shards > 1 时按线程分片计数（每片独占缓存行，线程固定落在某一片），多线程高频 observe 不争用同一缓存行，导出时汇总
+class Histogram {
+  public:
+    struct Snapshot {
+        std::uint64_t count;
+        double sum;
+        std::vector<std::uint64_t> buckets;  // 与 bounds 对应，最后一个为 +Inf（非累计）
+    };
+
+    explicit Histogram(std::vector<double> bounds, std::size_t shards = 1);
+
+    void observe(double v);
+
+    Snapshot snapshot() const;
+    const std::vector<double>& bounds() const;
+
+    void print(const std::string& name, std::ostream& os) const;
+    // labels 形如 prio="high"，为空则不带标签；同名多组标签时只有第一组输出 TYPE 行
+    void printPrometheus(const std::string& name, std::ostream& os, const std::string& labels = "", bool withType = true) const;
+
+  private:
+    // 一个分片：buckets[bounds+1] + count + sum（double 的位模式），按缓存行对齐
+    struct alignas(64) Line {
+        std::atomic<std::uint64_t> v[8];
+    };
+    std::atomic<std::uint64_t>* shard(std::size_t i) const;
+
+    std::vector<double> bounds_;
+    std::size_t shards_;
+    std::size_t lines_;  // 每个分片占用的缓存行数
+    std::unique_ptr<Line[]> data_;
+};
+
+// 单个监听 acceptor 的接入统计（SO_REUSEPORT 多 acceptor 时按序号区分）
+struct AcceptorStats {
+    Counter accepted;    // 累计接入连接数（Prometheus 侧 rate() 即接入速率）
+    Counter wakeups;     // async_accept 唤醒次数（accepted / wakeups = 平均每次唤醒批量接入数）
+    Counter backlog;     // 最近一次观测到的内核 accept 队列长度（Gauge）
+    Counter backlogMax;  // 内核 accept 队列上限（Gauge）
+};
+
 // 全局 Metrics 单例：后面要什么指标往里加就行
 class MetricsRegistry {
   public:
@@ -68,11 +114,33 @@ class MetricsRegistry {
     Counter& inflightRejects();            // 因 in-flight 超限被拒绝的次数
     Counter& tokenRejects();               // 令牌桶拒绝次数
     Counter& concurrentRejects();          // 并发超限拒绝次数
+    Counter& limitQueueDepth();            // 按 msgType 限流时正在排队等并发名额的请求数（Gauge）
+    Counter& limitQueueTimeouts();         // 排队等待超时被拒绝的次数
+    Counter& limitQueueFull();             // 排队队列已满被拒绝的次数
+    Histogram& limitQueueWaitMs();         // 排队等待并发名额的时间（ms，含超时的请求）
     Counter& sendQueueMaxBytes();          // 观察到的单连接发送队列峰值（bytes，Gauge）
     Counter& workerQueueSize();            // worker 队列长度（Gauge）
     Counter& workerLiveThreads();          // worker 线程活跃数量（Gauge）
+    Counter& workerTargetThreads();        // 自动伸缩给出的目标线程数（Gauge）
+    Counter& workerQueueWaitP99Us();       // 最近一个采样周期的排队等待 p99（us，Gauge）
+    Counter& workerUtilizationPct();       // 最近一个采样周期的线程利用率（%，Gauge）
+    Counter& workerCpuPct();               // 执行任务时间中 CPU 时间的占比（%，Gauge；低说明任务多在阻塞）
+    Counter& workerCpuUsagePct();          // 工作线程总 CPU 用量（%，100 = 一个核，Gauge）
+    Counter& workerScaleUps();             // 自动伸缩扩容次数
+    Counter& workerScaleDowns();           // 自动伸缩缩容次数
+    Counter& workerScaleHeld();            // 等待超标但 CPU 已饱和（或计算密集且线程数已达核数）、放弃扩容的次数
+    Counter& workerSpinHits();             // 工作线程休眠前自旋期间等到新任务的次数（省掉一次休眠/唤醒）
+    Counter& workerParks();                // 工作线程进入休眠（cv 等待）的次数
+    Histogram& workerTaskWaitUs(int pri);  // 线程池任务排队等待时间（us，按 TaskPriority 下标）
+    Histogram& workerTaskRunUs(int pri);   // 线程池任务执行时间（us，按 TaskPriority 下标）
     Counter& ipRejectConn();               // IP 连接拒绝计数
     Counter& ipRejectQps();                // IP QPS 拒绝计数
+    Counter& ipTrackedStates();            // IpLimiter 当前跟踪的 IP 数（Gauge）
+    Counter& ipStatesExpired();            // IpLimiter 增量清理掉的过期 IP 状态数
+    Counter& ipAclRejects();               // 命中 IpAcl deny 规则、accept 后直接关闭的连接数
+    Counter& zeroCopySends();              // 以 MSG_ZEROCOPY 发出的 send 调用数
+    Counter& zeroCopyCompleted();          // 内核确认真正零拷贝完成的 send 数（命中）
+    Counter& zeroCopyFallbacks();          // 回退为拷贝的次数（内核拷贝 / 开启失败 / ENOBUFS）
     void incIpRejectConn();
     void incIpRejectQps();
     void setTokenRejectTrace(const std::string& traceId, const std::string& sessionId);
@@ -88,6 +156,11 @@ class MetricsRegistry {
     void incMsgReject(std::uint16_t msgType);
 
     LatencyMetric& frameLatency();  // 每帧处理耗时（从 Codec 调用 handler 到返回）
+    Histogram& readBytes();         // 每次 socket 读取的字节数
+    Histogram& writeFrames();       // 每次写合并的帧数
+    Histogram& writeBytes();        // 每次写的字节数
+
+    AcceptorStats& acceptorStats(std::size_t idx);  // 第 idx 个 acceptor 的统计（按需创建，引用长期有效）
 
     void onBackpressureEnter();
     void onBackpressureExit();
@@ -112,11 +185,30 @@ class MetricsRegistry {
     Counter inflightRejects_;
     Counter workerQueueSize_;
     Counter workerLiveThreads_;
+    Counter workerTargetThreads_;
+    Counter workerQueueWaitP99Us_;
+    Counter workerUtilizationPct_;
+    Counter workerCpuPct_;
+    Counter workerCpuUsagePct_;
+    Counter workerScaleUps_;
+    Counter workerScaleDowns_;
+    Counter workerScaleHeld_;
+    Counter workerSpinHits_;
+    Counter workerParks_;
     Counter ipRejectConn_;
     Counter ipRejectQps_;
+    Counter ipTrackedStates_;
+    Counter ipStatesExpired_;
+    Counter ipAclRejects_;
     Counter tokenRejects_;
     Counter concurrentRejects_;
+    Counter limitQueueDepth_;
+    Counter limitQueueTimeouts_;
+    Counter limitQueueFull_;
     Counter sendQueueMaxBytes_;
+    Counter zeroCopySends_;
+    Counter zeroCopyCompleted_;
+    Counter zeroCopyFallbacks_;
     mutable std::mutex exemplarMtx_;
     std::string lastTokenRejectTrace_;
     std::string lastTokenRejectSession_;
@@ -151,4 +243,18 @@ class MetricsRegistry {
     std::unordered_map<std::uint16_t, std::atomic<std::uint64_t>> msgRejects_;
 
     LatencyMetric frameLatency_;
+    Histogram readBytes_{{256, 1024, 4096, 16384, 65536, 262144, 1048576}};
+    Histogram writeFrames_{{1, 2, 4, 8, 16, 32, 64, 128, 256}};
+    Histogram writeBytes_{{256, 1024, 4096, 16384, 65536, 262144, 1048576}};
+    Histogram limitQueueWaitMs_{{0.1, 0.5, 1, 5, 10, 50, 100, 500, 1000, 5000}};
+    // 每个任务都要记录两次，按线程分片
+    static std::vector<double> TaskTimeBoundsUs() { return {10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000, 100000, 500000, 1000000}; }
+    static constexpr std::size_t kTaskTimeShards = 16;
+    Histogram workerTaskWaitUs_[3]{Histogram(TaskTimeBoundsUs(), kTaskTimeShards), Histogram(TaskTimeBoundsUs(), kTaskTimeShards),
+                                   Histogram(TaskTimeBoundsUs(), kTaskTimeShards)};
+    Histogram workerTaskRunUs_[3]{Histogram(TaskTimeBoundsUs(), kTaskTimeShards), Histogram(TaskTimeBoundsUs(), kTaskTimeShards),
+                                  Histogram(TaskTimeBoundsUs(), kTaskTimeShards)};
+
+    mutable std::mutex acceptorMtx_;
+    std::deque<AcceptorStats> acceptors_;  // deque 扩容不移动已有元素，引用可长期持有
 };
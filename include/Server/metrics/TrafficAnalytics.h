@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IpKey.h"
+
+struct AnalyticsConfig;
+
+/**
+ * @brief 固定内存的流量分析：按分钟窗口统计 Top-K 源 IP / 会话（按帧数、按字节数）与去重 IP / 会话数。
+ *
+ * - Top-K：SpaceSaving（最小堆 + 开放寻址索引，容量 capacity 个键，计数为上界并带误差界）。
+ *   前面加一层 Count-Min（depth x width 计数矩阵）过滤：新键的估计值不超过堆中最小计数时不必顶替，
+ *   长尾流量大多只付一次查表；报告的估计值再与 Count-Min 取较小值，同时给出保证下界。
+ * - 去重数：HyperLogLog（2^hllPrecision 个寄存器，相对误差约 1.04 / sqrt(2^p)）。
+ *
+ * 由 Codec 在 I/O 线程上调用：一次读取里同一连接解出的帧先在本地累加，整批只调用一次 record，
+ * 逐帧开销只是两次加法。每个 I/O 线程一份草图（线程首次调用时登记，锁只在本线程与查询之间竞争），
+ * 查询时把各线程的草图合并：HLL 取寄存器最大值，Count-Min 逐格相加，SpaceSaving 按键合并误差界。
+ * 每份草图保留当前与上一分钟两个窗口，内存与键的数量无关。
+ */
+class TrafficAnalytics {
+  public:
+    struct HeavyHitter {
+        std::string key;          // IP 文本或 sessionId
+        std::uint64_t estimate;   // 估计值（不小于真实值）
+        std::uint64_t lowerBound; // 保证下界
+    };
+
+    struct WindowReport {
+        std::int64_t minute{0};  // Unix 时间 / 60
+        std::uint64_t frames{0};
+        std::uint64_t bytes{0};
+        std::uint64_t uniqueIps{0};
+        std::uint64_t uniqueSessions{0};
+        std::vector<HeavyHitter> ipsByFrames;
+        std::vector<HeavyHitter> ipsByBytes;
+        std::vector<HeavyHitter> sessionsByFrames;
+        std::vector<HeavyHitter> sessionsByBytes;
+    };
+
+    static TrafficAnalytics& Instance();
+
+    // 需在服务启动（产生流量）之前调用
+    void configure(const AnalyticsConfig& cfg);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 一次读取中某连接解出 frames 帧、共 bytes 字节（含帧头）
+    void record(const std::optional<IpKey>& ip, std::string_view session, std::uint32_t frames, std::uint64_t bytes);
+    // 同上，显式指定所属分钟（回放 / 基准用）
+    void recordAt(std::int64_t minute, const std::optional<IpKey>& ip, std::string_view session, std::uint32_t frames, std::uint64_t bytes);
+
+    static std::int64_t MinuteNow();
+    // 合并所有 I/O 线程在该分钟的数据（只保留当前与上一分钟，更早的返回空报告）
+    WindowReport report(std::int64_t minute) const;
+
+    // 当前分钟与上一分钟的文本报告（供 HTTP /traffic 查看）
+    void print(std::ostream& os) const;
+    // server_traffic_unique_ips / server_traffic_unique_sessions（上一个完整分钟）
+    void printPrometheus(std::ostream& os) const;
+
+  private:
+    TrafficAnalytics();
+    ~TrafficAnalytics();
+
+    struct Local;
+    Local& local();
+
+    std::atomic<bool> enabled_{false};
+    std::size_t topK_{20};
+    std::size_t capacity_{256};
+    std::uint32_t hllPrecision_{12};
+
+    mutable std::mutex regMtx_;
+    std::vector<std::unique_ptr<Local>> locals_;  // 每个调用过 record 的线程一份，随单例析构
+};
@@ -1,7 +1,25 @@
 #pragma once
 
+#include <unordered_set>
+
 #include "Config.h"
 #include "MessageRouter.h"
 
+// 背压阶段：本连接暂停读或全局背压连接数超阈值时，丢弃低优先级消息（白名单除外）
+class BackpressureStage {
+  public:
+    explicit BackpressureStage(const BackpressureConfig& cfg);
+
+    // 配置未开启低优先级拒绝时整段跳过
+    bool enabled() const { return enabled_; }
+    bool enter(MessageContext& ctx) const;
+
+  private:
+    bool enabled_{false};
+    std::unordered_set<std::uint16_t> lowPri_;
+    std::unordered_set<std::uint16_t> allow_;
+    std::size_t globalThreshold_{0};
+};
+
 // 构建背压拒绝低优先级消息的中间件（协程版）
 CoMiddleware BuildBackpressureMiddleware(const Config& cfg);
@@ -3,5 +3,17 @@
 #include "Config.h"
 #include "MessageRouter.h"
 
+// 日志阶段：debug/trace 级别时打印每条消息
+class LoggingStage {
+  public:
+    explicit LoggingStage(const LogConfig& cfg);
+
+    bool enabled() const { return enabled_; }
+    bool enter(MessageContext& ctx) const;
+
+  private:
+    bool enabled_{false};
+};
+
 // 简单日志中间件（按配置开启）
 CoMiddleware BuildLoggingMiddleware(const Config& cfg);
@@ -3,4 +3,16 @@
 #include "MessageRouter.h"
 #include "MessageLimiter.h"
 
+// 预留的“鉴权/会话校验”阶段（现在是空壳，内联后不产生代码）
+struct AuthStage {
+    bool enter(MessageContext& /*ctx*/) const {
+        // TODO: 将来在这里做：
+        //  - 解析 token / session
+        //  - 从 ctx.conn 的某个 userData 里拿用户信息
+        //  - 没权限就 return false
+        return true;
+    }
+};
+
+// 按固定顺序（限流 -> 背压 -> 日志 -> 鉴权）把内置中间件编译成一条融合管线装到 router 上
 void RegisterMiddlewares(MessageRouter& router, const Config& cfg);
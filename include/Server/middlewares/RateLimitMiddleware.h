@@ -3,6 +3,23 @@
 #include "Config.h"
 #include "MessageLimiter.h"
 #include "MessageRouter.h"
+#include "MiddlewarePipeline.h"
+
+// 按 msgType 限流阶段：放行的消息占用一个并发名额，leave 时归还；
+// 配置了 maxQueue 的 msgType 并发满时返回 Wait，在 wait 中挂起排队
+class RateLimitStage {
+  public:
+    explicit RateLimitStage(std::shared_ptr<MessageLimiter> limiter);
+
+    Admission enter(MessageContext& ctx) const;
+    boost::asio::awaitable<bool> wait(MessageContext& ctx) const;
+    void leave(MessageContext& ctx) const;
+
+  private:
+    static void onReject(const MessageContext& ctx);
+
+    std::shared_ptr<MessageLimiter> limiter_;
+};
 
 // 构建按 msgType 限流的中间件（协程版）
 CoMiddleware BuildRateLimitMiddleware(const Config& cfg, std::shared_ptr<MessageLimiter> limiter);
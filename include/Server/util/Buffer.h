@@ -19,6 +19,8 @@ class Buffer {
     size_t readableBytes() const;
     size_t writableBytes() const;
     size_t prependableBytes() const;
+    // 当前底层存储大小
+    size_t capacity() const;
 
     const char* peek() const;
 
@@ -43,7 +45,7 @@ class Buffer {
     // 更新写入位置
     void hasWritten(size_t len);
 
-    // 收缩缓冲区空间
+    // 收缩缓冲区空间（无可读数据时释放全部存储）
     void shrinkToFit();
 
   private:
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 原子发布的只读快照的安全回收（两段 epoch 的简化 RCU）。
+ * @details 读者用 ReadGuard 包住“取快照指针 → 用完”的区间：进出时在当前 epoch 的计数上加减，
+ *          计数按线程分条、各占一条缓存行，读路径只碰本线程那条，不加锁、不分配。
+ *          写者先发布新快照，再调用 synchronize()：翻转 epoch 并等旧 epoch 的读者全部离开，
+ *          返回后被替换的快照已不可能再被读到，可以立即释放。
+ *          读区间必须很短且不能跨越协程挂起点（恢复后可能在别的线程上）；synchronize 会自旋等待，只用于配置更新这类冷路径。
+ */
+class EpochDomain {
+  public:
+    class ReadGuard {
+      public:
+        explicit ReadGuard(const EpochDomain& domain) {
+            const std::size_t stripe = ThreadStripe();
+            // 先登记再读快照：synchronize 若没看到这次登记，本读者必然读到已发布的新快照
+            const std::uint32_t epoch = domain.epoch_.load(std::memory_order_seq_cst) & 1u;
+            counter_ = &domain.readers_[epoch][stripe].count;
+            counter_->fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~ReadGuard() { counter_->fetch_sub(1, std::memory_order_release); }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+      private:
+        std::atomic<std::int64_t>* counter_;
+    };
+
+    // 写侧：调用前已把新快照发布出去；返回时在此之前进入的读区间都已结束。
+    // 翻转两次、两个 epoch 各等一遍：翻转前读到旧 epoch、翻转后才登记的读者也会被下一轮等到
+    void synchronize() {
+        std::lock_guard<std::mutex> lock(syncMtx_);
+        for (int round = 0; round < 2; ++round) {
+            const std::uint32_t old = epoch_.fetch_xor(1u, std::memory_order_seq_cst) & 1u;
+            for (auto& stripe : readers_[old]) {
+                while (stripe.count.load(std::memory_order_seq_cst) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+  private:
+    static constexpr std::size_t kStripes = 64;
+
+    struct alignas(64) Stripe {
+        std::atomic<std::int64_t> count{0};
+    };
+
+    static std::size_t ThreadStripe() {
+        static std::atomic<std::size_t> next{0};
+        thread_local const std::size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+        return stripe;
+    }
+
+    std::atomic<std::uint32_t> epoch_{0};
+    mutable Stripe readers_[2][kStripes];
+    std::mutex syncMtx_;  // 同时只有一次翻转，避免两个写者互相把 epoch 翻回去
+};
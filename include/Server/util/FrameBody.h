@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 入站帧 body 的引用计数视图。
+ * @details 引用池化读缓冲（或接管的一块独立内存）中的字节，拷贝 FrameBody 只增加引用计数，不拷贝数据；
+ *          持有期间底层存储不会被释放或复用。可隐式转换为 std::string_view。
+ */
+class FrameBody {
+  public:
+    FrameBody() = default;
+
+    // 引用 owner 所管理内存中的 [data, data + size)
+    FrameBody(std::shared_ptr<const void> owner, const char* data, std::size_t size) : owner_(std::move(owner)), data_(data), size_(size) {}
+
+    // 接管一个 string（移动，不拷贝字节）
+    static FrameBody adopt(std::string s) {
+        auto holder = std::make_shared<const std::string>(std::move(s));
+        const char* p = holder->data();
+        std::size_t n = holder->size();
+        return FrameBody(std::move(holder), p, n);
+    }
+
+    // 拷贝一份独立数据（小 body 或来源不可持有时使用）
+    static FrameBody copyOf(std::string_view s) { return adopt(std::string(s)); }
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+    operator std::string_view() const { return view(); }  // NOLINT: 有意允许隐式转换，兼容 string_view 形参
+    std::string str() const { return std::string(data_, size_); }
+
+  private:
+    std::shared_ptr<const void> owner_;
+    const char* data_{nullptr};
+    std::size_t size_{0};
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Config.h"
+
+// Asio 的 socket 后端在编译期决定（epoll / io_uring），无法在同一进程内切换。
+// 这里负责在启动早期（创建任何 io_context 之前）确认后端可用：
+//   - io_uring 构建但内核不支持：exec 到同目录的 epoll 构建继续运行（干净回退）；
+//   - 配置要求 io_uring 而当前为 epoll 构建：若同目录有 io_uring 构建且内核支持，则 exec 过去。
+namespace IoBackend {
+    // 当前二进制编译进的后端："io_uring" 或 "epoll"
+    const char* compiled();
+    // 内核是否支持 io_uring（直接探测 io_uring_setup 系统调用，seccomp/容器禁用时同样返回 false）
+    bool kernelSupportsIoUring();
+    // 按配置选择后端；需要切换时 exec 兄弟二进制（成功则不返回）。返回 false 表示当前进程不可继续运行。
+    bool select(const ServerConfig& sc, char** argv);
+}  // namespace IoBackend
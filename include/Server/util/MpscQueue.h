@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief 无锁多生产者单消费者队列（Vyukov 非侵入式链表）。
+ * @details push 只有一次 exchange + 一次 store，任意线程可并发调用；pop/empty 只能由唯一的消费者调用。
+ *          生产者在 exchange 与链接 next 之间被抢占时，pop 会暂时返回 false 而 empty() 返回 false，
+ *          消费者据此稍后重试即可。
+ */
+template <typename T>
+class MpscQueue {
+  public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T tmp;
+        while (pop(tmp)) {
+        }
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 生产者：入队
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        // seq_cst：消费者清除“写协程已调度”标记后再看 head_，必须能看到这里的入队
+        Node* prev = head_.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 消费者：出队，队列空或生产者尚未完成链接时返回 false
+    bool pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        out = std::move(next->value);
+        tail_ = next;  // next 成为新的哨兵，其 value 已被移走
+        delete tail;
+        return true;
+    }
+
+    // 消费者：是否为空（包含“已入队但未链接完成”的元素时返回 false）
+    bool empty() const { return head_.load(std::memory_order_seq_cst) == tail_; }
+
+  private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    static constexpr std::size_t kCacheLine = 64;  // 生产者/消费者两端分开缓存行，避免伪共享
+
+    alignas(kCacheLine) std::atomic<Node*> head_;  // 生产者端（最新入队的节点）
+    alignas(kCacheLine) Node* tail_;               // 消费者端（哨兵节点）
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief 只可移动的 void() 任务（线程池队列元素）。
+ * @details 与 std::function 相比：不要求可拷贝，因此闭包可以直接持有 move-only 资源；
+ *          闭包不超过 kInlineSize 且 nothrow 可移动时存放在对象内部的缓冲里，构造/移动/销毁都不分配堆内存，
+ *          更大的闭包退回堆上存放。典型的 weak_ptr + msgType + FrameBody 闭包走内联存储。
+ */
+class Task {
+  public:
+    static constexpr std::size_t kInlineSize = 96;
+
+    // 闭包类型 Fn 是否存放在内联缓冲（构造/移动/销毁不分配）；投递热路径上的任务类型可据此 static_assert
+    template <typename Fn>
+    static constexpr bool FitsInline() {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    Task() noexcept = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> && std::is_invocable_v<std::decay_t<F>&>>>
+    Task(F&& f) {  // NOLINT：允许 lambda 隐式转换
+        using Fn = std::decay_t<F>;
+        if constexpr (FitsInline<Fn>()) {
+            ::new (static_cast<void*>(buf_)) Fn(std::forward<F>(f));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            ::new (static_cast<void*>(buf_)) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept : ops_(other.ops_) {
+        if (ops_) {
+            ops_->move(buf_, other.buf_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops_) {
+                other.ops_->move(buf_, other.buf_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(buf_); }
+
+    // 销毁持有的闭包（闭包析构里的清理逻辑在此时执行）
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(buf_);
+            ops_ = nullptr;
+        }
+    }
+
+  private:
+    struct Ops {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;  // 移动到 dst 并销毁 src
+        void (*destroy)(void* self) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps{
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops kHeapOps{
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept { ::new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+    };
+
+    alignas(std::max_align_t) unsigned char buf_[kInlineSize];
+    const Ops* ops_{nullptr};
+};
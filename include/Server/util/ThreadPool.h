@@ -1,21 +1,113 @@
 #pragma once
 
+#include <atomic>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/execution.hpp>
+#include <boost/asio/execution_context.hpp>
+#include <boost/asio/post.hpp>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <ctime>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 #include "Metrics.h"
+#include "Task.h"
 enum class TaskPriority {
     High = 0,
     Normal = 1,
     Low = 2,
 };
 
-class ThreadPool {
+namespace threadpool_detail {
+    // 队列元素：任务 + 入队时刻与优先级，用于按优先级统计排队等待/执行时间
+    struct QueuedTask {
+        Task task;
+        std::int64_t enqueuedNs{0};
+        int pri{0};
+    };
+
+    // 只增不缩的环形任务队列：容量涨到峰值后 push/pop 不再分配（std::deque 会随块的进出反复分配释放）
+    class TaskRing {
+      public:
+        bool empty() const { return count_ == 0; }
+        std::size_t size() const { return count_; }
+
+        void push_back(QueuedTask item) {
+            if (count_ == slots_.size()) {
+                grow();
+            }
+            slots_[(head_ + count_) & (slots_.size() - 1)] = std::move(item);
+            ++count_;
+        }
+
+        QueuedTask pop_front() {
+            QueuedTask item = std::move(slots_[head_]);
+            head_ = (head_ + 1) & (slots_.size() - 1);
+            --count_;
+            return item;
+        }
+
+      private:
+        void grow() {
+            std::vector<QueuedTask> bigger(slots_.empty() ? 16 : slots_.size() * 2);
+            for (std::size_t i = 0; i < count_; ++i) {
+                bigger[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+            }
+            slots_.swap(bigger);
+            head_ = 0;
+        }
+
+        std::vector<QueuedTask> slots_;  // 容量恒为 2 的幂
+        std::size_t head_{0};
+        std::size_t count_{0};
+    };
+
+    // ThreadPool::schedule 的完成回调：在池线程上直接调用（协程就地在该线程恢复）；
+    // 投递失败（队列满/已停止）而未执行就被销毁时，退回 handler 自身的 executor 继续执行，协程不会丢失
+    template <typename Handler>
+    class ScheduleOp {
+      public:
+        explicit ScheduleOp(Handler handler) : handler_(std::move(handler)) {}
+        ScheduleOp(ScheduleOp&& other) noexcept : handler_(std::move(other.handler_)), armed_(std::exchange(other.armed_, false)) {}
+        ScheduleOp(const ScheduleOp&) = delete;
+
+        ~ScheduleOp() {
+            if (armed_) {
+                auto ex = boost::asio::get_associated_executor(handler_);
+                boost::asio::post(ex, std::move(handler_));
+            }
+        }
+
+        void operator()() {
+            armed_ = false;
+            std::move(handler_)();
+        }
+
+      private:
+        Handler handler_;
+        bool armed_{true};
+    };
+}  // namespace threadpool_detail
+
+/**
+ * @brief 工作窃取线程池。
+ * @details 每个工作线程一组本地队列（按优先级 High/Normal/Low 三条），各自一把小锁：
+ *          池内线程提交的任务进自己的队列，外部线程（I/O 线程等）轮转投到各工作线程的队列；
+ *          工作线程先取本地队列，空了再从随机起点依次窃取其他线程的队列。
+ *          只有空闲线程休眠/唤醒才经过全局 mutex_，提交与取任务不再全池串行；
+ *          已有线程被唤醒、正在找任务时提交不再唤醒新线程，由它取到任务后按需接力唤醒下一个。
+ *          优先级在单个队列内严格、跨队列尽力：本地没有 High 时才去窃取别人的 High。
+ */
+class ThreadPool : public boost::asio::execution_context {
   public:
+    class executor_type;
+
     explicit ThreadPool(std::size_t numThreads, std::size_t maxQueueSize = 0, std::size_t minThreads = 0, std::size_t maxThreads = 0);
     ~ThreadPool();
 
@@ -26,8 +118,45 @@ class ThreadPool {
     template <typename F, typename... Args>
     auto submit(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type>;
 
+    // 投递一个不关心结果的任务：不创建 packaged_task/future，可调用对象可以是 move-only 的，
+    // 闭包不超过 Task::kInlineSize 时内联存储，稳态下每个任务零堆分配。失败时与 submit 一样抛异常（任务被销毁、不执行）
+    template <typename F>
+    void post(TaskPriority pri, F&& f) {
+        enqueue(pri, Task(std::forward<F>(f)));
+    }
+
+    template <typename F>
+    void post(F&& f) {
+        enqueue(TaskPriority::Normal, Task(std::forward<F>(f)));
+    }
+
     void shutdown();
 
+    // Asio executor：boost::asio::post / co_spawn 等可直接把工作投到本线程池。默认非阻塞投递，
+    // 经它投递的都是已接纳工作的后续步骤（见 enqueueContinuation），不受 maxQueueSize 限制
+    executor_type get_executor() noexcept;
+    // 当前线程是否为本池的工作线程
+    bool runningInThisThread() const noexcept;
+
+    // 在池线程上启动协程时使用：生效期间经本池 executor 的第一次投递（co_spawn 的入口步骤）就地执行，
+    // 协程直接跑到第一次真正挂起，不必为启动再入队一次；之后的投递照常入队。只在本池线程上构造才生效
+    class InlineEntry {
+      public:
+        explicit InlineEntry(ThreadPool& pool) noexcept;
+        ~InlineEntry();
+        InlineEntry(const InlineEntry&) = delete;
+        InlineEntry& operator=(const InlineEntry&) = delete;
+
+      private:
+        ThreadPool* prev_;
+    };
+
+    // 协程切到本线程池：co_await pool.schedule(boost::asio::use_awaitable) 之后的代码在池线程上执行。
+    // 协程自身的 executor 不变（之后发起的异步操作仍在原 executor 上完成），
+    // 重活做完用 co_await boost::asio::post(原 executor, use_awaitable) 切回连接 strand 再发送
+    template <typename CompletionToken>
+    auto schedule(CompletionToken&& token);
+
     std::size_t maxQueueSize() const;
     void setMxQueueSize(std::size_t n);
 
@@ -38,34 +167,99 @@ class ThreadPool {
     // 动态调整线程数：newCount 会被 clamp 到 [minThreads_, maxThreads_]
     void resize(std::size_t newCount);
 
-    // 启用/关闭自动动态伸缩（简单策略）
+    // 启用/关闭自动动态伸缩：按排队等待时间（p99）与线程利用率调节线程数，详见 adjustLoop
     void enableAutoTune(bool enable);
 
     // 可以根据需要修改这些参数（也可以从配置里读取）
+    // upThreshold/downThreshold 为连续多少个采样周期满足条件才扩/缩容；队列超过 highWatermark 视同等待超标
     void setAutoTuneParams(std::size_t highWatermark, std::size_t lowWatermark, int upThreshold, int downThreshold);
+    // 排队等待时间目标（p99 超过即扩容，低于一半且线程空闲才缩容）与采样周期
+    void setAutoTuneTarget(std::chrono::microseconds queueWaitSlo, std::chrono::milliseconds interval);
+
+    // 空闲策略：取不到任务时先自旋 spin 再休眠（0 = 直接休眠）。自旋期间新任务无需 futex 唤醒即被取走；
+    // 同时自旋的线程数不超过 maxSpinners（0 = 自动：核数的一半，单核不自旋）
+    void setIdleSpin(std::chrono::microseconds spin, std::size_t maxSpinners = 0);
 
   private:
-    // 线程函数
-    void workerLoop();
+    // 一个工作线程的本地队列（线程缩容退出后槽位保留，剩余任务由其他线程窃取）
+    struct Worker {
+        std::mutex mtx;
+        threadpool_detail::TaskRing queues[3];  // 按 TaskPriority 下标
+        std::atomic<std::size_t> size{0};   // 三条队列总长，窃取前无锁判空
+        bool active{false};                 // 是否有线程占用（受 ThreadPool::mutex_ 保护）
+        clockid_t cpuClock{};               // 占用线程的 CPU 时钟，自动伸缩据此区分“在算”与“在阻塞”（受 mutex_ 保护）
+        std::uint64_t generation{0};        // 每换一个线程占用加一，采样时识别线程更替（受 mutex_ 保护）
+        std::atomic<std::int64_t> taskStartNs{0};  // 正在执行的任务的开始时刻，0 = 空闲（autoTune_ 开启时才记录）
+    };
+
+    // 排队等待时间直方图：第 i 桶为 [2^(i-1), 2^i) 微秒，最后一桶兜底
+    static constexpr std::size_t kWaitBuckets = 24;
+
+    // 取走本线程上 InlineEntry 登记的就地执行名额（只取一次）
+    bool takeInlineEntry() noexcept;
+
+    // 非模板入队：检查停止/容量后放入目标队列并按需唤醒
+    void enqueue(TaskPriority pri, Task task);
+    // executor 投递的续体（协程恢复、完成回调）：不查容量、不抛异常，以 High 优先级入队，过载时也不会被丢弃。
+    // 停止后仍入队，由退出前的线程取完；没有线程再取的随线程池析构一起销毁
+    void enqueueContinuation(Task task);
+    // 放入目标队列（池内线程进自己的队列，外部线程轮转）并按需唤醒；容量已由调用方计入 totalQueueSize_
+    void push(TaskPriority pri, Task task);
+
+    // 线程函数（self 为占用的槽位）
+    void workerLoop(std::size_t self);
+
+    // 唤醒一个休眠线程（仅在没有线程正在找任务时）
+    void wakeOne();
+
+    // 休眠前的有界自旋：看到积压返回 true（调用方回去取任务）；自旋期间记为“找任务中”
+    bool spinForWork(bool& searching);
+
+    // 取一个任务：先本地再窃取，没有返回 false
+    bool popTask(std::size_t self, threadpool_detail::QueuedTask& out);
+    bool popFrom(Worker& w, int pri, threadpool_detail::QueuedTask& out);
+    // 从 victim 窃取该优先级约一半的任务：返回其中一个，其余放进本地队列，摊薄窃取开销
+    bool stealFrom(Worker& victim, Worker& self, int pri, threadpool_detail::QueuedTask& out);
+
+    // 记录一次排队等待（取到任务时调用）
+    void recordWait(std::int64_t enqueuedNs, std::int64_t nowNs);
 
     // 队列满时的处理策略：返回 true 表示已经通过丢弃某些任务腾出了空间
     bool handleOverflow(TaskPriority incomingPri);
+    bool dropOneFrom(int pri);
+
+    // 为新线程占一个空闲槽位 / 线程退出时让出槽位（需持有 mutex_），同时维护 activeSlots_
+    std::size_t claimSlotLocked();
+    void releaseSlotLocked(std::size_t slot);
+    void startWorkerLocked();
 
     // 自动调整线程数的后台线程
     void adjustLoop();
+    // 当前各工作线程累计 CPU 时间之和（只计与上次采样为同一线程的槽位，lastCpu 保存每槽上次读数）
+    std::int64_t sampleCpuNs(std::vector<std::pair<std::uint64_t, std::int64_t>>& lastCpu);
 
   private:
-    bool stopping_;
-    mutable std::mutex mutex_;
+    std::atomic<bool> stopping_;
+    mutable std::mutex mutex_;  // 保护线程增减、停止与休眠，不在提交/取任务的热路径上
     std::condition_variable cv_;
     std::vector<std::thread> workers_;
 
-    std::queue<std::function<void()>> highQ_;
-    std::queue<std::function<void()>> normalQ_;
-    std::queue<std::function<void()>> lowQ_;
+    std::vector<std::unique_ptr<Worker>> slots_;  // 每线程本地队列，容量为线程数上限，启动后不再变化
+    // 有线程占用的槽位下标，前 activeCount_ 项有效（在 mutex_ 下增删）：外部提交只在这些槽位间轮转，
+    // 缩容后空出的槽位不再接新任务（其中剩余的任务由其他线程窃取）
+    std::vector<std::atomic<std::size_t>> activeSlots_;
+    std::atomic<std::size_t> activeCount_{0};
+    std::atomic<std::size_t> nextSlot_{0};        // 外部提交的轮转下标
+    std::atomic<std::size_t> sleepers_{0};        // 正在 cv_ 上等待的线程数
+    std::atomic<std::size_t> searching_{0};       // 已唤醒/正在找任务的线程数（有人在找就不再唤醒新线程）
+    std::size_t notified_{0};                     // 已 notify、尚未被休眠线程领取的唤醒数（受 mutex_ 保护）
+    std::atomic<std::int64_t> idleSpinNs_{0};     // 休眠前自旋时长，0 = 不自旋
+    std::atomic<std::size_t> maxSpinners_{0};     // 同时自旋的线程数上限
+    std::atomic<std::size_t> spinners_{0};        // 正在自旋的线程数
 
-    std::size_t maxQueueSize_{0};    // 任务队列最大数量
-    std::size_t totalQueueSize_{0};  // 队列总数
+    std::atomic<std::size_t> maxQueueSize_{0};    // 任务队列最大数量
+    std::atomic<std::size_t> totalQueueSize_{0};  // 队列总数
+    std::atomic<std::size_t> queuedByPri_[3]{};   // 各优先级排队数，取任务时跳过整级为空的优先级
 
     // 动态伸缩相关
     std::size_t minThreads_;
@@ -85,41 +279,75 @@ class ThreadPool {
     std::size_t lowWatermark_{0};
     int upThreshold_{3};
     int downThreshold_{10};
+    std::atomic<std::int64_t> queueWaitSloUs_{5000};
+    std::atomic<std::int64_t> adjustIntervalMs_{100};
+
+    // 自动伸缩的测量数据（autoTune_ 开启时才采集）：控制线程每周期取走清零
+    std::atomic<std::uint64_t> waitBuckets_[kWaitBuckets]{};
+    std::atomic<std::int64_t> busyNs_{0};  // 已执行完的任务累计墙钟时间（执行中的部分由控制线程按 taskStartNs 补算）
+};
+
+class ThreadPool::executor_type {
+  public:
+    explicit executor_type(ThreadPool& pool, bool possiblyBlocking = false) noexcept : pool_(&pool), possiblyBlocking_(possiblyBlocking) {}
+
+    ThreadPool& query(boost::asio::execution::context_t) const noexcept { return *pool_; }
+
+    boost::asio::execution::blocking_t query(boost::asio::execution::blocking_t) const noexcept {
+        return possiblyBlocking_ ? boost::asio::execution::blocking_t(boost::asio::execution::blocking.possibly)
+                                 : boost::asio::execution::blocking_t(boost::asio::execution::blocking.never);
+    }
+
+    executor_type require(boost::asio::execution::blocking_t::never_t) const noexcept { return executor_type(*pool_, false); }
+    executor_type require(boost::asio::execution::blocking_t::possibly_t) const noexcept { return executor_type(*pool_, true); }
+
+    // dispatch（blocking.possibly）且已在池线程上时就地执行，协程在池线程上恢复不必再排一次队；InlineEntry 登记的启动步骤同样就地执行；
+    // 其余经 enqueueContinuation 入队：协程续体属于已接纳的请求，不受队列上限约束、不抛异常
+    template <typename F>
+    void execute(F&& f) const {
+        if ((possiblyBlocking_ && pool_->runningInThisThread()) || pool_->takeInlineEntry()) {
+            std::decay_t<F>(std::forward<F>(f))();
+            return;
+        }
+        pool_->enqueueContinuation(Task(std::forward<F>(f)));
+    }
+
+    friend bool operator==(const executor_type& a, const executor_type& b) noexcept { return a.pool_ == b.pool_ && a.possiblyBlocking_ == b.possiblyBlocking_; }
+    friend bool operator!=(const executor_type& a, const executor_type& b) noexcept { return !(a == b); }
+
+  private:
+    ThreadPool* pool_;
+    bool possiblyBlocking_;
 };
 
+inline ThreadPool::executor_type ThreadPool::get_executor() noexcept { return executor_type(*this); }
+
+template <typename CompletionToken>
+auto ThreadPool::schedule(CompletionToken&& token) {
+    return boost::asio::async_initiate<CompletionToken, void()>(
+        [this](auto handler) {
+            if (runningInThisThread()) {
+                // 已在池线程上（如线程池路由上的 handler）：原地继续，避免等待自己队列里的任务
+                auto ex = boost::asio::get_associated_executor(handler);
+                boost::asio::post(ex, std::move(handler));
+                return;
+            }
+            try {
+                post(threadpool_detail::ScheduleOp<decltype(handler)>(std::move(handler)));
+            } catch (const std::exception&) {
+                // 队列满或已停止：ScheduleOp 析构时已退回原 executor，协程在原处继续执行
+            }
+        },
+        token);
+}
+
 template <typename F, typename... Args>
 auto ThreadPool::submit(TaskPriority pri, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
     using ReturnType = typename std::invoke_result<F, Args...>::type;
     // 创建一个打包任务
     auto task = std::make_shared<std::packaged_task<ReturnType()>>([fun = std::forward<F>(f), ... arg = std::forward<Args>(args)]() { return fun(arg...); });
     std::future<ReturnType> fut = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (stopping_) {
-            throw std::runtime_error("Submit on stopped ThreadPool");
-        }
-        // 队列上限 + 过载策略
-        if (maxQueueSize_ > 0 && totalQueueSize_ >= maxQueueSize_) {
-            if (!handleOverflow(pri)) {
-                throw std::runtime_error("ThreadPool queue full");
-            }
-        }
-        // 这里一定有空间可以插入（或者 maxQueueSize_ == 0）
-        switch (pri) {
-            case TaskPriority::High:
-                highQ_.emplace([task] { (*task)(); });
-                break;
-            case TaskPriority::Normal:
-                normalQ_.emplace([task] { (*task)(); });
-                break;
-            case TaskPriority::Low:
-                lowQ_.emplace([task] { (*task)(); });
-                break;
-        }
-        ++totalQueueSize_;
-        MetricsRegistry::Instance().workerQueueSize().inc();
-    }
-    cv_.notify_one();
+    enqueue(pri, [task] { (*task)(); });
     return fut;
 }
 
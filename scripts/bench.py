@@ -12,12 +12,19 @@ def build_frame(msg_type: int, body: bytes) -> bytes:
     return struct.pack("!I", length) + struct.pack("!H", msg_type) + body
 
 
-async def send_loop(writer: asyncio.StreamWriter, msg_type: int, payload: bytes, rate_per_conn: float, duration: float, stats: dict):
+def stamp_payload(payload: bytes, latency: bool) -> bytes:
+    # 延迟模式：payload 前 8 字节写入发送时刻（ns），echo 回包为 b"echo" + payload
+    if not latency:
+        return payload
+    return struct.pack("!Q", time.perf_counter_ns()) + payload[8:]
+
+
+async def send_loop(writer: asyncio.StreamWriter, msg_type: int, payload: bytes, rate_per_conn: float, duration: float, stats: dict, latency: bool = False):
     interval = 1.0 / rate_per_conn if rate_per_conn > 0 else 0
     end_at = time.time() + duration
     while time.time() < end_at:
         try:
-            writer.write(build_frame(msg_type, payload))
+            writer.write(build_frame(msg_type, stamp_payload(payload, latency)))
             await writer.drain()
             stats["sent"] += 1
         except Exception:
@@ -27,7 +34,7 @@ async def send_loop(writer: asyncio.StreamWriter, msg_type: int, payload: bytes,
             await asyncio.sleep(interval)
 
 
-async def recv_loop(reader: asyncio.StreamReader, stats: dict, error_types: Counter, stop_event: asyncio.Event):
+async def recv_loop(reader: asyncio.StreamReader, stats: dict, error_types: Counter, stop_event: asyncio.Event, latencies: list = None):
     try:
         while not stop_event.is_set():
             header = await reader.readexactly(4)
@@ -35,6 +42,9 @@ async def recv_loop(reader: asyncio.StreamReader, stats: dict, error_types: Coun
             body = await reader.readexactly(length)
             msg_type = struct.unpack("!H", body[:2])[0]
             payload = body[2:]
+            if latencies is not None and payload[:4] == b"echo" and len(payload) >= 12:
+                (sent_ns,) = struct.unpack("!Q", payload[4:12])
+                latencies.append((time.perf_counter_ns() - sent_ns) / 1e6)
             stats["recv"] += 1
             error_types[msg_type] += 1
     except asyncio.IncompleteReadError:
@@ -43,7 +53,7 @@ async def recv_loop(reader: asyncio.StreamReader, stats: dict, error_types: Coun
         stats["recv_errors"] += 1
 
 
-async def worker(host, port, msg_type, payload, rate_per_conn, duration, stats_global, error_types_global):
+async def worker(host, port, msg_type, payload, rate_per_conn, duration, stats_global, error_types_global, latencies=None):
     try:
         reader, writer = await asyncio.open_connection(host, port)
     except Exception:
@@ -52,8 +62,11 @@ async def worker(host, port, msg_type, payload, rate_per_conn, duration, stats_g
     stats = defaultdict(int)
     error_types = Counter()
     stop_event = asyncio.Event()
-    recv_task = asyncio.create_task(recv_loop(reader, stats, error_types, stop_event))
-    await send_loop(writer, msg_type, payload, rate_per_conn, duration, stats)
+    recv_task = asyncio.create_task(recv_loop(reader, stats, error_types, stop_event, latencies))
+    await send_loop(writer, msg_type, payload, rate_per_conn, duration, stats, latencies is not None)
+    if latencies is not None:
+        # 给最后一批回包留一点时间
+        await asyncio.sleep(0.2)
     stop_event.set()
     recv_task.cancel()
     writer.close()
@@ -76,7 +89,10 @@ async def main():
     parser.add_argument("--concurrency", type=int, default=10, help="number of parallel connections")
     parser.add_argument("--qps", type=float, default=100.0, help="total QPS")
     parser.add_argument("--duration", type=float, default=10.0, help="seconds to run")
+    parser.add_argument("--latency", action="store_true", help="measure echo round-trip latency (msgType=2, payload>=8)")
     args = parser.parse_args()
+    if args.latency and args.payload_size < 8:
+        args.payload_size = 8
 
     payload = bytes(random.getrandbits(8) for _ in range(args.payload_size))
     rate_per_conn = args.qps / args.concurrency if args.concurrency > 0 else 0
@@ -84,8 +100,10 @@ async def main():
     stats_global = defaultdict(int)
     error_types_global = Counter()
 
+    latencies = [] if args.latency else None
+
     tasks = [
-        worker(args.host, args.port, args.msg_type, payload, rate_per_conn, args.duration, stats_global, error_types_global)
+        worker(args.host, args.port, args.msg_type, payload, rate_per_conn, args.duration, stats_global, error_types_global, latencies)
         for _ in range(args.concurrency)
     ]
 
@@ -95,6 +113,13 @@ async def main():
 
     print(f"Ran {elapsed:.2f}s, concurrency={args.concurrency}, total_qps={args.qps}")
     print(f"Sent={stats_global['sent']} Recv={stats_global['recv']} SendErr={stats_global['send_errors']} RecvErr={stats_global['recv_errors']} ConnFail={stats_global['connect_fail']}")
+    if latencies:
+        latencies.sort()
+
+        def pct(p: float) -> float:
+            return latencies[min(len(latencies) - 1, int(len(latencies) * p))]
+
+        print(f"Latency(ms) n={len(latencies)} p50={pct(0.50):.3f} p90={pct(0.90):.3f} p99={pct(0.99):.3f} max={latencies[-1]:.3f}")
     if error_types_global:
         print("Response msgType counts:")
         for mt, cnt in error_types_global.most_common():
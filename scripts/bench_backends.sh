@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+# 对比 epoll 与 io_uring 后端在 echo 路由（MSG_ECHO=2）上的吞吐与延迟。
+# 用法：scripts/bench_backends.sh [build_dir] [port] [qps] [concurrency] [duration]
+# 需要先以 -DDOMAIN_IO_URING=ON 构建出 domain 与 domain_uring；config.lua 中 server.port 需与 port 一致。
+set -euo pipefail
+
+BUILD_DIR=${1:-build}
+PORT=${2:-8888}
+QPS=${3:-50000}
+CONC=${4:-64}
+DURATION=${5:-15}
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+
+run_one() {
+    local bin=$1
+    local backend=$2
+    if [[ ! -x "${BUILD_DIR}/${bin}" ]]; then
+        echo "skip ${bin}: not built"
+        return
+    fi
+    echo "=== ${backend} (${bin}) ==="
+    # 两个二进制都读取 ../config/config.lua，从 build 目录启动；DOMAIN_IO_BACKEND 覆盖配置里的 server.ioBackend，
+    # 让每个二进制按自己编译进的后端运行，不会 exec 到另一个
+    (cd "${BUILD_DIR}" && DOMAIN_IO_BACKEND="${backend}" "./${bin}" > "/tmp/bench_${backend}.log" 2>&1) &
+    local pid=$!
+    sleep 2
+    python3 "${SCRIPT_DIR}/bench.py" --port "${PORT}" --msg-type 2 --payload-size 64 \
+        --qps "${QPS}" --concurrency "${CONC}" --duration "${DURATION}" --latency || true
+    kill -INT "${pid}" 2>/dev/null || true
+    wait "${pid}" 2>/dev/null || true
+}
+
+run_one domain epoll
+run_one domain_uring io_uring
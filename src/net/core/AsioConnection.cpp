@@ -5,18 +5,34 @@
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/post.hpp>
 #include <boost/asio/this_coro.hpp>
 #include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
 #include <cerrno>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include <netinet/tcp.h>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define DOMAIN_HAS_ZEROCOPY 1
+#endif
+#endif
+
 #include "Metrics.h"
 #include "TraceContext.h"
 
 namespace {
+    // 当前线程正在执行哪条连接的读回调（flushOnReadEnd 用来识别内联回包）
+    thread_local AsioConnection* tlReadCycleConn = nullptr;
+
     std::string makeUuid() {
         static thread_local std::mt19937_64 rng{std::random_device{}()};
         std::uniform_int_distribution<uint64_t> dist;
@@ -48,22 +64,36 @@ namespace {
 }  // namespace
 
 AsioConnection::AsioConnection(boost::asio::io_context& io_context, tcp::socket socket, size_t maxSendBufferBytes)
-    : io_context_(io_context), socket_(std::move(socket)), pauseTimer_(socket_.get_executor()), maxSendBuf_(maxSendBufferBytes) {
+    : io_context_(io_context), socket_(std::move(socket)), pauseTimer_(socket_.get_executor()), maxSendBuf_(maxSendBufferBytes), zcTimer_(socket_.get_executor()) {
     highWatermark_ = maxSendBuf_ * 0.8;
     lowWatermark_ = maxSendBuf_ * 0.5;
     sessionId_ = makeUuid();
     traceId_ = sessionId_;
 
-    readBuf_ = BufferPool::Instance().acquire(4096);
+    readBuf_ = BufferPool::Instance().acquire(readSize_);
     boost::system::error_code ec;
     auto ep = socket_.remote_endpoint(ec);
     if (!ec) {
         remoteIp_ = ep.address().to_string();
+        remoteIpKey_ = IpKey::FromAddress(ep.address());
     }
 }
 
 void AsioConnection::start() {
     touch();
+#ifdef DOMAIN_HAS_ZEROCOPY
+    if (zeroCopyThreshold_ > 0) {
+        int one = 1;
+        if (::setsockopt(socket_.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            zeroCopyEnabled_ = true;
+        } else {
+            // 内核不支持（< 4.14）或协议不支持，整条连接走普通发送
+            MetricsRegistry::Instance().zeroCopyFallbacks().inc();
+            TraceContext::Guard g(traceId_, sessionId_);
+            SPDLOG_DEBUG("[ZeroCopy] SO_ZEROCOPY unavailable: errno={} trace={} sess={}", errno, traceId_, sessionId_);
+        }
+    }
+#endif
     boost::asio::co_spawn(socket_.get_executor(), readLoop(), boost::asio::detached);
 }
 
@@ -74,7 +104,7 @@ void AsioConnection::send(std::string_view message) {
         return;
     }
     // per-connection 发送缓存上限控制
-    if (maxSendBuf_ > 0 && sendQueueBytes_ + message.size() > maxSendBuf_) {
+    if (maxSendBuf_ > 0 && sendQueueBytes_.load(std::memory_order_relaxed) + message.size() > maxSendBuf_) {
         TraceContext::Guard g(traceId_, sessionId_);
         SPDLOG_ERROR("[AsioConnection] send buffer overflow, drop message, size={}, trace={}, sess={}", message.size(), traceId_, sessionId_);
         return;
@@ -92,37 +122,59 @@ void AsioConnection::sendBuffer(const BufferPool::Ptr& buf) {
     if (closing_) {
         return;
     }
-    auto self = shared_from_this();
 
-    // 所有写操作都回到 socket 所在的 executor，避免跨线程 data race
-    boost::asio::post(socket_.get_executor(), [this, self, buf]() mutable {
-        bool idle = sendQueue_.empty();
-        sendQueueBytes_ += buf->readableBytes();
-        sendQueue_.push_back(buf);
-        auto prevMax = MetricsRegistry::Instance().sendQueueMaxBytes().value();
-        if (sendQueueBytes_ > static_cast<std::size_t>(prevMax)) {
-            MetricsRegistry::Instance().sendQueueMaxBytes().inc(static_cast<std::int64_t>(sendQueueBytes_ - prevMax));
-        }
+    // 先记账再入队：写协程只会在发出之后扣减，计数不会短暂为负
+    const std::size_t bytes = buf->readableBytes();
+    const std::size_t queued = sendQueueBytes_.fetch_add(bytes, std::memory_order_acq_rel) + bytes;
+    auto prevMax = MetricsRegistry::Instance().sendQueueMaxBytes().value();
+    if (queued > static_cast<std::size_t>(prevMax)) {
+        MetricsRegistry::Instance().sendQueueMaxBytes().inc(static_cast<std::int64_t>(queued - prevMax));
+    }
 
-        // ---------- Backpressure: 触发 ----------
-        if (!readPaused_.load(std::memory_order_relaxed) && sendQueueBytes_ > highWatermark_) {
-            readPaused_.store(true, std::memory_order_relaxed);
-            pauseTimer_.expires_at(std::chrono::steady_clock::time_point::max());
-            MetricsRegistry::Instance().onBackpressureEnter();
-            TraceContext::Guard g(traceId_, sessionId_);
-            SPDLOG_WARN("[Backpressure] Pause read: queueBytes={} high={} trace={} sess={}", sendQueueBytes_, highWatermark_, traceId_, sessionId_);
+    // ---------- Backpressure: 触发 ----------
+    if (queued > highWatermark_ && !readPaused_.exchange(true, std::memory_order_acq_rel)) {
+        MetricsRegistry::Instance().onBackpressureEnter();
+        TraceContext::Guard g(traceId_, sessionId_);
+        SPDLOG_WARN("[Backpressure] Pause read: queueBytes={} high={} trace={} sess={}", queued, highWatermark_, traceId_, sessionId_);
+        // 写协程可能恰好在 fetch_add 之后把队列发空，回到 executor 上补一次检查，避免永久暂停读
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()] { self->resumeReadIfDrained(); });
+    }
+
+    incoming_.push(buf);
+
+    // 只有写协程空闲时才需要 post 一次唤醒，忙时由写协程自己从队列取
+    if (!writerScheduled_.exchange(true, std::memory_order_seq_cst)) {
+        if (tlReadCycleConn == this) {
+            return;  // I/O 线程内联回包：本轮读结束时由 readLoop 统一启动写协程
         }
+        boost::asio::post(socket_.get_executor(), [self = shared_from_this()] { self->startWriteLoop(); });
+    }
+}
+
+void AsioConnection::startWriteLoop() {
+    if (writing_ || closing_) {
+        return;
+    }
+    writing_ = true;
+    boost::asio::co_spawn(socket_.get_executor(), writeLoop(), boost::asio::detached);
+}
 
-        if (idle && !writing_) {
-            writing_ = true;
-            boost::asio::co_spawn(socket_.get_executor(), writeLoop(), boost::asio::detached);
+void AsioConnection::resumeReadIfDrained() {
+    if (closing_) {
+        return;
+    }
+    if (readPaused_.load(std::memory_order_acquire) && sendQueueBytes_.load(std::memory_order_acquire) <= lowWatermark_) {
+        if (readPaused_.exchange(false, std::memory_order_acq_rel)) {
+            pauseTimer_.cancel();
+            MetricsRegistry::Instance().onBackpressureExit();
         }
-    });
+    }
 }
 
 void AsioConnection::close() {
     auto self = shared_from_this();
-    boost::asio::post(io_context_, [this, self] { handleClose(); });
+    // 必须回到 socket 的 executor（非分片模式下是 strand），与读写协程串行
+    boost::asio::post(socket_.get_executor(), [this, self] { handleClose(); });
 }
 
 boost::asio::awaitable<void> AsioConnection::readLoop() {
@@ -132,7 +184,7 @@ boost::asio::awaitable<void> AsioConnection::readLoop() {
             if (closing_) {
                 co_return;
             }
-            if (readPaused_.load(std::memory_order_relaxed)) {
+            if (readPaused_.load(std::memory_order_relaxed) || readHolds_.load(std::memory_order_acquire) > 0) {
                 // 重置为“永不过期”，避免上次取消后的立即触发
                 pauseTimer_.expires_at(std::chrono::steady_clock::time_point::max());
                 boost::system::error_code ec;
@@ -149,16 +201,67 @@ boost::asio::awaitable<void> AsioConnection::readLoop() {
                 continue;
             }
 
-            readBuf_->ensureWritableBytes(4096);
-            std::size_t len = co_await socket_.async_read_some(boost::asio::buffer(readBuf_->beginWrite(), readBuf_->writableBytes()), boost::asio::use_awaitable);
+            if (!readBuf_) {
+                // 空闲时不持有读缓冲：1 字节 MSG_PEEK 等到有数据（不消费），再从池里取缓冲
+                char probe;
+                co_await socket_.async_receive(boost::asio::buffer(&probe, 1), tcp::socket::message_peek, boost::asio::use_awaitable);
+                readBuf_ = BufferPool::Instance().acquire(readSize_);
+                continue;  // 回到循环顶部重新检查 closing_/背压
+            }
+
+            std::size_t len = 0;
+            std::size_t want = 0;
+            if (readHint_ > 0) {
+                // 已知半包剩余长度：一次读满整帧，避免按固定块多次读取和反复扩容
+                want = std::min(readHint_, kMaxHintRead);
+                readBuf_->ensureWritableBytes(want);
+                len = co_await boost::asio::async_read(socket_, boost::asio::buffer(readBuf_->beginWrite(), readBuf_->writableBytes()), boost::asio::transfer_at_least(want),
+                                                       boost::asio::use_awaitable);
+            } else {
+                want = readSize_;
+                readBuf_->ensureWritableBytes(want);
+                len = co_await socket_.async_read_some(boost::asio::buffer(readBuf_->beginWrite(), want), boost::asio::use_awaitable);
+                adaptReadSize(len);
+            }
 
             if (len > 0) {
                 MetricsRegistry::Instance().bytesIn().inc(len);
+                MetricsRegistry::Instance().readBytes().observe(static_cast<double>(len));
                 touch();
                 readBuf_->hasWritten(len);
 
+                readHint_ = 0;
                 if (messageCallback_ && readBuf_->readableBytes() > 0) {
+                    if (flushOnReadEnd_) {
+                        tlReadCycleConn = this;
+                    }
                     messageCallback_(self, *readBuf_);
+                    tlReadCycleConn = nullptr;
+
+                    if (readBuf_.use_count() > 1) {
+                        // 有帧 body 仍引用这块缓冲：换一块新的继续读，剩余半包拷过去（旧缓冲随最后一个引用归还池）
+                        auto fresh = BufferPool::Instance().acquire(std::max(readSize_, readBuf_->readableBytes()));
+                        if (readBuf_->readableBytes() > 0) {
+                            fresh->append(readBuf_->peek(), readBuf_->readableBytes());
+                        }
+                        readBuf_ = std::move(fresh);
+                    }
+                    // 本轮解析出的帧在 I/O 线程上直接产生的回包，这里一次性发出
+                    if (writerScheduled_.load(std::memory_order_acquire)) {
+                        startWriteLoop();
+                    }
+                }
+            }
+
+            if (readBuf_ && readBuf_->readableBytes() == 0 && readHint_ == 0) {
+                // 没读满说明内核缓冲已空；连续多次读空才把缓冲还回池里，持续有请求的连接不必每次唤醒都多一次 MSG_PEEK 和池的取还
+                idleReads_ = len < want ? idleReads_ + 1 : 0;
+                if (releaseIdleAfter_ > 0 && idleReads_ >= releaseIdleAfter_) {
+                    idleReads_ = 0;
+                    readBuf_.reset();
+                } else if (readBuf_->capacity() > readSizeMax_ * 2) {
+                    // 大帧过后换回常规大小的缓冲
+                    readBuf_ = BufferPool::Instance().acquire(readSize_);
                 }
             }
         }
@@ -179,26 +282,70 @@ boost::asio::awaitable<void> AsioConnection::readLoop() {
 
 boost::asio::awaitable<void> AsioConnection::writeLoop() {
     auto self = shared_from_this();
+    // 协程无论怎样结束（含异常、io_context 停止时未跑完即被销毁）都复位 writing_；
+    // 只有空闲退出时 writerScheduled_ 已在循环里交接，其余情况一并清掉，之后的 sendBuffer 能重新调度写协程
+    struct WriterReset {
+        AsioConnection* conn;
+        bool handedOff;
+        ~WriterReset() {
+            if (!handedOff) {
+                conn->writerScheduled_.store(false, std::memory_order_seq_cst);
+            }
+            conn->writing_ = false;
+        }
+    } reset{this, false};
     try {
-        // --- 合并策略参数：可以先写死，后面放到 Config 里 ---
-        constexpr std::size_t kMaxBatchCount = 16;
-
         std::vector<boost::asio::const_buffer> sendingBuffers;
         std::vector<BufferPool::Ptr> inFlightBufs;
 
         // 预分配内存，避免 push_back 时扩容
-        sendingBuffers.reserve(kMaxBatchCount);
-        inFlightBufs.reserve(kMaxBatchCount);
+        sendingBuffers.reserve(writeMaxFrames_);
+        inFlightBufs.reserve(writeMaxFrames_);
+
+        for (;;) {
+            // 把生产者无锁入队的缓冲搬到写协程私有的 sendQueue_
+            BufferPool::Ptr incoming;
+            while (incoming_.pop(incoming)) {
+                sendQueue_.push_back(std::move(incoming));
+            }
+            if (sendQueue_.empty()) {
+                // 先声明空闲再复查：复查时看不到的入队，其生产者必然看到 false 并负责 post
+                writerScheduled_.store(false, std::memory_order_seq_cst);
+                if (incoming_.empty() || writerScheduled_.exchange(true, std::memory_order_seq_cst)) {
+                    reset.handedOff = true;
+                    break;
+                }
+                // 生产者已 exchange 但还没链接完，让出一次再取
+                co_await boost::asio::post(socket_.get_executor(), boost::asio::use_awaitable);
+                continue;
+            }
 
-        while (!sendQueue_.empty()) {
             sendingBuffers.clear();
             inFlightBufs.clear();
 
             std::size_t bytesToSend = 0;
 
-            // 合并数据
-            while (!sendQueue_.empty() && inFlightBufs.size() < kMaxBatchCount) {
+            // 大帧单独走 MSG_ZEROCOPY，避免内核再拷贝一次用户缓冲
+            if (zeroCopyEnabled_ && sendQueue_.front()->readableBytes() >= zeroCopyThreshold_) {
+                auto buf = std::move(sendQueue_.front());
+                sendQueue_.pop_front();
+                std::size_t bytes = buf->readableBytes();
+                co_await sendZeroCopy(buf);
+                MetricsRegistry::Instance().writeFrames().observe(1);
+                MetricsRegistry::Instance().writeBytes().observe(static_cast<double>(bytes));
+                onBytesSent(bytes);
+                continue;
+            }
+
+            // 合并数据：帧数或字节数任一到达上限即发送，首帧总会放入（超大帧单独成批）
+            while (!sendQueue_.empty() && inFlightBufs.size() < writeMaxFrames_) {
                 auto& buf = sendQueue_.front();
+                if (zeroCopyEnabled_ && buf->readableBytes() >= zeroCopyThreshold_) {
+                    break;  // 留给下一轮零拷贝发送
+                }
+                if (!inFlightBufs.empty() && bytesToSend + buf->readableBytes() > writeMaxBytes_) {
+                    break;
+                }
                 if (buf->readableBytes() > 0) {
                     sendingBuffers.emplace_back(buf->peek(), buf->readableBytes());
                     inFlightBufs.push_back(buf);
@@ -208,32 +355,202 @@ boost::asio::awaitable<void> AsioConnection::writeLoop() {
             }
 
             if (bytesToSend == 0) {
-                if (sendQueue_.empty())
-                    break;
                 continue;
             }
 
-            // 发送数据
-            co_await boost::asio::async_write(socket_, sendingBuffers, boost::asio::use_awaitable);
+            // 队列里还有后续数据时提示内核先攒着，最后一批再推出去
+            const bool more = !sendQueue_.empty() || !incoming_.empty();
+            int flags = 0;
+            if (corkMode_ == CorkMode::MsgMore && more) {
+                flags = MSG_MORE;
+            } else if (corkMode_ == CorkMode::Cork && more && !corked_) {
+                setCork(true);
+            }
 
-            // 统计和背压
-            sendQueueBytes_ -= bytesToSend;
-            MetricsRegistry::Instance().bytesOut().inc(bytesToSend);
+            // 发送数据
+            co_await writeBatch(sendingBuffers, flags);
 
-            if (readPaused_.load(std::memory_order_relaxed) && sendQueueBytes_ <= lowWatermark_) {
-                if (!closing_) {
-                    readPaused_.store(false, std::memory_order_relaxed);
-                    pauseTimer_.cancel();
-                    MetricsRegistry::Instance().onBackpressureExit();
-                }
-            }
+            MetricsRegistry::Instance().writeFrames().observe(static_cast<double>(inFlightBufs.size()));
+            MetricsRegistry::Instance().writeBytes().observe(static_cast<double>(bytesToSend));
+            onBytesSent(bytesToSend);
+        }
+        if (corked_) {
+            setCork(false);  // 拔塞即把残留的不满 MSS 的数据推出去
         }
     } catch (const std::exception& e) {
         TraceContext::Guard g(traceId_, sessionId_);
         SPDLOG_ERROR("Write exception: {} trace={} sess={}", e.what(), traceId_, sessionId_);
         handleClose();
     }
-    writing_ = false;
+}
+
+boost::asio::awaitable<void> AsioConnection::writeBatch(std::vector<boost::asio::const_buffer>& bufs, int flags) {
+    if (flags == 0) {
+        co_await boost::asio::async_write(socket_, bufs, boost::asio::use_awaitable);
+        co_return;
+    }
+
+    // async_write 不支持 send flags，这里自己处理部分写
+    std::size_t begin = 0;
+    while (begin < bufs.size()) {
+        std::size_t n = co_await socket_.async_send(std::vector<boost::asio::const_buffer>(bufs.begin() + begin, bufs.end()), flags, boost::asio::use_awaitable);
+        while (begin < bufs.size() && n >= bufs[begin].size()) {
+            n -= bufs[begin].size();
+            ++begin;
+        }
+        if (n > 0) {
+            bufs[begin] += n;
+        }
+    }
+}
+
+void AsioConnection::setCork(bool on) {
+    int v = on ? 1 : 0;
+    if (::setsockopt(socket_.native_handle(), IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == 0) {
+        corked_ = on;
+    }
+}
+
+void AsioConnection::adaptReadSize(std::size_t lastRead) {
+    if (lastRead >= readSize_) {
+        // 一次读满，说明流量大，下一次读更多
+        readSize_ = std::min(readSize_ * 2, readSizeMax_);
+        smallReads_ = 0;
+    } else if (lastRead < readSize_ / 4) {
+        // 突发过后连续小读，逐步收缩
+        if (++smallReads_ >= kShrinkAfterSmallReads) {
+            readSize_ = std::max(readSize_ / 2, readSizeMin_);
+            smallReads_ = 0;
+        }
+    } else {
+        smallReads_ = 0;
+    }
+}
+
+void AsioConnection::onBytesSent(std::size_t bytes) {
+    // 统计和背压
+    sendQueueBytes_.fetch_sub(bytes, std::memory_order_acq_rel);
+    MetricsRegistry::Instance().bytesOut().inc(bytes);
+    resumeReadIfDrained();
+}
+
+boost::asio::awaitable<void> AsioConnection::sendZeroCopy(const BufferPool::Ptr& buf) {
+#ifdef DOMAIN_HAS_ZEROCOPY
+    const char* data = buf->peek();
+    std::size_t left = buf->readableBytes();
+
+    while (left > 0) {
+        // async_send 每次完成恰好对应一次 sendmsg（EAGAIN 由 reactor 重试），与内核通知序号一一对应
+        boost::system::error_code ec;
+        std::size_t n = co_await socket_.async_send(boost::asio::buffer(data, left), MSG_ZEROCOPY, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec == boost::asio::error::no_buffer_space) {
+            // pin 页超出 optmem 限额，剩余部分退回普通拷贝发送
+            MetricsRegistry::Instance().zeroCopyFallbacks().inc();
+            co_await boost::asio::async_write(socket_, boost::asio::buffer(data, left), boost::asio::use_awaitable);
+            break;
+        }
+        if (ec) {
+            throw boost::system::system_error(ec, "send(MSG_ZEROCOPY)");
+        }
+        zcPending_.emplace_back(zcNextSeq_++, buf);
+        MetricsRegistry::Instance().zeroCopySends().inc();
+        data += n;
+        left -= n;
+    }
+
+    // 本地回环等场景通知往往已经到达，先顺手收一次
+    reapZeroCopy();
+    if (!zcPending_.empty() && !zcReaping_) {
+        zcReaping_ = true;
+        boost::asio::co_spawn(socket_.get_executor(), zeroCopyReapLoop(), boost::asio::detached);
+    }
+#else
+    co_await boost::asio::async_write(socket_, boost::asio::buffer(buf->peek(), buf->readableBytes()), boost::asio::use_awaitable);
+#endif
+}
+
+void AsioConnection::reapZeroCopy() {
+#ifdef DOMAIN_HAS_ZEROCOPY
+    const int fd = socket_.native_handle();
+    for (;;) {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;  // EAGAIN：错误队列已空
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            bool isRecvErr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+            if (!isRecvErr) {
+                continue;
+            }
+            const auto* serr = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            const std::uint32_t lo = serr->ee_info;
+            const std::uint32_t hi = serr->ee_data;
+            const std::uint32_t count = hi - lo + 1;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // 内核实际做了拷贝（回环、网卡不支持 SG 等），继续零拷贝只会多付通知开销
+                MetricsRegistry::Instance().zeroCopyFallbacks().inc(count);
+                if (zeroCopyEnabled_) {
+                    zeroCopyEnabled_ = false;
+                    TraceContext::Guard g(traceId_, sessionId_);
+                    SPDLOG_DEBUG("[ZeroCopy] kernel copied, disable zero-copy on this connection trace={} sess={}", traceId_, sessionId_);
+                }
+            } else {
+                MetricsRegistry::Instance().zeroCopyCompleted().inc(count);
+            }
+
+            // TCP 的通知按序到达，序号回绕用无符号差值比较
+            while (!zcPending_.empty() && zcPending_.front().first - lo <= hi - lo) {
+                zcPending_.pop_front();
+            }
+        }
+    }
+#endif
+}
+
+boost::asio::awaitable<void> AsioConnection::zeroCopyReapLoop() {
+    auto self = shared_from_this();
+    // 完成通知通常在对端 ACK 后到达，用退避轮询代替 EPOLLERR（边沿触发下容易漏唤醒）
+    auto interval = std::chrono::milliseconds(1);
+    while (!closing_ && !zcPending_.empty()) {
+        zcTimer_.expires_after(interval);
+        boost::system::error_code ec;
+        co_await zcTimer_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (closing_) {
+            break;
+        }
+        std::size_t before = zcPending_.size();
+        reapZeroCopy();
+        interval = zcPending_.size() < before ? std::chrono::milliseconds(1) : std::min(interval * 2, std::chrono::milliseconds(64));
+    }
+    zcReaping_ = false;
+}
+
+boost::asio::awaitable<void> AsioConnection::drainZeroCopyAndClose() {
+    auto self = shared_from_this();
+    // 内核仍引用着这些页，提前归还 BufferPool 会让复用者的数据被发出去
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!zcPending_.empty() && std::chrono::steady_clock::now() < deadline) {
+        zcTimer_.expires_after(std::chrono::milliseconds(10));
+        boost::system::error_code ec;
+        co_await zcTimer_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        reapZeroCopy();
+    }
+
+    boost::system::error_code ec;
+    if (!zcPending_.empty()) {
+        // 超时仍未确认：RST 关闭让内核丢弃发送队列，不再读取这些页
+        socket_.set_option(boost::asio::socket_base::linger(true, 0), ec);
+    }
+    socket_.close(ec);
+    zcPending_.clear();
 }
 
 void AsioConnection::handleClose() {
@@ -241,20 +558,28 @@ void AsioConnection::handleClose() {
         return;
     closing_ = true;
 
-    if (readPaused_.load(std::memory_order_relaxed)) {
-        readPaused_.store(false, std::memory_order_relaxed);
-        pauseTimer_.cancel();
+    if (readPaused_.exchange(false, std::memory_order_acq_rel)) {
         MetricsRegistry::Instance().onBackpressureExit();
     }
+    pauseTimer_.cancel();  // 唤醒因背压或上层 hold 暂停的读协程，令其看到 closing_ 后退出
 
     boost::system::error_code ec;
     socket_.shutdown(tcp::socket::shutdown_both, ec);
-    socket_.close(ec);
+    if (zcPending_.empty()) {
+        socket_.close(ec);
+    } else {
+        boost::asio::co_spawn(socket_.get_executor(), drainZeroCopyAndClose(), boost::asio::detached);
+    }
 
-    readBuf_->retrieveAll();
+    if (readBuf_) {
+        readBuf_->retrieveAll();
+    }
 
     sendQueue_.clear();
-    sendQueueBytes_ = 0;
+    BufferPool::Ptr dropped;
+    while (incoming_.pop(dropped)) {
+    }
+    sendQueueBytes_.store(0, std::memory_order_relaxed);
 
     if (closeCallback_) {
         closeCallback_(shared_from_this());
@@ -263,10 +588,24 @@ void AsioConnection::handleClose() {
 
 void AsioConnection::setMessageCallback(MessageCallback cb) { messageCallback_ = std::move(cb); }
 void AsioConnection::setCloseCallback(CloseCallback cb) { closeCallback_ = std::move(cb); }
+void AsioConnection::setZeroCopyThreshold(std::size_t bytes) { zeroCopyThreshold_ = bytes; }
+void AsioConnection::setReadBufferLimits(std::size_t minBytes, std::size_t maxBytes, std::uint32_t releaseIdleAfter) {
+    readSizeMin_ = std::max<std::size_t>(minBytes, 256);
+    readSizeMax_ = std::max(maxBytes, readSizeMin_);
+    readSize_ = std::clamp<std::size_t>(readSize_, readSizeMin_, readSizeMax_);
+    releaseIdleAfter_ = releaseIdleAfter;
+}
+void AsioConnection::setWriteCoalescing(std::size_t maxFrames, std::size_t maxBytes, CorkMode cork, bool flushOnReadEnd) {
+    writeMaxFrames_ = std::max<std::size_t>(maxFrames, 1);
+    writeMaxBytes_ = std::max<std::size_t>(maxBytes, 1);
+    corkMode_ = cork;
+    flushOnReadEnd_ = flushOnReadEnd;
+}
+void AsioConnection::setReadHint(std::size_t pendingBytes) { readHint_ = pendingBytes; }
 
 boost::asio::ip::tcp::socket& AsioConnection::socket() { return socket_; }
 std::string AsioConnection::remoteIp() const { return remoteIp_; }
-std::string AsioConnection::sessionId() const { return sessionId_; }
+const std::string& AsioConnection::sessionId() const { return sessionId_; }
 std::string AsioConnection::traceId() const { return traceId_; }
 
 void AsioConnection::touch() {
@@ -277,4 +616,24 @@ void AsioConnection::touch() {
 
 std::uint64_t AsioConnection::lastActiveMs() const { return lastActiveMs_.load(std::memory_order_relaxed); }
 
+const BufferPool::Ptr& AsioConnection::readBufferOwner() const { return readBuf_; }
+
 bool AsioConnection::isReadPaused() const { return readPaused_.load(std::memory_order_relaxed); }
+
+void AsioConnection::holdRead() { readHolds_.fetch_add(1, std::memory_order_acq_rel); }
+
+void AsioConnection::releaseRead() {
+    if (readHolds_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    // 最后一个 hold 释放：回到连接 executor 唤醒读协程（读协程醒来后会重新检查背压/hold）
+    boost::asio::post(socket_.get_executor(), [self = shared_from_this()] {
+        if (self->readHolds_.load(std::memory_order_acquire) == 0) {
+            self->pauseTimer_.cancel();
+        }
+    });
+}
+
+std::shared_ptr<void>& AsioConnection::codecState() { return codecState_; }
+
+std::shared_ptr<ConnectionOrdering>& AsioConnection::orderingState() { return ordering_; }
@@ -10,13 +10,42 @@
 
 #include "AsioConnection.h"
 #include "Config.h"
+#include "IpAcl.h"
 #include "IpLimiter.h"
 #include "ThreadPool.h"
 #include "Codec.h"
 #include "TraceContext.h"
 
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+    // 分片模式下每个 io_context 只由一个线程驱动，提示 Asio 走单线程调度路径
+    int ioConcurrencyHint() { return Config::Instance().server().shardedIo ? 1 : BOOST_ASIO_CONCURRENCY_HINT_DEFAULT; }
+
+    // 将当前线程绑定到指定 CPU 核（失败仅告警，不影响运行）
+    void pinCurrentThread(std::size_t core) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(core), &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            SPDLOG_WARN("pin IO thread to core {} failed, rc={}", core, rc);
+        }
+#else
+        (void) core;
+#endif
+    }
+}  // namespace
+
 AsioServer::AsioServer(unsigned short port, size_t ioThreadsCount, std::uint64_t idleTimeoutMs)
-    : acceptor_(io_context_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
+    : io_context_(ioConcurrencyHint()),
       ioThreadsCount_(ioThreadsCount),
       metricsTimer_(io_context_),
       idleManager_(IdleConnectionManager::Duration(idleTimeoutMs)),
@@ -24,6 +53,31 @@ AsioServer::AsioServer(unsigned short port, size_t ioThreadsCount, std::uint64_t
     if (ioThreadsCount_ <= 0) {
         ioThreadsCount_ = std::thread::hardware_concurrency();
     }
+
+    const auto& sc = Config::Instance().server();
+    sharded_ = sc.shardedIo;
+    leastConn_ = (sc.shardPolicy == "leastConn");
+    pinIoThreads_ = sc.pinIoThreads;
+
+    // 0 号分片复用 io_context_（acceptor/定时器都在这里），其余分片各自独立
+    std::size_t shardNum = sharded_ ? ioThreadsCount_ : 1;
+    shards_.push_back(std::make_unique<IoShard>());
+    shards_.back()->io = &io_context_;
+    for (std::size_t i = 1; i < shardNum; ++i) {
+        extraContexts_.push_back(std::make_unique<boost::asio::io_context>(1));
+        shards_.push_back(std::make_unique<IoShard>());
+        shards_.back()->io = extraContexts_.back().get();
+    }
+    if (sharded_) {
+        for (auto& shard : shards_) {
+            shardGuards_.emplace_back(boost::asio::make_work_guard(*shard->io));
+        }
+        SPDLOG_INFO("IO sharding enabled: shards={} policy={} pin={}", shards_.size(), sc.shardPolicy, pinIoThreads_);
+    }
+
+    acceptBatch_ = std::max<std::size_t>(1, sc.acceptBatch);
+    openListeners(port);
+
     // 开始接受连接
     doAccept();
 
@@ -31,8 +85,27 @@ AsioServer::AsioServer(unsigned short port, size_t ioThreadsCount, std::uint64_t
 }
 
 void AsioServer::run() {
+    if (sharded_) {
+        // 分片模式：第 i 个线程只跑第 i 个 io_context
+        for (std::size_t i = 0; i < shards_.size(); ++i) {
+            ioThreads_.emplace_back([this, i]() {
+                if (pinIoThreads_) {
+                    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+                    pinCurrentThread(i % cores);
+                }
+                try {
+                    accepting_.store(true, std::memory_order_relaxed);
+                    shards_[i]->io->run();
+                    accepting_.store(false, std::memory_order_relaxed);
+                } catch (const std::exception& e) {
+                    SPDLOG_ERROR("IO shard {} exception: {}", i, e.what());
+                }
+            });
+        }
+    }
+
     // 启动线程池处理I/O事件
-    for (size_t i = 0; i < ioThreadsCount_; ++i) {
+    for (size_t i = 0; !sharded_ && i < ioThreadsCount_; ++i) {
         ioThreads_.emplace_back([this]() {
             try {
                 accepting_.store(true, std::memory_order_relaxed);
@@ -53,14 +126,23 @@ void AsioServer::run() {
 
 void AsioServer::stop() {
     stopAccept();
-    io_context_.stop();
+    shardGuards_.clear();
+    for (auto& shard : shards_) {
+        shard->io->stop();
+    }
 }
 
 void AsioServer::stopAccept() {
     accepting_.store(false, std::memory_order_relaxed);
     boost::system::error_code ec;
-    acceptor_.cancel(ec);
-    acceptor_.close(ec);
+    for (auto& l : listeners_) {
+        boost::system::error_code closeEc;
+        l.acceptor->cancel(closeEc);
+        l.acceptor->close(closeEc);
+        if (closeEc) {
+            ec = closeEc;
+        }
+    }
     if (ec) {
         SPDLOG_WARN("stopAccept error: {}", ec.message());
     } else {
@@ -73,70 +155,84 @@ void AsioServer::closeAllConnections() {
     connectionManager_.forEach([](const ConnectionPtr& c) { c->close(); });
 }
 
+void AsioServer::openListeners(unsigned short port) {
+    const auto& sc = Config::Instance().server();
+    tcp::endpoint ep(tcp::v4(), port);
+
+    std::size_t count = 1;
+    if (sc.reusePort) {
+        count = sc.acceptorCount > 0 ? sc.acceptorCount : ioThreadsCount_;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Listener l;
+        // 分片模式下 acceptor 分散到各分片，accept 与后续读写都在同一线程上完成
+        l.shardIdx = sharded_ ? i % shards_.size() : 0;
+        l.acceptor = std::make_unique<tcp::acceptor>(*shards_[l.shardIdx]->io);
+        l.acceptor->open(ep.protocol());
+        l.acceptor->set_option(tcp::acceptor::reuse_address(true));
+        if (sc.reusePort) {
+#ifdef SO_REUSEPORT
+            l.acceptor->set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            SPDLOG_WARN("SO_REUSEPORT not supported on this platform, fallback to single acceptor");
+            count = 1;
+#endif
+        }
+        l.acceptor->bind(ep);
+        l.acceptor->listen(boost::asio::socket_base::max_listen_connections);
+        // 仅影响同步 accept：批量接入时队列为空立即返回 would_block
+        l.acceptor->non_blocking(true);
+        l.stats = &MetricsRegistry::Instance().acceptorStats(i);
+        listeners_.push_back(std::move(l));
+    }
+    if (listeners_.size() > 1) {
+        SPDLOG_INFO("SO_REUSEPORT listeners: count={} acceptBatch={}", listeners_.size(), acceptBatch_);
+    }
+}
+
 void AsioServer::doAccept() {
-    boost::asio::co_spawn(io_context_, acceptLoop(), boost::asio::detached);
+    for (std::size_t i = 0; i < listeners_.size(); ++i) {
+        boost::asio::co_spawn(listeners_[i].acceptor->get_executor(), acceptLoop(i), boost::asio::detached);
+    }
 }
 
-boost::asio::awaitable<void> AsioServer::acceptLoop() {
+boost::asio::awaitable<void> AsioServer::acceptLoop(std::size_t idx) {
     using boost::asio::use_awaitable;
+    auto& listener = listeners_[idx];
+    auto& acceptor = *listener.acceptor;
     try {
         for (;;) {
-            if (!acceptor_.is_open()) {
+            if (!acceptor.is_open()) {
                 co_return;
             }
 
-            // 每个连接绑定独立 strand，确保单连接的 handler 串行执行
-            tcp::socket socket{boost::asio::make_strand(io_context_)};
-            co_await acceptor_.async_accept(socket, use_awaitable);
-
-            // 在连接建立后、创建 AsioConnection 之前，检查这个 IP 是否已经达到最大连接数，如果超过，就立即拒绝新连接
-            auto remoteIp = socket.remote_endpoint().address().to_string();
-            const auto& ipCfg = Config::Instance().ipLimit();
-            bool ipAllowed = IpLimiter::Instance().allowConn(remoteIp);
-            if (!ipAllowed) {
-                MetricsRegistry::Instance().incIpRejectConn();
-                MetricsRegistry::Instance().setIpRejectConnTrace("", "");
-                auto rejectConn = std::make_shared<AsioConnection>(io_context_, std::move(socket));
-                MetricsRegistry::Instance().setIpRejectConnTrace(rejectConn->traceId(), rejectConn->sessionId());
-                rejectConn->close();
-                TraceContext::Guard g(rejectConn->traceId(), rejectConn->sessionId());
-                SPDLOG_WARN("[IpLimit] reject conn from {} (maxConnPerIp={})", remoteIp, ipCfg.maxConnPerIp);
-                continue;
-            }
-
-            auto connection = std::make_shared<AsioConnection>(io_context_, std::move(socket), Config::Instance().limits().maxSendBufferBytes);
-
-            connectionManager_.add(connection);
-            idleManager_.add(connection);
+            std::size_t shardIdx = connectionShard(listener);
+            tcp::socket socket{connectionExecutor(shardIdx)};
+            co_await acceptor.async_accept(socket, use_awaitable);
+            listener.stats->wakeups.inc();
+            sampleBacklog(listener);
+            listener.stats->accepted.inc();
+            onAccepted(std::move(socket), shardIdx);
 
-            // connection 计数 +1
-            MetricsRegistry::Instance().connections().inc();
-
-            // 设置连接的回调
-            connection->setMessageCallback([this](const ConnectionPtr& conn, Buffer& buf) {
-                if (!messageCallback_) {
-                    return;
+            // 批量接入：一次唤醒后继续非阻塞地取走已完成握手的连接，直到队列为空或达到上限
+            for (std::size_t n = 1; n < acceptBatch_ && acceptor.is_open(); ++n) {
+                boost::system::error_code ec;
+                std::size_t nextShard = connectionShard(listener);
+                tcp::socket more = acceptor.accept(connectionExecutor(nextShard), ec);
+                if (ec) {
+                    if (ec != boost::asio::error::would_block && ec != boost::asio::error::try_again) {
+                        SPDLOG_WARN("Batch accept error: {}", ec.message());
+                    }
+                    break;
                 }
-                messageCallback_(conn, buf);
-            });
-
-            // 设置关闭回调
-            connection->setCloseCallback([this](const ConnectionPtr& conn) {
-                connectionManager_.remove(conn);
-                idleManager_.remove(conn);
-                MetricsRegistry::Instance().connections().inc(-1);
-                IpLimiter::Instance().onConnClose(conn->remoteIp());
-                if (closeCallback_) {
-                    closeCallback_(conn);
-                }
-                scheduleMetricsReport();
-            });
-
-            connection->start();
+                listener.stats->accepted.inc();
+                onAccepted(std::move(more), nextShard);
+            }
         }
     } catch (const boost::system::system_error& e) {
         auto ec = e.code();
-        if (ec == boost::asio::error::operation_aborted || !acceptor_.is_open()) {
+        if (ec == boost::asio::error::operation_aborted || !acceptor.is_open()) {
             co_return;
         }
         SPDLOG_ERROR("Accept error: {}", ec.message());
@@ -145,6 +241,138 @@ boost::asio::awaitable<void> AsioServer::acceptLoop() {
     }
 }
 
+void AsioServer::onAccepted(tcp::socket socket, std::size_t shardIdx) {
+    auto& shard = *shards_[shardIdx];
+
+    // 对端可能在握手后立刻断开，此时直接丢弃，不能让异常打断 accept 循环
+    boost::system::error_code epEc;
+    auto remoteEp = socket.remote_endpoint(epEc);
+    if (epEc) {
+        return;
+    }
+
+    // 创建 AsioConnection 之前先过 CIDR 访问控制：deny 直接关闭 socket，allow 为可信 IP、不受 IpLimiter 限制
+    const auto ipKey = IpKey::FromAddress(remoteEp.address());
+    const auto aclVerdict = IpAcl::Instance().check(ipKey);
+    if (aclVerdict == IpAcl::Verdict::Deny) {
+        MetricsRegistry::Instance().ipAclRejects().inc();
+        boost::system::error_code closeEc;
+        socket.close(closeEc);
+        // 日志采样：被封网段可能持续重连
+        static thread_local std::uint64_t s_denyCount = 0;
+        if (++s_denyCount % 1000 == 1) {
+            SPDLOG_WARN("[IpAcl] deny conn from {} (sampled, total={})", remoteEp.address().to_string(), MetricsRegistry::Instance().ipAclRejects().value());
+        }
+        return;
+    }
+    const bool ipTrusted = aclVerdict == IpAcl::Verdict::Allow;
+
+    // 检查这个 IP 是否已经达到最大连接数，如果超过，就立即拒绝新连接
+    const auto& ipCfg = Config::Instance().ipLimit();
+    bool ipAllowed = ipTrusted || IpLimiter::Instance().allowConn(ipKey);
+    if (!ipAllowed) {
+        MetricsRegistry::Instance().incIpRejectConn();
+        MetricsRegistry::Instance().setIpRejectConnTrace("", "");
+        auto rejectConn = std::make_shared<AsioConnection>(*shard.io, std::move(socket));
+        MetricsRegistry::Instance().setIpRejectConnTrace(rejectConn->traceId(), rejectConn->sessionId());
+        rejectConn->close();
+        TraceContext::Guard g(rejectConn->traceId(), rejectConn->sessionId());
+        SPDLOG_WARN("[IpLimit] reject conn from {} (maxConnPerIp={})", remoteEp.address().to_string(), ipCfg.maxConnPerIp);
+        return;
+    }
+
+    auto connection = std::make_shared<AsioConnection>(*shard.io, std::move(socket), Config::Instance().limits().maxSendBufferBytes);
+    connection->setIpTrusted(ipTrusted);
+    connection->setZeroCopyThreshold(Config::Instance().server().zeroCopyThreshold);
+    {
+        const auto& sc = Config::Instance().server();
+        auto cork = sc.writeCork == "msgMore" ? AsioConnection::CorkMode::MsgMore : sc.writeCork == "cork" ? AsioConnection::CorkMode::Cork : AsioConnection::CorkMode::Off;
+        connection->setWriteCoalescing(sc.writeBatchMaxFrames, sc.writeBatchMaxBytes, cork, sc.flushOnReadEnd);
+        connection->setReadBufferLimits(sc.readBufferMin, sc.readBufferMax, sc.releaseIdleReadBuffer ? sc.releaseIdleReadAfter : 0);
+    }
+
+    connectionManager_.add(connection);
+    idleManager_.add(connection);
+    shard.connections.fetch_add(1, std::memory_order_relaxed);
+
+    // connection 计数 +1
+    MetricsRegistry::Instance().connections().inc();
+
+    // 设置连接的回调
+    connection->setMessageCallback([this](const ConnectionPtr& conn, Buffer& buf) {
+        if (!messageCallback_) {
+            return;
+        }
+        messageCallback_(conn, buf);
+    });
+
+    // 设置关闭回调
+    connection->setCloseCallback([this, shardIdx](const ConnectionPtr& conn) {
+        shards_[shardIdx]->connections.fetch_sub(1, std::memory_order_relaxed);
+        connectionManager_.remove(conn);
+        idleManager_.remove(conn);
+        MetricsRegistry::Instance().connections().inc(-1);
+        if (const auto& ipKey = conn->remoteIpKey(); ipKey && !conn->ipTrusted()) {
+            IpLimiter::Instance().onConnClose(*ipKey);
+        }
+        if (closeCallback_) {
+            closeCallback_(conn);
+        }
+        scheduleMetricsReport();
+    });
+
+    connection->start();
+}
+
+void AsioServer::sampleBacklog(Listener& listener) {
+#ifdef __linux__
+    // 监听 socket 上 tcpi_unacked 为当前 accept 队列长度，tcpi_sacked 为队列上限
+    struct tcp_info info {};
+    socklen_t len = sizeof(info);
+    if (::getsockopt(listener.acceptor->native_handle(), IPPROTO_TCP, TCP_INFO, &info, &len) == 0) {
+        listener.stats->backlog.set(info.tcpi_unacked);
+        listener.stats->backlogMax.set(info.tcpi_sacked);
+    }
+#endif
+}
+
+std::size_t AsioServer::connectionShard(const Listener& listener) {
+    if (sharded_ && listeners_.size() == shards_.size()) {
+        return listener.shardIdx;
+    }
+    return pickShard();
+}
+
+boost::asio::any_io_executor AsioServer::connectionExecutor(std::size_t shardIdx) {
+    auto& io = *shards_[shardIdx]->io;
+    if (sharded_) {
+        return io.get_executor();
+    }
+    return boost::asio::make_strand(io);
+}
+
+std::size_t AsioServer::pickShard() {
+    if (shards_.size() == 1) {
+        return 0;
+    }
+    if (!leastConn_) {
+        return nextShard_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+    }
+    // leastConn：从轮询起点开始扫描，负载相同时依旧均匀分散
+    std::size_t start = nextShard_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t best = start % shards_.size();
+    std::size_t bestLoad = shards_[best]->connections.load(std::memory_order_relaxed);
+    for (std::size_t i = 1; i < shards_.size(); ++i) {
+        std::size_t idx = (start + i) % shards_.size();
+        std::size_t load = shards_[idx]->connections.load(std::memory_order_relaxed);
+        if (load < bestLoad) {
+            best = idx;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
 void AsioServer::scheduleMetricsReport() {
     using namespace std::chrono_literals;
     metricsTimer_.expires_after(5s);
@@ -182,4 +410,8 @@ std::size_t AsioServer::connectionCount() const { return connectionManager_.size
 
 boost::asio::io_context& AsioServer::ioContext() { return io_context_; }
 
+std::size_t AsioServer::shardCount() const { return shards_.size(); }
+
+boost::asio::io_context& AsioServer::ioContext(std::size_t idx) { return *shards_[idx % shards_.size()]->io; }
+
 bool AsioServer::isAccepting() const { return accepting_.load(std::memory_order_relaxed); }
@@ -2,11 +2,84 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
+#include "ReplySequencer.h"
+#include "TrafficAnalytics.h"
+
+// 正在接收 body 的流式帧（stream 为空表示丢弃超长/被拒绝帧的 body）
+struct InboundBody {
+    FrameStreamPtr stream;
+    std::uint64_t remaining{0};
+};
+
 LengthHeaderCodec::LengthHeaderCodec(FrameCallback cb) : frameCallback_(std::move(cb)) {}
 
+LengthHeaderCodec::LengthHeaderCodec(FrameBatchCallback cb) : batchCallback_(std::move(cb)) {}
+
+void LengthHeaderCodec::setMaxFrameBytes(std::size_t bytes, OversizeCallback onOversize) {
+    maxFrameBytes_ = bytes;
+    oversizeCallback_ = std::move(onOversize);
+}
+
+void LengthHeaderCodec::setStreamOpener(StreamOpener opener) { streamOpener_ = std::move(opener); }
+
+InboundBody* LengthHeaderCodec::beginInbound(const ConnectionPtr& conn, FrameStreamPtr stream, std::uint64_t bodyLen) {
+    auto state = std::make_shared<InboundBody>();
+    state->stream = std::move(stream);
+    state->remaining = bodyLen;
+    conn->codecState() = state;
+    return state.get();
+}
+
+void LengthHeaderCodec::endInbound(const ConnectionPtr& conn) {
+    auto* state = static_cast<InboundBody*>(conn->codecState().get());
+    if (state != nullptr && state->stream) {
+        state->stream->finish();
+        MetricsRegistry::Instance().totalFrames().inc();
+    }
+    conn->codecState().reset();
+}
+
+FrameBody LengthHeaderCodec::makeBody(const BufferPool::Ptr* owner, const char* p, std::size_t n) {
+    if (owner != nullptr && n >= kSliceMinBytes) {
+        return FrameBody(*owner, p, n);
+    }
+    return FrameBody::copyOf(std::string_view(p, n));
+}
+
 void LengthHeaderCodec::onMessage(const ConnectionPtr& conn, Buffer& buf) {
     constexpr std::size_t headerlen = 4 + 2;
+    // 只有连接自己的读缓冲才能被 body 引用（连接会在回调后检测引用并换新缓冲）
+    const BufferPool::Ptr* owner = nullptr;
+    if (conn && conn->readBufferOwner() && conn->readBufferOwner().get() == &buf) {
+        owner = &conn->readBufferOwner();
+    }
+    std::size_t pending = 0;  // 半包还差的字节数，回传给连接做一次性读取
+    std::vector<DecodedFrame> batch;  // 批量模式下本次读取解出的帧
+    auto* inbound = conn ? static_cast<InboundBody*>(conn->codecState().get()) : nullptr;
+    // 本次读取解出的帧数/字节数（按帧头计，含流式与超长帧），结束时一次性交给 TrafficAnalytics
+    std::uint32_t frames = 0;
+    std::uint64_t bytes = 0;
     while (true) {
+        // 0. 流式帧/被丢弃帧的 body：到多少交多少，不在读缓冲里攒整帧
+        if (inbound != nullptr) {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(inbound->remaining, buf.readableBytes()));
+            if (n > 0) {
+                if (inbound->stream) {
+                    inbound->stream->push(makeBody(owner, buf.peek(), n));
+                }
+                buf.retrieve(n);
+                inbound->remaining -= n;
+            }
+            if (inbound->remaining > 0) {
+                break;
+            }
+            endInbound(conn);
+            inbound = nullptr;
+            continue;
+        }
+
         // 1. 先看头是否完整
         if (buf.readableBytes() < headerlen) {
             break;
@@ -22,9 +95,43 @@ void LengthHeaderCodec::onMessage(const ConnectionPtr& conn, Buffer& buf) {
             break;
         }
 
-        std::uint32_t totalLen = 4 + len;
+        // 流式路由：消费掉帧头，body 之后按块交给流
+        if (streamOpener_ && conn) {
+            std::uint16_t type = decodeUint16(p + 4);
+            FrameStreamPtr stream;
+            if (streamOpener_(conn, type, len - 2, stream)) {
+                ++frames;
+                bytes += 4ull + len;
+                buf.retrieve(headerlen);
+                inbound = beginInbound(conn, std::move(stream), len - 2);
+                continue;
+            }
+        }
+
+        // 超长帧：只凭帧头就拒绝，body 到达即丢弃，连接保持可用
+        if (maxFrameBytes_ > 0 && len > maxFrameBytes_) {
+            std::uint16_t type = decodeUint16(p + 4);
+            MetricsRegistry::Instance().totalErrors().inc();
+            MetricsRegistry::Instance().droppedFrames().inc();
+            SPDLOG_WARN("[Codec] frame too large len={} max={} msgType={}", len, maxFrameBytes_, type);
+            if (oversizeCallback_ && conn) {
+                oversizeCallback_(conn, type, len);
+            }
+            ++frames;
+            bytes += 4ull + len;
+            buf.retrieve(headerlen);
+            if (!conn) {
+                buf.retrieveAll();
+                break;
+            }
+            inbound = beginInbound(conn, nullptr, len - 2);
+            continue;
+        }
+
+        std::uint64_t totalLen = 4ull + len;
         if (buf.readableBytes() < totalLen) {
             // 一个完整 frame 还没到齐，退出等待下次
+            pending = static_cast<std::size_t>(totalLen - buf.readableBytes());
             break;
         }
 
@@ -41,22 +148,27 @@ void LengthHeaderCodec::onMessage(const ConnectionPtr& conn, Buffer& buf) {
         std::uint16_t msgType = decodeUint16(buf.peek());
         buf.retrieve(2);
 
-        // 5. 读取 body
+        // 5. 读取 body：大 body 直接引用读缓冲，小 body 拷贝
         std::uint32_t bodyLen = len - 2;
-        std::string body;
-        body.resize(bodyLen);
+        FrameBody body;
         if (bodyLen > 0) {
             if (buf.readableBytes() < bodyLen) {
                 // 理论上也不会发生（已经保证 totalLen 够）
                 buf.retrieveAll();
                 break;
             }
-            std::memcpy(body.data(), buf.peek(), bodyLen);
+            body = makeBody(owner, buf.peek(), bodyLen);
+            // retrieve 只移动下标、不改写字节；回调结束后连接发现缓冲仍被引用会换新缓冲再读
             buf.retrieve(bodyLen);
         }
 
+        ++frames;
+        bytes += totalLen;
+
         // 6. 调用上层回调 + 统计 Metrics（真正成功解出了一帧）
-        if (frameCallback_) {
+        if (batchCallback_) {
+            batch.push_back(DecodedFrame{msgType, std::move(body)});
+        } else if (frameCallback_) {
             auto start = std::chrono::steady_clock::now();
 
             try {
@@ -78,20 +190,73 @@ void LengthHeaderCodec::onMessage(const ConnectionPtr& conn, Buffer& buf) {
         }
         // 7. while(true) 继续尝试解析下一帧（如果 Buffer 中还有完整数据）
     }
+
+    if (!batch.empty()) {
+        deliverBatch(conn, batch);
+    }
+
+    if (conn) {
+        conn->setReadHint(pending);
+        if (frames > 0) {
+            TrafficAnalytics::Instance().record(conn->remoteIpKey(), conn->sessionId(), frames, bytes);
+        }
+    }
+}
+
+void LengthHeaderCodec::deliverBatch(const ConnectionPtr& conn, std::vector<DecodedFrame>& batch) {
+    const std::size_t n = batch.size();
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        batchCallback_(conn, batch);
+        MetricsRegistry::Instance().totalFrames().inc(static_cast<std::int64_t>(n));
+    } catch (const std::exception& ex) {
+        MetricsRegistry::Instance().totalErrors().inc();
+        std::cerr << "[Codec] FrameBatchCallback exception: " << ex.what() << "\n";
+    } catch (...) {
+        MetricsRegistry::Instance().totalErrors().inc();
+        std::cerr << "[Codec] FrameBatchCallback unknown exception\n";
+    }
+
+    // 每帧的耗时按整批投递耗时记录，与逐帧模式口径一致（都是“交给上层”这一步的耗时）
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(end - start).count();
+    for (std::size_t i = 0; i < n; ++i) {
+        MetricsRegistry::Instance().frameLatency().observe(ms);
+    }
+    MetricsRegistry::Instance().setFrameLatencyTrace(conn ? conn->traceId() : "", conn ? conn->sessionId() : "", ms);
 }
 
-void LengthHeaderCodec::onClose(const ConnectionPtr& conn) {}
+void LengthHeaderCodec::onClose(const ConnectionPtr& conn) {
+    if (!conn) {
+        return;
+    }
+    // 流式帧 body 未收完：通知 handler 中断
+    auto* state = static_cast<InboundBody*>(conn->codecState().get());
+    if (state != nullptr && state->stream) {
+        state->stream->abort();
+    }
+    conn->codecState().reset();
+}
 
 void LengthHeaderCodec::send(const ConnectionPtr& conn, uint16_t msgType, const std::string& body) {
     std::uint32_t len = 2 + static_cast<std::uint32_t>(body.size());
-    std::size_t totalSize = 4 + 2 + body.size();
+    std::uint32_t netLen = htonl(len);
+    std::uint16_t netType = htons(msgType);
 
-    auto buf = BufferPool::Instance().acquire(totalSize);
+    // 有序请求执行期间，回包先写入该请求的回包槽，由 ConnectionOrdering 按请求顺序发出
+    if (auto* slot = ReplySlot::current(); slot && slot->owns(conn.get())) {
+        slot->append(&netLen, sizeof(netLen));
+        slot->append(&netType, sizeof(netType));
+        if (!body.empty()) {
+            slot->append(body.data(), body.size());
+        }
+        return;
+    }
 
-    std::uint32_t netLen = htonl(len);
+    std::size_t totalSize = 4 + 2 + body.size();
+    auto buf = BufferPool::Instance().acquire(totalSize);
     buf->append(&netLen, sizeof(netLen));
-
-    std::uint16_t netType = htons(msgType);
     buf->append(&netType, sizeof(netType));
 
     if (!body.empty()) {
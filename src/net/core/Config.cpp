@@ -1,5 +1,7 @@
 #include "Config.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 #include "Util.h"
@@ -25,6 +27,17 @@ static std::int64_t getIntField(lua_State* L, const char* key, std::int64_t defa
     return v;
 }
 
+// 辅助函数：从 table 中读取字符串字段（带默认值）
+static std::string getStringField(lua_State* L, const char* key, const std::string& defaultVal) {
+    lua_getfield(L, -1, key);
+    std::string v = defaultVal;
+    if (lua_isstring(L, -1)) {
+        v = lua_tostring(L, -1);
+    }
+    lua_pop(L, 1);
+    return v;
+}
+
 static void parseStringSet(lua_State* L, const char* key, std::unordered_set<std::string>& out) {
     lua_getfield(L, -1, key);
     if (lua_istable(L, -1)) {
@@ -86,9 +99,21 @@ bool Config::loadFromFile(const std::string& path) {
 
     bool ok = parseLuaConfig(L);
     lua_close(L);
+    sourcePath_ = path;
     return ok;
 }
 
+const std::string& Config::sourcePath() const { return sourcePath_; }
+
+bool Config::ReadIpLimit(const std::string& path, IpLimitConfig& out) {
+    Config fresh;
+    if (!fresh.loadFromFile(path)) {
+        return false;
+    }
+    out = fresh.ipLimitCfg_;
+    return true;
+}
+
 const ServerConfig& Config::server() const { return serverCfg_; }
 
 const LogConfig& Config::log() const { return logCfg_; }
@@ -101,8 +126,14 @@ const BackpressureConfig& Config::backpressure() const { return backpressureCfg_
 
 const IpLimitConfig& Config::ipLimit() const { return ipLimitCfg_; }
 
+const AnalyticsConfig& Config::analytics() const { return analyticsCfg_; }
+
 const ErrorFrames& Config::errorFrames() const { return errorFrames_; }
 
+const std::unordered_map<std::uint16_t, RouteConfig>& Config::routes() const { return routesCfg_; }
+
+const std::unordered_map<std::string, WorkerPoolConfig>& Config::workerPools() const { return workerPoolsCfg_; }
+
 const std::unordered_map<std::uint16_t, MsgLimitConfig>& Config::msgLimits() const { return msgLimitsCfg_; }
 
 bool Config::parseLuaConfig(void* pL) {
@@ -122,11 +153,82 @@ bool Config::parseLuaConfig(void* pL) {
         serverCfg_.port = static_cast<unsigned short>(getIntField(L, "port", serverCfg_.port));
         serverCfg_.ioThreadsCount = static_cast<std::size_t>(getIntField(L, "ioThreadsCount", serverCfg_.ioThreadsCount));
         serverCfg_.IdleTimeoutMs = static_cast<std::uint64_t>(getIntField(L, "IdleTimeoutMs", serverCfg_.IdleTimeoutMs));
+
+        serverCfg_.shardedIo = getBoolField(L, "shardedIo", serverCfg_.shardedIo);
+        serverCfg_.shardPolicy = getStringField(L, "shardPolicy", serverCfg_.shardPolicy);
+        serverCfg_.pinIoThreads = getBoolField(L, "pinIoThreads", serverCfg_.pinIoThreads);
+        if (serverCfg_.shardPolicy != "roundRobin" && serverCfg_.shardPolicy != "leastConn") {
+            std::cerr << "[Config] invalid server.shardPolicy=" << serverCfg_.shardPolicy << " (expect roundRobin/leastConn), fallback to roundRobin\n";
+            serverCfg_.shardPolicy = "roundRobin";
+        }
+
+        serverCfg_.reusePort = getBoolField(L, "reusePort", serverCfg_.reusePort);
+        serverCfg_.acceptorCount = static_cast<std::size_t>(getIntField(L, "acceptorCount", serverCfg_.acceptorCount));
+        serverCfg_.acceptBatch = static_cast<std::size_t>(getIntField(L, "acceptBatch", serverCfg_.acceptBatch));
+        serverCfg_.acceptorCount = Util::ClampWithWarning<std::size_t>("server.acceptorCount", serverCfg_.acceptorCount, 0, 1024, 0);
+        serverCfg_.acceptBatch = Util::ClampWithWarning<std::size_t>("server.acceptBatch", serverCfg_.acceptBatch, 1, 4096, 16);
+
+        serverCfg_.readBufferMin = static_cast<std::size_t>(getIntField(L, "readBufferMin", serverCfg_.readBufferMin));
+        serverCfg_.readBufferMax = static_cast<std::size_t>(getIntField(L, "readBufferMax", serverCfg_.readBufferMax));
+        serverCfg_.releaseIdleReadBuffer = getBoolField(L, "releaseIdleReadBuffer", serverCfg_.releaseIdleReadBuffer);
+        serverCfg_.releaseIdleReadAfter = static_cast<std::uint32_t>(getIntField(L, "releaseIdleReadAfter", serverCfg_.releaseIdleReadAfter));
+        serverCfg_.releaseIdleReadAfter = Util::ClampWithWarning<std::uint32_t>("server.releaseIdleReadAfter", serverCfg_.releaseIdleReadAfter, 1, 1 << 20, 8);
+        serverCfg_.readBufferMin = Util::ClampWithWarning<std::size_t>("server.readBufferMin", serverCfg_.readBufferMin, 256, 1 << 20, 1024);
+        serverCfg_.readBufferMax = Util::ClampWithWarning<std::size_t>("server.readBufferMax", serverCfg_.readBufferMax, serverCfg_.readBufferMin, 16 << 20, std::max<std::size_t>(serverCfg_.readBufferMin, 64 * 1024));
+
+        serverCfg_.writeBatchMaxFrames = static_cast<std::size_t>(getIntField(L, "writeBatchMaxFrames", serverCfg_.writeBatchMaxFrames));
+        serverCfg_.writeBatchMaxBytes = static_cast<std::size_t>(getIntField(L, "writeBatchMaxBytes", serverCfg_.writeBatchMaxBytes));
+        serverCfg_.writeCork = getStringField(L, "writeCork", serverCfg_.writeCork);
+        serverCfg_.flushOnReadEnd = getBoolField(L, "flushOnReadEnd", serverCfg_.flushOnReadEnd);
+        serverCfg_.writeBatchMaxFrames = Util::ClampWithWarning<std::size_t>("server.writeBatchMaxFrames", serverCfg_.writeBatchMaxFrames, 1, 1024, 64);
+        serverCfg_.writeBatchMaxBytes = Util::ClampWithWarning<std::size_t>("server.writeBatchMaxBytes", serverCfg_.writeBatchMaxBytes, 1024, 64 << 20, 256 * 1024);
+        if (serverCfg_.writeCork != "off" && serverCfg_.writeCork != "msgMore" && serverCfg_.writeCork != "cork") {
+            std::cerr << "[Config] invalid server.writeCork=" << serverCfg_.writeCork << " (expect off/msgMore/cork), fallback to off\n";
+            serverCfg_.writeCork = "off";
+        }
+
+        serverCfg_.zeroCopyThreshold = static_cast<std::size_t>(getIntField(L, "zeroCopyThreshold", serverCfg_.zeroCopyThreshold));
+        if (serverCfg_.zeroCopyThreshold > 0 && serverCfg_.zeroCopyThreshold < 4096) {
+            // 小于一页时 pin 页 + 完成通知的开销大于拷贝本身
+            std::cerr << "[Config] server.zeroCopyThreshold=" << serverCfg_.zeroCopyThreshold << " too small, raise to 4096\n";
+            serverCfg_.zeroCopyThreshold = 4096;
+        }
+
+        serverCfg_.maxFrameBytes = static_cast<std::size_t>(getIntField(L, "maxFrameBytes", serverCfg_.maxFrameBytes));
+        serverCfg_.streamWindowBytes = static_cast<std::size_t>(getIntField(L, "streamWindowBytes", serverCfg_.streamWindowBytes));
+        if (serverCfg_.maxFrameBytes > 0) {
+            // 帧头 len 为 32 位，且至少要能容纳 msgType
+            serverCfg_.maxFrameBytes = Util::ClampWithWarning<std::size_t>("server.maxFrameBytes", serverCfg_.maxFrameBytes, 64, 0xFFFFFFFFu, 16 * 1024 * 1024);
+        }
+        serverCfg_.streamWindowBytes = Util::ClampWithWarning<std::size_t>("server.streamWindowBytes", serverCfg_.streamWindowBytes, 4096, 256 << 20, 1024 * 1024);
+
+        serverCfg_.ordering = getStringField(L, "ordering", serverCfg_.ordering);
+        if (serverCfg_.ordering != "none" && serverCfg_.ordering != "strict" && serverCfg_.ordering != "inOrder") {
+            std::cerr << "[Config] invalid server.ordering=" << serverCfg_.ordering << " (expect none/strict/inOrder), fallback to none\n";
+            serverCfg_.ordering = "none";
+        }
+
+        serverCfg_.ioBackend = getStringField(L, "ioBackend", serverCfg_.ioBackend);
+        serverCfg_.epollBinary = getStringField(L, "epollBinary", serverCfg_.epollBinary);
+        serverCfg_.ioUringBinary = getStringField(L, "ioUringBinary", serverCfg_.ioUringBinary);
+        if (serverCfg_.ioBackend != "epoll" && serverCfg_.ioBackend != "io_uring") {
+            std::cerr << "[Config] invalid server.ioBackend=" << serverCfg_.ioBackend << " (expect epoll/io_uring), fallback to epoll\n";
+            serverCfg_.ioBackend = "epoll";
+        }
     } else {
         std::cerr << "[Config] 'config.server' not found or not a table, use defaults\n";
     }
     lua_pop(L, 1);  // pop server
 
+    // 环境变量 DOMAIN_IO_BACKEND 覆盖 server.ioBackend：同一份配置分别跑两种后端（如 scripts/bench_backends.sh）
+    if (const char* backend = std::getenv("DOMAIN_IO_BACKEND"); backend != nullptr && *backend != '\0') {
+        if (std::string(backend) == "epoll" || std::string(backend) == "io_uring") {
+            serverCfg_.ioBackend = backend;
+        } else {
+            std::cerr << "[Config] invalid DOMAIN_IO_BACKEND=" << backend << " (expect epoll/io_uring), ignored\n";
+        }
+    }
+
     // ==== thread_pool ====（兼容 threadPool / thread_pool）
     lua_getfield(L, -1, "threadPool");
     if (!lua_istable(L, -1)) {
@@ -143,6 +245,10 @@ bool Config::parseLuaConfig(void* pL) {
         threadPoolCfg_.lowWatermark = static_cast<std::size_t>(getIntField(L, "lowWatermark", threadPoolCfg_.lowWatermark));
         threadPoolCfg_.upThreshold = static_cast<int>(getIntField(L, "upThreshold", threadPoolCfg_.upThreshold));
         threadPoolCfg_.downThreshold = static_cast<int>(getIntField(L, "downThreshold", threadPoolCfg_.downThreshold));
+        threadPoolCfg_.queueWaitSloUs = static_cast<std::size_t>(getIntField(L, "queueWaitSloUs", threadPoolCfg_.queueWaitSloUs));
+        threadPoolCfg_.autoTuneIntervalMs = static_cast<std::size_t>(getIntField(L, "autoTuneIntervalMs", threadPoolCfg_.autoTuneIntervalMs));
+        threadPoolCfg_.idleSpinUs = static_cast<std::size_t>(getIntField(L, "idleSpinUs", threadPoolCfg_.idleSpinUs));
+        threadPoolCfg_.frameBatchSize = static_cast<std::size_t>(getIntField(L, "frameBatchSize", threadPoolCfg_.frameBatchSize));
 
         // 校验并回退
         threadPoolCfg_.workerThreadsCount = Util::ClampWithWarning<std::size_t>("threadPool.workerThreadsCount", threadPoolCfg_.workerThreadsCount, 1, 1024, 4);
@@ -155,8 +261,12 @@ bool Config::parseLuaConfig(void* pL) {
         threadPoolCfg_.maxQueueSize = Util::ClampWithWarning<std::size_t>("threadPool.maxQueueSize", threadPoolCfg_.maxQueueSize, 0, 1'000'000, 10000);
         threadPoolCfg_.highWatermark = Util::ClampWithWarning<std::size_t>("threadPool.highWatermark", threadPoolCfg_.highWatermark, 0, threadPoolCfg_.maxQueueSize, 2000);
         threadPoolCfg_.lowWatermark = Util::ClampWithWarning<std::size_t>("threadPool.lowWatermark", threadPoolCfg_.lowWatermark, 0, threadPoolCfg_.highWatermark, 0);
-        threadPoolCfg_.upThreshold = Util::ClampWithWarning<int>("threadPool.upThreshold", threadPoolCfg_.upThreshold, 1, 100, 3);
+        threadPoolCfg_.upThreshold = Util::ClampWithWarning<int>("threadPool.upThreshold", threadPoolCfg_.upThreshold, 1, 100, 2);
         threadPoolCfg_.downThreshold = Util::ClampWithWarning<int>("threadPool.downThreshold", threadPoolCfg_.downThreshold, 1, 100, 10);
+        threadPoolCfg_.queueWaitSloUs = Util::ClampWithWarning<std::size_t>("threadPool.queueWaitSloUs", threadPoolCfg_.queueWaitSloUs, 1, 10'000'000, 5000);
+        threadPoolCfg_.autoTuneIntervalMs = Util::ClampWithWarning<std::size_t>("threadPool.autoTuneIntervalMs", threadPoolCfg_.autoTuneIntervalMs, 10, 60'000, 100);
+        threadPoolCfg_.idleSpinUs = Util::ClampWithWarning<std::size_t>("threadPool.idleSpinUs", threadPoolCfg_.idleSpinUs, 0, 10'000, 50);
+        threadPoolCfg_.frameBatchSize = Util::ClampWithWarning<std::size_t>("threadPool.frameBatchSize", threadPoolCfg_.frameBatchSize, 0, 4096, 32);
     } else {
         std::cerr << "[Config] 'config.threadPool' not found or not a table, use defaults\n";
     }
@@ -266,15 +376,34 @@ bool Config::parseLuaConfig(void* pL) {
     if (lua_istable(L, -1)) {
         ipLimitCfg_.maxConnPerIp = static_cast<std::size_t>(getIntField(L, "maxConnPerIp", ipLimitCfg_.maxConnPerIp));
         ipLimitCfg_.maxQpsPerIp = static_cast<std::size_t>(getIntField(L, "maxQpsPerIp", ipLimitCfg_.maxQpsPerIp));
+        ipLimitCfg_.qpsBurst = static_cast<std::size_t>(getIntField(L, "qpsBurst", ipLimitCfg_.qpsBurst));
         ipLimitCfg_.stateTtlSec = static_cast<std::uint64_t>(getIntField(L, "stateTtlSec", ipLimitCfg_.stateTtlSec));
 
         ipLimitCfg_.maxConnPerIp = Util::ClampWithWarning<std::size_t>("ipLimit.maxConnPerIp", ipLimitCfg_.maxConnPerIp, 0, 1'000'000, 200);
         ipLimitCfg_.maxQpsPerIp = Util::ClampWithWarning<std::size_t>("ipLimit.maxQpsPerIp", ipLimitCfg_.maxQpsPerIp, 0, 1'000'000, 0);
+        ipLimitCfg_.qpsBurst = Util::ClampWithWarning<std::size_t>("ipLimit.qpsBurst", ipLimitCfg_.qpsBurst, 0, 1'000'000, 0);
         ipLimitCfg_.stateTtlSec = Util::ClampWithWarning<std::uint64_t>("ipLimit.stateTtlSec", ipLimitCfg_.stateTtlSec, 0, 86400, 300);
         parseStringSet(L, "whitelist", ipLimitCfg_.whitelist);
+        parseStringSet(L, "allow", ipLimitCfg_.allow);
+        parseStringSet(L, "deny", ipLimitCfg_.deny);
     }
     lua_pop(L, 1);  // pop ipLimit
 
+    // ==== analytics ====
+    lua_getfield(L, -1, "analytics");
+    if (lua_istable(L, -1)) {
+        analyticsCfg_.enabled = getBoolField(L, "enabled", analyticsCfg_.enabled);
+        analyticsCfg_.topK = static_cast<std::size_t>(getIntField(L, "topK", analyticsCfg_.topK));
+        analyticsCfg_.capacity = static_cast<std::size_t>(getIntField(L, "capacity", analyticsCfg_.capacity));
+        analyticsCfg_.hllPrecision = static_cast<std::uint32_t>(getIntField(L, "hllPrecision", analyticsCfg_.hllPrecision));
+
+        analyticsCfg_.capacity = Util::ClampWithWarning<std::size_t>("analytics.capacity", analyticsCfg_.capacity, 8, 65536, 256);
+        analyticsCfg_.topK = Util::ClampWithWarning<std::size_t>("analytics.topK", analyticsCfg_.topK, 1, analyticsCfg_.capacity,
+                                                                     std::min<std::size_t>(20, analyticsCfg_.capacity));
+        analyticsCfg_.hllPrecision = Util::ClampWithWarning<std::uint32_t>("analytics.hllPrecision", analyticsCfg_.hllPrecision, 4, 16, 12);
+    }
+    lua_pop(L, 1);  // pop analytics
+
     // ==== errorFrames ====
     lua_getfield(L, -1, "errorFrames");
     if (lua_istable(L, -1)) {
@@ -299,6 +428,7 @@ bool Config::parseLuaConfig(void* pL) {
         parseMsg("ipQpsLimitMsgType", "ipQpsLimitBody", errorFrames_.ipQpsLimitMsgType, errorFrames_.ipQpsLimitBody);
         parseMsg("inflightLimitMsgType", "inflightLimitBody", errorFrames_.inflightLimitMsgType, errorFrames_.inflightLimitBody);
         parseMsg("msgRateLimitMsgType", "msgRateLimitBody", errorFrames_.msgRateLimitMsgType, errorFrames_.msgRateLimitBody);
+        parseMsg("frameTooLargeMsgType", "frameTooLargeBody", errorFrames_.frameTooLargeMsgType, errorFrames_.frameTooLargeBody);
         parseMsg("backpressureMsgType", "backpressureBody", errorFrames_.backpressureMsgType, errorFrames_.backpressureBody);
     }
     lua_pop(L, 1);  // pop errorFrames
@@ -328,12 +458,20 @@ bool Config::parseLuaConfig(void* pL) {
             msgLimitsCfg.maxQps = static_cast<int>(getIntField(L, "maxQps", msgLimitsCfg.maxQps));
             msgLimitsCfg.maxConcurrent = static_cast<int>(getIntField(L, "maxConcurrent", msgLimitsCfg.maxConcurrent));
             msgLimitsCfg.burst = static_cast<int>(getIntField(L, "burst", msgLimitsCfg.burst));
+            msgLimitsCfg.maxQueue = static_cast<int>(getIntField(L, "maxQueue", msgLimitsCfg.maxQueue));
+            msgLimitsCfg.queueTimeoutMs = static_cast<int>(getIntField(L, "queueTimeoutMs", msgLimitsCfg.queueTimeoutMs));
 
             if (msgType >= 0 && msgType <= 0xFFFF) {
             // clamp 数值，避免误配
             if (msgLimitsCfg.maxQps < 0) msgLimitsCfg.maxQps = 0;
             if (msgLimitsCfg.burst < 0) msgLimitsCfg.burst = 0;
             if (msgLimitsCfg.maxConcurrent < 0) msgLimitsCfg.maxConcurrent = 0;
+            if (msgLimitsCfg.maxQueue < 0) msgLimitsCfg.maxQueue = 0;
+            if (msgLimitsCfg.queueTimeoutMs < 0) msgLimitsCfg.queueTimeoutMs = 0;
+            if (msgLimitsCfg.maxQueue > 0 && msgLimitsCfg.maxConcurrent == 0) {
+                std::cerr << "[Config] messageLimits[" << msgType << "].maxQueue requires maxConcurrent, queueing disabled\n";
+                msgLimitsCfg.maxQueue = 0;
+            }
             msgLimitsCfg_[static_cast<std::uint16_t>(msgType)] = msgLimitsCfg;
             }
 
@@ -344,6 +482,60 @@ bool Config::parseLuaConfig(void* pL) {
     }
     lua_pop(L, 1);  // pop message_limits
 
+    // ==== workerPools ====（key = 池名, value = table）
+    lua_getfield(L, -1, "workerPools");
+    if (lua_istable(L, -1)) {
+        lua_pushnil(L);
+        while (lua_next(L, -2) != 0) {
+            if (lua_type(L, -2) != LUA_TSTRING || !lua_istable(L, -1)) {
+                lua_pop(L, 1);
+                continue;
+            }
+            std::string name = lua_tostring(L, -2);
+            WorkerPoolConfig poolCfg;
+            poolCfg.threads = static_cast<std::size_t>(getIntField(L, "threads", poolCfg.threads));
+            poolCfg.maxQueueSize = static_cast<std::size_t>(getIntField(L, "maxQueueSize", poolCfg.maxQueueSize));
+            poolCfg.threads = Util::ClampWithWarning<std::size_t>("workerPools." + name + ".threads", poolCfg.threads, 1, 256, 2);
+            workerPoolsCfg_[name] = poolCfg;
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);  // pop workerPools
+
+    // ==== routes ====（key = msgType, value = { policy, pool, ordering }）
+    lua_getfield(L, -1, "routes");
+    if (lua_istable(L, -1)) {
+        lua_pushnil(L);
+        while (lua_next(L, -2) != 0) {
+            if (!lua_isinteger(L, -2) || !lua_istable(L, -1)) {
+                lua_pop(L, 1);
+                continue;
+            }
+            std::int64_t msgType = lua_tointeger(L, -2);
+            RouteConfig routeCfg;
+            routeCfg.policy = getStringField(L, "policy", routeCfg.policy);
+            routeCfg.pool = getStringField(L, "pool", routeCfg.pool);
+            routeCfg.ordering = getStringField(L, "ordering", routeCfg.ordering);
+            if (!routeCfg.policy.empty() && routeCfg.policy != "inline" && routeCfg.policy != "worker" && routeCfg.policy != "dedicated") {
+                std::cerr << "[Config] invalid routes[" << msgType << "].policy=" << routeCfg.policy << " (expect inline/worker/dedicated), fallback to worker\n";
+                routeCfg.policy = "worker";
+            }
+            if (routeCfg.policy == "dedicated" && workerPoolsCfg_.count(routeCfg.pool) == 0) {
+                std::cerr << "[Config] routes[" << msgType << "] uses unknown pool '" << routeCfg.pool << "', fallback to worker\n";
+                routeCfg.policy = "worker";
+            }
+            if (!routeCfg.ordering.empty() && routeCfg.ordering != "none" && routeCfg.ordering != "strict" && routeCfg.ordering != "inOrder") {
+                std::cerr << "[Config] invalid routes[" << msgType << "].ordering=" << routeCfg.ordering << " (expect none/strict/inOrder), ignored\n";
+                routeCfg.ordering.clear();
+            }
+            if (msgType >= 0 && msgType <= 0xFFFF) {
+                routesCfg_[static_cast<std::uint16_t>(msgType)] = routeCfg;
+            }
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);  // pop routes
+
     // 弹出 config
     lua_pop(L, 1);
 
@@ -0,0 +1,72 @@
+#include "FrameStream.h"
+
+FrameStream::FrameStream(const ConnectionPtr& conn, std::uint16_t msgType, std::uint64_t totalBytes, std::size_t windowBytes)
+    : conn_(conn), msgType_(msgType), totalBytes_(totalBytes), window_(windowBytes), signal_(conn->socket().get_executor()) {}
+
+FrameStream::~FrameStream() { releaseRead(); }
+
+boost::asio::awaitable<std::optional<FrameBody>> FrameStream::next() {
+    for (;;) {
+        if (!chunks_.empty()) {
+            FrameBody chunk = std::move(chunks_.front());
+            chunks_.pop_front();
+            buffered_ -= chunk.size();
+            consumed_ += chunk.size();
+            if (holding_ && buffered_ <= window_ / 2) {
+                releaseRead();
+            }
+            co_return chunk;
+        }
+        if (finished_ || aborted_) {
+            co_return std::nullopt;
+        }
+        // 重置为“永不过期”，由 push/finish/abort 的 cancel 唤醒
+        signal_.expires_at(std::chrono::steady_clock::time_point::max());
+        boost::system::error_code ec;
+        co_await signal_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    }
+}
+
+void FrameStream::push(FrameBody chunk) {
+    if (aborted_ || chunk.empty()) {
+        return;
+    }
+    buffered_ += chunk.size();
+    chunks_.push_back(std::move(chunk));
+    if (!holding_ && buffered_ >= window_) {
+        holdRead();
+    }
+    wake();
+}
+
+void FrameStream::finish() {
+    finished_ = true;
+    wake();
+}
+
+void FrameStream::abort() {
+    aborted_ = true;
+    chunks_.clear();
+    buffered_ = 0;
+    releaseRead();
+    wake();
+}
+
+void FrameStream::wake() { signal_.cancel(); }
+
+void FrameStream::holdRead() {
+    if (auto conn = conn_.lock()) {
+        conn->holdRead();
+        holding_ = true;
+    }
+}
+
+void FrameStream::releaseRead() {
+    if (!holding_) {
+        return;
+    }
+    holding_ = false;
+    if (auto conn = conn_.lock()) {
+        conn->releaseRead();
+    }
+}
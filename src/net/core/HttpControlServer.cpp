@@ -11,12 +11,16 @@
 #include <sstream>
 #include <cctype>
 
+#include "IpAcl.h"
 #include "Metrics.h"
+#include "TrafficAnalytics.h"
 HttpControlServer::HttpControlServer(unsigned short port, readyCallback readyCheck)
     : io_(), workGuard_(boost::asio::make_work_guard(io_)), acceptor_(io_, tcp::endpoint(tcp::v4(), port)), readyCheck_(std::move(readyCheck)) {}
 
 HttpControlServer::~HttpControlServer() { stop(); }
 
+void HttpControlServer::setAclReloadCallback(aclReloadCallback cb) { aclReload_ = std::move(cb); }
+
 void HttpControlServer::start() {
     bool expected = false;
     if (!running_.compare_exchange_strong(expected, true)) {
@@ -101,7 +105,11 @@ boost::asio::awaitable<void> HttpControlServer::handleSession(std::shared_ptr<tc
         request.resize(bytes);
         is.read(&request[0], bytes);
 
-        std::string response = handleRequest(request);
+        boost::system::error_code peerEc;
+        auto peer = sock->remote_endpoint(peerEc);
+        bool fromLoopback = !peerEc && peer.address().is_loopback();
+
+        std::string response = handleRequest(request, fromLoopback);
 
         ec = {};
         co_await boost::asio::async_write(*sock, boost::asio::buffer(response), redirect_error(use_awaitable, ec));
@@ -117,20 +125,50 @@ boost::asio::awaitable<void> HttpControlServer::handleSession(std::shared_ptr<tc
     sock->close(ignore);
 }
 
-std::string HttpControlServer::handleRequest(const std::string& request) {
+std::string HttpControlServer::handleRequest(const std::string& request, bool fromLoopback) {
     std::istringstream iss(request);
     std::string method;
     std::string path;
     std::string version;
     iss >> method >> path >> version;
 
+    if (path == "/acl/reload") {
+        if (method != "POST") {
+            return buildResponse(405, "Method Not Allowed", "Use POST /acl/reload\n");
+        }
+        if (!aclReload_) {
+            return buildResponse(404, "Not Found", "acl reload not enabled\n");
+        }
+        // 健康检查与指标对外开放；改动服务状态的 reload 没有鉴权，只接受本机发起
+        if (!fromLoopback) {
+            return buildResponse(403, "Forbidden", "acl reload is only allowed from localhost\n");
+        }
+        std::string message;
+        bool ok = aclReload_(message);
+        return ok ? buildResponse(200, "OK", message + "\n") : buildResponse(500, "Internal Server Error", message + "\n");
+    }
+
     if (method != "GET") {
         return buildResponse(405, "Method Not Allowed", "Only GET is supported\n");
     }
 
+    if (path == "/acl") {
+        std::ostringstream oss;
+        IpAcl::Instance().print(oss);
+        return buildResponse(200, "OK", oss.str());
+    }
+
+    if (path == "/traffic") {
+        std::ostringstream oss;
+        TrafficAnalytics::Instance().print(oss);
+        return buildResponse(200, "OK", oss.str());
+    }
+
     if (path == "/metrics") {
         std::ostringstream oss;
         MetricsRegistry::Instance().printPrometheus(oss);
+        IpAcl::Instance().printPrometheus(oss);
+        TrafficAnalytics::Instance().printPrometheus(oss);
         std::string body = oss.str();
         // 去掉前导空白，避免 scrape 报 invalid start token
         auto pos = body.find_first_not_of(" \r\n\t");
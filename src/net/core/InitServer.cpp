@@ -3,15 +3,20 @@
 #include <google/protobuf/empty.pb.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <boost/asio/awaitable.hpp>
 #include <csignal>
 #include <nlohmann/json.hpp>
+#include <optional>
 
 #include "Buffer.h"
+#include "IpAcl.h"
 #include "IpLimiter.h"
+#include "ReplySequencer.h"
 #include "Routes/CoreRoutes.h"
 #include "Routes/RouteRegistry.h"
 #include "TraceContext.h"
+#include "TrafficAnalytics.h"
 #include "middlewares/Middlewares.h"
 
 InitServer::InitServer(const Config& cfg) : cfg_(cfg) {
@@ -20,12 +25,23 @@ InitServer::InitServer(const Config& cfg) : cfg_(cfg) {
 
     workerPool_ = std::make_shared<ThreadPool>(tpc.workerThreadsCount, tpc.maxQueueSize, tpc.minThreads, tpc.maxThreads);
     workerPool_->setAutoTuneParams(tpc.highWatermark, tpc.lowWatermark, tpc.upThreshold, tpc.downThreshold);
+    workerPool_->setAutoTuneTarget(std::chrono::microseconds(tpc.queueWaitSloUs), std::chrono::milliseconds(tpc.autoTuneIntervalMs));
+    workerPool_->setIdleSpin(std::chrono::microseconds(tpc.idleSpinUs));
     if (tpc.autoTune) {
         workerPool_->enableAutoTune(true);
     }
 
-    // 更新 IP 限制配置
+    // 独立线程池（舱壁），供 dedicated 路由使用
+    for (const auto& [name, poolCfg] : cfg_.workerPools()) {
+        dedicatedPools_[name] = std::make_shared<ThreadPool>(poolCfg.threads, poolCfg.maxQueueSize);
+        dedicatedPools_[name]->setIdleSpin(std::chrono::microseconds(tpc.idleSpinUs));
+        SPDLOG_INFO("worker pool '{}' threads={} maxQueueSize={}", name, poolCfg.threads, poolCfg.maxQueueSize);
+    }
+
+    // 更新 IP 限制配置与 CIDR 访问控制
     IpLimiter::Instance().updateConfig(cfg_.ipLimit());
+    IpAcl::Instance().update(cfg_.ipLimit());
+    TrafficAnalytics::Instance().configure(cfg_.analytics());
 
     // 按顺序构建组件
     router_ = buildRouter(cfg_);
@@ -55,7 +71,10 @@ std::shared_ptr<MessageRouter> InitServer::buildRouter(const Config& cfg) {
 
     // 2. 注册所有路由（可根据项目拆模块）
     RouteRegistry routes;
-    CoreRoutes::Register(routes);
+    CoreRoutes::Register(routes, workerPool_);
+    for (const auto& [name, pool] : dedicatedPools_) {
+        router->addWorkerPool(name, pool);
+    }
     routes.applyTo(*router);
 
     // JSON 路由示例
@@ -73,6 +92,21 @@ std::shared_ptr<MessageRouter> InitServer::buildRouter(const Config& cfg) {
         co_return;
     });
 
+    // 执行策略与顺序语义：config.lua 的 routes 覆盖代码中的默认值，留空的字段沿用代码注册时的设置
+    for (const auto& [msgType, routeCfg] : cfg.routes()) {
+        if (routeCfg.policy == "inline") {
+            router->setRoutePolicy(msgType, RoutePolicy::Inline);
+        } else if (routeCfg.policy == "dedicated") {
+            router->setRoutePolicy(msgType, RoutePolicy::Dedicated, routeCfg.pool);
+        } else if (routeCfg.policy == "worker") {
+            router->setRoutePolicy(msgType, RoutePolicy::Worker);
+        }
+        if (!routeCfg.ordering.empty()) {
+            router->setRouteOrdering(msgType, ParseOrderingMode(routeCfg.ordering));
+        }
+        SPDLOG_INFO("route msgType={} policy={} pool={} ordering={}", msgType, routeCfg.policy, routeCfg.pool, routeCfg.ordering);
+    }
+
     // 3. 默认 handler
     router->setDefaultHandler([](const ConnectionPtr& /*conn*/, uint16_t msgType, const std::string& body) -> boost::asio::awaitable<void> {
         SPDLOG_WARN("Unknown msgType={} bodySize={}", msgType, body.size());
@@ -82,72 +116,308 @@ std::shared_ptr<MessageRouter> InitServer::buildRouter(const Config& cfg) {
     return router;
 }
 
-std::shared_ptr<LengthHeaderCodec> InitServer::buildCodec(const std::shared_ptr<MessageRouter>& router, const Config& cfg) {
-    auto workerPool = workerPool_;  // 拷贝一份 shared_ptr，用于 lambda 捕获
-
-    auto frameCb = [router, workerPool, cfg, this](const ConnectionPtr& conn, uint16_t msgType, const std::string& body) {
-        TraceContext::Guard guard(conn->traceId(), conn->sessionId());
-        // 先做 per-IP QPS 限流
-        auto ip = conn->remoteIp();
-        if (!ip.empty()) {
-            if (!IpLimiter::Instance().allowQps(ip)) {
-                MetricsRegistry::Instance().incIpRejectQps();
-                MetricsRegistry::Instance().setIpRejectQpsTrace(conn->traceId(), conn->sessionId());
-                MetricsRegistry::Instance().droppedFrames().inc();
-                if (cfg.backpressure().sendErrorFrame) {
-                    const auto& err = cfg.errorFrames();
-                    LengthHeaderCodec::send(conn, err.ipQpsLimitMsgType, err.ipQpsLimitBody);
-                }
-                SPDLOG_WARN("[IpLimit] QPS reject msgType={} ip={} trace={} sess={}", msgType, ip, conn->traceId(), conn->sessionId());
-                return;
+bool InitServer::admitFrame(const ConnectionPtr& conn, uint16_t msgType, const Config& cfg) {
+    // 先做 per-IP QPS 限流
+    if (const auto& ipKey = conn->remoteIpKey(); ipKey && !conn->ipTrusted()) {
+        if (!IpLimiter::Instance().allowQps(*ipKey)) {
+            MetricsRegistry::Instance().incIpRejectQps();
+            MetricsRegistry::Instance().setIpRejectQpsTrace(conn->traceId(), conn->sessionId());
+            MetricsRegistry::Instance().droppedFrames().inc();
+            if (cfg.backpressure().sendErrorFrame) {
+                const auto& err = cfg.errorFrames();
+                LengthHeaderCodec::send(conn, err.ipQpsLimitMsgType, err.ipQpsLimitBody);
             }
+            SPDLOG_WARN("[IpLimit] QPS reject msgType={} ip={} trace={} sess={}", msgType, conn->remoteIp(), conn->traceId(), conn->sessionId());
+            return false;
         }
+    }
 
-        MetricsRegistry::Instance().inflightFrames().inc();
+    MetricsRegistry::Instance().inflightFrames().inc();
+
+    // 全局 in-flight 限制：按“帧”维度
+    int cur = inflight_.fetch_add(1, std::memory_order_relaxed);
+    if (cur >= cfg.limits().maxInflight) {
+        inflight_.fetch_sub(1, std::memory_order_relaxed);
+        MetricsRegistry::Instance().inflightFrames().inc(-1);
+        MetricsRegistry::Instance().totalErrors().inc();
+        MetricsRegistry::Instance().setTotalErrorTrace(conn->traceId(), conn->sessionId());
+        MetricsRegistry::Instance().droppedFrames().inc();
+        MetricsRegistry::Instance().inflightRejects().inc();
+        MetricsRegistry::Instance().setInflightRejectTrace(conn->traceId(), conn->sessionId());
+        if (cfg.backpressure().sendErrorFrame) {
+            const auto& err = cfg.errorFrames();
+            LengthHeaderCodec::send(conn, err.inflightLimitMsgType, err.inflightLimitBody);
+        }
+        SPDLOG_ERROR("too many in-flight frames, drop msgType={} trace={} sess={}", msgType, conn->traceId(), conn->sessionId());
+        return false;
+    }
+    return true;
+}
 
-        // 全局 in-flight 限制：按“帧”维度
-        int cur = inflight_.fetch_add(1, std::memory_order_relaxed);
-        if (cur >= cfg.limits().maxInflight) {
-            inflight_.fetch_sub(1, std::memory_order_relaxed);
-            MetricsRegistry::Instance().inflightFrames().inc(-1);
-            MetricsRegistry::Instance().totalErrors().inc();
-            MetricsRegistry::Instance().setTotalErrorTrace(conn->traceId(), conn->sessionId());
-            MetricsRegistry::Instance().droppedFrames().inc();
-            MetricsRegistry::Instance().inflightRejects().inc();
-            MetricsRegistry::Instance().setInflightRejectTrace(conn->traceId(), conn->sessionId());
+void InitServer::releaseFrames(std::size_t n) {
+    MetricsRegistry::Instance().inflightFrames().inc(-static_cast<std::int64_t>(n));
+    inflight_.fetch_sub(static_cast<int>(n), std::memory_order_relaxed);
+}
+
+void InitServer::spawnFrame(boost::asio::any_io_executor exec, const ConnectionPtr& conn, RoutedFrame f, std::function<void()> onDone) {
+    // 有序帧经 ReplySlotExecutor 运行：回包槽随请求走，handler 挂起后在哪个线程恢复都写入自己的槽，结束后按请求顺序交给连接
+    try {
+        if (!f.ordering) {
+            router_->spawn(std::move(exec), conn, f.msgType, std::move(f.body), std::move(onDone));
+            return;
+        }
+        auto slot = std::make_shared<ReplySlot>(conn.get());
+        router_->spawn(ReplySlotExecutor(std::move(exec), slot), conn, f.msgType, std::move(f.body),
+                       [ordering = std::move(f.ordering), seq = f.seq, slot, onDone = std::move(onDone)]() {
+                           ordering->complete(seq, *slot);
+                           if (onDone) {
+                               onDone();
+                           }
+                       });
+    } catch (const std::exception& ex) {
+        SPDLOG_ERROR("router->spawn exception: {} trace={} sess={}", ex.what(), conn->traceId(), conn->sessionId());
+    }
+}
+
+void InitServer::abandonFrame(const RoutedFrame& f) {
+    if (f.ordering) {
+        ReplySlot empty(nullptr);
+        f.ordering->complete(f.seq, empty);
+    }
+}
+
+void InitServer::runFrames(const std::weak_ptr<AsioConnection>& conn, ThreadPool& pool, RoutedFrame* frames, std::size_t n) {
+    auto shared = conn.lock();
+    if (!shared) {
+        std::for_each(frames, frames + n, abandonFrame);
+        releaseFrames(n);
+        return;
+    }
+    // 每帧一个 handler 协程，以线程池为 executor（挂起时不占池线程），handler 结束时归还 in-flight 计数；
+    // 本任务已经在池线程上，协程就地启动跑到第一次挂起，整组帧只占一次入队（也只在入队时受 maxQueueSize 约束）
+    TraceContext::Guard g(shared->traceId(), shared->sessionId());
+    for (std::size_t i = 0; i < n; ++i) {
+        ThreadPool::InlineEntry entry(pool);
+        spawnFrame(pool.get_executor(), shared, std::move(frames[i]), [this]() { releaseFrames(1); });
+    }
+}
+
+void InitServer::dropFrames(RoutedFrame* frames, std::size_t n) noexcept {
+    std::for_each(frames, frames + n, abandonFrame);
+    releaseFrames(n);
+    MetricsRegistry::Instance().totalErrors().inc();
+}
+
+void InitServer::submitFrame(const std::shared_ptr<ThreadPool>& pool, const ConnectionPtr& conn, RoutedFrame f) {
+    try {
+        pool->post(FrameJob(*this, *pool, conn, std::move(f)));
+    } catch (const std::exception& ex) {
+        SPDLOG_ERROR("ThreadPool submit failed in FrameCallback: {} frames=1", ex.what());
+    }
+}
+
+void InitServer::submitFrames(const std::shared_ptr<ThreadPool>& pool, const ConnectionPtr& conn, std::vector<RoutedFrame> frames) {
+    if (frames.size() == 1) {
+        submitFrame(pool, conn, std::move(frames.front()));
+        return;
+    }
+    const std::size_t n = frames.size();
+    try {
+        pool->post(FrameBatchJob(*this, *pool, conn, std::move(frames)));
+    } catch (const std::exception& ex) {
+        SPDLOG_ERROR("ThreadPool submit failed in FrameCallback: {} frames={}", ex.what(), n);
+    }
+}
+
+std::shared_ptr<LengthHeaderCodec> InitServer::buildCodec(const std::shared_ptr<MessageRouter>& router, const Config& cfg) {
+    auto workerPool = workerPool_;  // 拷贝一份 shared_ptr，用于 lambda 捕获
+
+    const OrderingMode defaultOrdering = ParseOrderingMode(cfg.server().ordering);
+
+    // 超长帧回错误帧；流式路由按帧做准入，handler 结束时归还 in-flight
+    auto configureLimits = [router, cfg, this](LengthHeaderCodec& codec) {
+        codec.setMaxFrameBytes(cfg.server().maxFrameBytes, [cfg](const ConnectionPtr& conn, uint16_t msgType, uint32_t len) {
             if (cfg.backpressure().sendErrorFrame) {
                 const auto& err = cfg.errorFrames();
-                LengthHeaderCodec::send(conn, err.inflightLimitMsgType, err.inflightLimitBody);
+                LengthHeaderCodec::send(conn, err.frameTooLargeMsgType, err.frameTooLargeBody);
             }
-            SPDLOG_ERROR("too many in-flight frames, drop msgType={} trace={} sess={}", msgType, conn->traceId(), conn->sessionId());
-            return;
+            SPDLOG_WARN("frame too large, drop msgType={} len={} trace={} sess={}", msgType, len, conn->traceId(), conn->sessionId());
+        });
+        const std::size_t window = cfg.server().streamWindowBytes;
+        codec.setStreamOpener([router, cfg, window, this](const ConnectionPtr& conn, uint16_t msgType, uint32_t bodyLen, FrameStreamPtr& out) {
+            if (!router->isStreamRoute(msgType)) {
+                return false;
+            }
+            TraceContext::Guard guard(conn->traceId(), conn->sessionId());
+            if (admitFrame(conn, msgType, cfg)) {
+                out = router->openStream(conn, msgType, bodyLen, window, [this] { releaseFrames(1); });
+            }
+            return true;
+        });
+    };
+
+    // I/O 线程上按到达顺序做准入，并确定该帧的顺序语义：路由指定的优先，否则用连接当前的模式。
+    // 有序帧在这里占回包序号，准入被拒时的错误帧也经回包槽按序号发出。返回 false 表示帧被拒绝
+    auto admit = [router, defaultOrdering, cfg, this](const ConnectionPtr& conn, RoutedFrame& f) {
+        auto& ordering = conn->orderingState();
+        if (!ordering) {
+            ordering = std::make_shared<ConnectionOrdering>(conn, defaultOrdering);
+        }
+        OrderingMode mode = router->withRoute(f.msgType, [](const HandlerEntry& e) { return e.ordering; });
+        if (mode == OrderingMode::Default) {
+            mode = ordering->mode();
+        }
+        if (mode != OrderingMode::Strict && mode != OrderingMode::InOrder) {
+            return admitFrame(conn, f.msgType, cfg);
         }
 
-        auto weak = std::weak_ptr<AsioConnection>(conn);
-        try {
-            workerPool->submit([router, weak, msgType, body, this]() {
-                if (auto shared = weak.lock()) {
+        f.ordering = ordering;
+        f.seq = ordering->reserve();
+        f.strict = mode == OrderingMode::Strict;
+        ReplySlot slot(conn.get());
+        bool admitted = false;
+        {
+            ReplySlot::Scope scope(slot);
+            admitted = admitFrame(conn, f.msgType, cfg);
+        }
+        if (!admitted) {
+            ordering->complete(f.seq, slot);
+        }
+        return admitted;
+    };
+
+    // Inline 路由以协程在连接 I/O strand 上执行，交给连接 executor 即归还 in-flight（线程池路由在 handler 结束时归还）；
+    // 有序的 Inline 帧同样异步执行，回包经请求自己的回包槽按序发出；Strict 帧排进连接的串行队列，上一个 handler 结束才开始下一个。
+    // 其余路由返回目标线程池：Dedicated 用其独立池，Worker 用共享池
+    auto inlineOrPool = [router, workerPool, this](const ConnectionPtr& conn, const RoutedFrame& f) -> std::shared_ptr<ThreadPool> {
+        std::shared_ptr<ThreadPool> pool = router->withRoute(f.msgType, [&workerPool](const HandlerEntry& e) -> std::shared_ptr<ThreadPool> {
+            if (e.policy == RoutePolicy::Inline) {
+                return nullptr;
+            }
+            return e.pool ? e.pool : workerPool;
+        });
+
+        if (f.strict) {
+            auto weak = std::weak_ptr<AsioConnection>(conn);
+            auto run = [weak, f, pool, this]() {
+                auto shared = weak.lock();
+                if (!shared) {
+                    abandonFrame(f);
+                    releaseFrames(1);
+                    f.ordering->strictDone();
+                } else if (!pool) {
+                    spawnFrame(shared->socket().get_executor(), shared, f, [ordering = f.ordering]() { ordering->strictDone(); });
+                    releaseFrames(1);
+                } else {
                     TraceContext::Guard g(shared->traceId(), shared->sessionId());
-                    try {
-                        router->onMessage(shared, msgType, body);
-                    } catch (const std::exception& ex) {
-                        SPDLOG_ERROR("router->onMessage exception: {} trace={} sess={}", ex.what(), shared->traceId(), shared->sessionId());
-                    } catch (...) {
-                        SPDLOG_ERROR("router->onMessage unknown exception trace={} sess={}", shared->traceId(), shared->sessionId());
-                    }
+                    ThreadPool::InlineEntry entry(*pool);
+                    spawnFrame(pool->get_executor(), shared, f, [ordering = f.ordering, this]() {
+                        releaseFrames(1);
+                        ordering->strictDone();
+                    });
                 }
-                MetricsRegistry::Instance().inflightFrames().inc(-1);
-                inflight_.fetch_sub(1, std::memory_order_relaxed);
-            });
-        } catch (const std::exception& ex) {
-            inflight_.fetch_sub(1, std::memory_order_relaxed);
-            MetricsRegistry::Instance().inflightFrames().inc(-1);
-            MetricsRegistry::Instance().totalErrors().inc();
-            SPDLOG_ERROR("ThreadPool submit failed in FrameCallback: {}", ex.what());
+            };
+            auto drop = [f, this]() {
+                abandonFrame(f);
+                releaseFrames(1);
+                MetricsRegistry::Instance().totalErrors().inc();
+            };
+            f.ordering->runStrict(std::move(pool), std::move(run), std::move(drop));
+            return nullptr;
         }
+
+        if (!pool) {
+            if (f.ordering) {
+                spawnFrame(conn->socket().get_executor(), conn, f, {});
+            } else {
+                try {
+                    router->onMessage(conn, f.msgType, f.body);
+                } catch (const std::exception& ex) {
+                    SPDLOG_ERROR("router->onMessage exception: {} trace={} sess={}", ex.what(), conn->traceId(), conn->sessionId());
+                }
+            }
+            releaseFrames(1);
+        }
+        return pool;
     };
 
-    auto codec = std::make_shared<LengthHeaderCodec>(frameCb);
+    const std::size_t batchSize = cfg.threadPool().frameBatchSize;
+    if (batchSize == 1) {
+        // 逐帧投递：帧直接放进任务（FrameJob），不经过 vector
+        auto frameCb = [admit, inlineOrPool, this](const ConnectionPtr& conn, uint16_t msgType, const FrameBody& body) {
+            TraceContext::Guard guard(conn->traceId(), conn->sessionId());
+            RoutedFrame f{.body = body, .ordering = nullptr, .seq = 0, .msgType = msgType, .strict = false};
+            if (!admit(conn, f)) {
+                return;
+            }
+            if (auto pool = inlineOrPool(conn, f)) {
+                submitFrame(pool, conn, std::move(f));
+            }
+        };
+        auto codec = std::make_shared<LengthHeaderCodec>(LengthHeaderCodec::FrameCallback(frameCb));
+        configureLimits(*codec);
+        return codec;
+    }
+
+    // 批量投递：一次读取解出的帧逐帧做准入检查，Inline 帧就地执行，其余按目标线程池分组、按 batchSize 切块，每块一个任务。
+    // 每组的第一帧单独存放，凑出第二帧才启用 vector：只有一帧的块照样走 FrameJob，不为它分配
+    struct PendingFrames {
+        std::shared_ptr<ThreadPool> pool;
+        std::optional<RoutedFrame> single;
+        std::vector<RoutedFrame> batch;
+
+        std::size_t size() const { return single ? 1 : batch.size(); }
+    };
+    auto batchCb = [admit, inlineOrPool, batchSize, this](const ConnectionPtr& conn, std::vector<DecodedFrame>& frames) {
+        TraceContext::Guard guard(conn->traceId(), conn->sessionId());
+        const std::size_t limit = batchSize == 0 ? frames.size() : batchSize;
+
+        auto flush = [&conn, this](PendingFrames& g) {
+            if (g.single) {
+                submitFrame(g.pool, conn, std::move(*g.single));
+                g.single.reset();
+            } else if (!g.batch.empty()) {
+                submitFrames(g.pool, conn, std::move(g.batch));
+                g.batch.clear();
+            }
+        };
+
+        // 一次读取涉及的线程池通常只有一两个，线性查找即可
+        std::vector<PendingFrames> groups;
+        for (auto& frame : frames) {
+            RoutedFrame f{.body = std::move(frame.body), .ordering = nullptr, .seq = 0, .msgType = frame.msgType, .strict = false};
+            if (!admit(conn, f)) {
+                continue;
+            }
+            auto pool = inlineOrPool(conn, f);
+            if (!pool) {
+                continue;
+            }
+            auto it = std::find_if(groups.begin(), groups.end(), [&pool](const auto& g) { return g.pool == pool; });
+            if (it == groups.end()) {
+                groups.push_back(PendingFrames{.pool = std::move(pool), .single = std::nullopt, .batch = {}});
+                it = std::prev(groups.end());
+            }
+            if (it->size() == 0) {
+                it->single.emplace(std::move(f));
+            } else {
+                if (it->single) {
+                    it->batch.reserve(std::min(limit, frames.size()));
+                    it->batch.push_back(std::move(*it->single));
+                    it->single.reset();
+                }
+                it->batch.push_back(std::move(f));
+            }
+            if (it->size() >= limit) {
+                flush(*it);
+            }
+        }
+        for (auto& g : groups) {
+            flush(g);
+        }
+    };
+    auto codec = std::make_shared<LengthHeaderCodec>(LengthHeaderCodec::FrameBatchCallback(batchCb));
+    configureLimits(*codec);
     return codec;
 }
 
@@ -170,6 +440,19 @@ std::shared_ptr<HttpControlServer> InitServer::buildHttpControlServer(const Conf
     auto readyCheck = [srv = server_]() -> bool { return srv && srv->isAccepting(); };
 
     auto httpServer = std::make_shared<HttpControlServer>(httpPort, readyCheck);
+    // POST /acl/reload：重新读取配置文件的 ipLimit 段，刷新 CIDR 规则与每 IP 限流阈值
+    httpServer->setAclReloadCallback([path = cfg.sourcePath()](std::string& message) -> bool {
+        IpLimitConfig ipCfg;
+        if (path.empty() || !Config::ReadIpLimit(path, ipCfg)) {
+            message = "failed to load config '" + path + "'";
+            return false;
+        }
+        IpLimiter::Instance().updateConfig(ipCfg);
+        IpAcl::Instance().update(ipCfg);
+        message = "reloaded " + std::to_string(IpAcl::Instance().ruleCount()) + " acl rules from " + path;
+        SPDLOG_INFO("[IpAcl] {}", message);
+        return true;
+    });
     httpServer->start();
 
     return httpServer;
@@ -2,16 +2,64 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <exception>
+#include <utility>
 #include <boost/asio/detached.hpp>
 
+#include "MiddlewarePipeline.h"
 #include "TraceContext.h"
 
+namespace {
+    // MessageRouter::spawn 的完成回调：协程结束时记录异常并调用 onDone；
+    // 协程没跑完就随 executor 一起被销毁时，由析构补调 onDone，顺序控制与 in-flight 计数不会被永久占住
+    class SpawnDone {
+      public:
+        SpawnDone(std::uint16_t msgType, std::function<void()> onDone) : msgType_(msgType), onDone_(std::move(onDone)) {}
+        SpawnDone(SpawnDone&& other) noexcept : msgType_(other.msgType_), onDone_(std::move(other.onDone_)), armed_(std::exchange(other.armed_, false)) {}
+        SpawnDone(const SpawnDone&) = delete;
+
+        ~SpawnDone() {
+            if (armed_ && onDone_) {
+                onDone_();
+            }
+        }
+
+        void operator()(std::exception_ptr ep) {
+            armed_ = false;
+            if (ep) {
+                try {
+                    std::rethrow_exception(ep);
+                } catch (const std::exception& ex) {
+                    SPDLOG_ERROR("MessageRouter::spawn exception: {} msgType={}", ex.what(), msgType_);
+                } catch (...) {
+                    SPDLOG_ERROR("MessageRouter::spawn unknown exception msgType={}", msgType_);
+                }
+            }
+            if (onDone_) {
+                onDone_();
+            }
+        }
+
+      private:
+        std::uint16_t msgType_;
+        std::function<void()> onDone_;
+        bool armed_{true};
+    };
+}  // namespace
+
+MessageRouter::MessageRouter() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    publishLocked();
+}
+
 void MessageRouter::registerHandler(std::uint16_t msgType, CoMessageHandler handler) {
     std::lock_guard<std::mutex> lock(mtx_);
     HandlerEntry entry;
     entry.fmt = PayloadFormat::Raw;
     entry.rawHandler = std::move(handler);
     handlers_[msgType] = std::move(entry);
+    publishLocked();
 }
 
 void MessageRouter::registerJson(std::uint16_t msgType, std::function<boost::asio::awaitable<void>(const ConnectionPtr&, const nlohmann::json&)> handler) {
@@ -20,11 +68,61 @@ void MessageRouter::registerJson(std::uint16_t msgType, std::function<boost::asi
     entry.fmt = PayloadFormat::Json;
     entry.jsonHandler = std::move(handler);
     handlers_[msgType] = std::move(entry);
+    publishLocked();
 }
 
-void MessageRouter::setDefaultHandler(std::function<boost::asio::awaitable<void>(const ConnectionPtr&, std::uint16_t, const std::string&)> handler) {
+void MessageRouter::registerStream(std::uint16_t msgType, CoStreamHandler handler) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    HandlerEntry entry;
+    entry.fmt = PayloadFormat::Stream;
+    entry.streamHandler = std::move(handler);
+    handlers_[msgType] = std::move(entry);
+    publishLocked();
+}
+
+bool MessageRouter::isStreamRoute(std::uint16_t msgType) const {
+    return withRoute(msgType, [](const HandlerEntry& entry) { return entry.fmt == PayloadFormat::Stream; });
+}
+
+FrameStreamPtr MessageRouter::openStream(const ConnectionPtr& conn, std::uint16_t msgType, std::uint64_t bodyLen, std::size_t windowBytes, std::function<void()> onDone) {
+    CoStreamHandler handler = withRoute(msgType, [](const HandlerEntry& entry) {
+        return entry.fmt == PayloadFormat::Stream ? entry.streamHandler : CoStreamHandler{};
+    });
+    if (!handler) {
+        if (onDone) {
+            onDone();
+        }
+        return nullptr;
+    }
+
+    auto stream = std::make_shared<FrameStream>(conn, msgType, bodyLen, windowBytes);
+    auto traceId = conn->traceId();
+    auto sessionId = conn->sessionId();
+    auto run = [handler = std::move(handler), conn, stream, traceId, sessionId]() -> boost::asio::awaitable<void> {
+        TraceContext::Guard guard(traceId, sessionId);
+        co_await handler(conn, stream);
+    };
+    boost::asio::co_spawn(conn->socket().get_executor(), run, [msgType, traceId, sessionId, onDone = std::move(onDone)](std::exception_ptr ep) {
+        if (ep) {
+            try {
+                std::rethrow_exception(ep);
+            } catch (const std::exception& ex) {
+                SPDLOG_ERROR("stream handler exception: {} msgType={} trace={} sess={}", ex.what(), msgType, traceId, sessionId);
+            } catch (...) {
+                SPDLOG_ERROR("stream handler unknown exception msgType={} trace={} sess={}", msgType, traceId, sessionId);
+            }
+        }
+        if (onDone) {
+            onDone();
+        }
+    });
+    return stream;
+}
+
+void MessageRouter::setDefaultHandler(CoDefaultHandler handler) {
     std::lock_guard<std::mutex> lock(mtx_);
     defaultHandler_ = std::move(handler);
+    publishLocked();
 }
 
 void MessageRouter::use(CoMiddleware mw) {
@@ -32,20 +130,73 @@ void MessageRouter::use(CoMiddleware mw) {
     middlewares_.push_back(std::move(mw));
 }
 
-void MessageRouter::onMessage(const ConnectionPtr& conn, std::uint16_t msgType, const std::string& body) {
-    auto ctx = std::make_shared<MessageContext>();
-    ctx->conn = conn;
-    ctx->msgType = msgType;
-    ctx->body = std::make_shared<std::string>(body);
-    ctx->traceId = conn ? conn->traceId() : "";
+void MessageRouter::onMessage(const ConnectionPtr& conn, std::uint16_t msgType, const std::string& body) { onMessage(conn, msgType, FrameBody::copyOf(body)); }
+
+void MessageRouter::setRoutePolicy(std::uint16_t msgType, RoutePolicy policy, std::string pool) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    policies_[msgType] = {policy, std::move(pool)};
+    publishLocked();
+}
+
+void MessageRouter::setRouteOrdering(std::uint16_t msgType, OrderingMode mode) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    orderings_[msgType] = mode;
+    publishLocked();
+}
+
+void MessageRouter::addWorkerPool(const std::string& name, std::shared_ptr<ThreadPool> pool) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    pools_[name] = std::move(pool);
+    publishLocked();
+}
+
+void MessageRouter::usePipeline(std::shared_ptr<const MiddlewarePipeline> pipeline) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    pipeline_ = std::move(pipeline);
+}
+
+void MessageRouter::onMessage(const ConnectionPtr& conn, std::uint16_t msgType, FrameBody body) {
+    MessageContext ctx;
+    ctx.conn = conn;
+    ctx.msgType = msgType;
+    ctx.body = std::move(body);
+    ctx.traceId = conn ? conn->traceId() : "";
 
     try {
         auto exec = conn->socket().get_executor();
-        boost::asio::co_spawn(exec, dispatch(0, ctx), boost::asio::detached);
+        boost::asio::co_spawn(exec, process(std::move(ctx)), boost::asio::detached);
     } catch (const std::exception& ex) {
-        SPDLOG_ERROR("MessageRouter::onMessage exception: {} trace={} sess={}", ex.what(), ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
+        SPDLOG_ERROR("MessageRouter::onMessage exception: {} msgType={} sess={}", ex.what(), msgType, conn ? conn->sessionId() : "nil");
     } catch (...) {
-        SPDLOG_ERROR("MessageRouter::onMessage unknown exception trace={} sess={}", ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
+        SPDLOG_ERROR("MessageRouter::onMessage unknown exception msgType={} sess={}", msgType, conn ? conn->sessionId() : "nil");
+    }
+}
+
+void MessageRouter::spawn(boost::asio::any_io_executor exec, const ConnectionPtr& conn, std::uint16_t msgType, FrameBody body, std::function<void()> onDone) {
+    MessageContext ctx;
+    ctx.conn = conn;
+    ctx.msgType = msgType;
+    ctx.body = std::move(body);
+    ctx.traceId = conn ? conn->traceId() : "";
+
+    boost::asio::co_spawn(std::move(exec), process(std::move(ctx)), SpawnDone(msgType, std::move(onDone)));
+}
+
+boost::asio::awaitable<void> MessageRouter::process(MessageContext ctx) {
+    TraceContext::Guard guard(ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "");
+    if (pipeline_) {
+        co_await pipeline_->run(*this, ctx);
+    } else {
+        co_await runHandler(ctx);
+    }
+}
+
+boost::asio::awaitable<void> MessageRouter::runHandler(MessageContext& ctx) {
+    if (middlewares_.empty()) {
+        co_await invokeHandler(ctx);
+    } else {
+        // 动态中间件按 shared_ptr 传递上下文；拷贝一份，管线的 leave 仍可读取原 ctx
+        co_await dispatch(0, std::make_shared<MessageContext>(ctx));
     }
 }
 
@@ -63,55 +214,100 @@ boost::asio::awaitable<void> MessageRouter::dispatch(std::size_t idx, std::share
         }
         co_return;
     }
+    co_await invokeHandler(*ctx);
+}
 
-    auto handler = getHandler(ctx->msgType);
+boost::asio::awaitable<void> MessageRouter::invokeHandler(MessageContext& ctx) {
+    // 持有 entry 的引用计数：handler 执行期间路由表被替换，旧 entry 也要活到协程结束
+    const auto entry = getHandler(ctx.msgType);
+    const HandlerEntry& handler = *entry;
     switch (handler.fmt) {
         case PayloadFormat::Raw:
             if (handler.rawHandler) {
-                co_await handler.rawHandler(ctx->conn, *ctx->body);
+                co_await handler.rawHandler(ctx.conn, ctx.body.view());
             }
             break;
         case PayloadFormat::Json:
             if (handler.jsonHandler) {
                 try {
-                    auto json = nlohmann::json::parse(*ctx->body);
-                    co_await handler.jsonHandler(ctx->conn, json);
+                    auto json = nlohmann::json::parse(ctx.body.data(), ctx.body.data() + ctx.body.size());
+                    co_await handler.jsonHandler(ctx.conn, json);
                 } catch (const std::exception& ex) {
-                    SPDLOG_WARN("Json parse failed for msgType={}, err={} trace={} sess={}", ctx->msgType, ex.what(), ctx->traceId,
-                                ctx->conn ? ctx->conn->sessionId() : "nil");
+                    SPDLOG_WARN("Json parse failed for msgType={}, err={} trace={} sess={}", ctx.msgType, ex.what(), ctx.traceId,
+                                ctx.conn ? ctx.conn->sessionId() : "nil");
                 }
             }
             break;
         case PayloadFormat::Proto:
             if (handler.protoHandler && handler.protoFactory) {
                 auto msg = handler.protoFactory();
-                if (msg && msg->ParseFromString(*ctx->body)) {
-                    co_await handler.protoHandler(ctx->conn, *msg);
+                if (msg && msg->ParseFromArray(ctx.body.data(), static_cast<int>(ctx.body.size()))) {
+                    co_await handler.protoHandler(ctx.conn, *msg);
                 } else {
-                SPDLOG_WARN("Proto parse failed for msgType={} trace={} sess={}", ctx->msgType, ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
+                SPDLOG_WARN("Proto parse failed for msgType={} trace={} sess={}", ctx.msgType, ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "nil");
                 }
             }
             break;
+        case PayloadFormat::Fallback:
+            if (handler.defaultHandler) {
+                co_await handler.defaultHandler(ctx.conn, ctx.msgType, ctx.body.str());
+            }
+            break;
         default:
-    SPDLOG_WARN("No handler for msgType={} trace={} sess={}", ctx->msgType, ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
+    SPDLOG_WARN("No handler for msgType={} trace={} sess={}", ctx.msgType, ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "nil");
             break;
     }
     co_return;
 }
 
-HandlerEntry MessageRouter::getHandler(std::uint16_t msgType) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = handlers_.find(msgType);
-    if (it != handlers_.end()) {
-        return it->second;
+std::shared_ptr<const HandlerEntry> MessageRouter::getHandler(std::uint16_t msgType) const {
+    EpochDomain::ReadGuard guard(epoch_);
+    return table_.load(std::memory_order_acquire)->find(msgType);
+}
+
+void MessageRouter::publishLocked() {
+    auto table = std::make_unique<RouteTable>();
+
+    std::uint16_t maxType = 0;
+    for (const auto& [msgType, entry] : handlers_) {
+        maxType = std::max(maxType, msgType);
+    }
+    if (!handlers_.empty()) {
+        table->slots.assign(static_cast<std::size_t>(maxType) + 1, 0);
+        table->entries.reserve(handlers_.size());
+        for (const auto& [msgType, entry] : handlers_) {
+            auto compiled = std::make_shared<HandlerEntry>(entry);
+            auto it = policies_.find(msgType);
+            if (it != policies_.end()) {
+                compiled->policy = it->second.first;
+                if (compiled->policy == RoutePolicy::Dedicated) {
+                    auto poolIt = pools_.find(it->second.second);
+                    if (poolIt != pools_.end()) {
+                        compiled->pool = poolIt->second;
+                    } else {
+                        // 池尚未注册（或名字写错）：先退回共享线程池
+                        compiled->policy = RoutePolicy::Worker;
+                    }
+                }
+            }
+            if (auto ordIt = orderings_.find(msgType); ordIt != orderings_.end()) {
+                compiled->ordering = ordIt->second;
+            }
+            table->entries.push_back(std::move(compiled));
+            table->slots[msgType] = static_cast<std::uint32_t>(table->entries.size());
+        }
     }
 
-    // 没有注册：返回一个 wrapper 调 defaultHandler_（如果有）
-    HandlerEntry entry;
+    // 兜底 entry 只在这里构建一次，不再每条未知消息分配一个包装 lambda
+    auto fallback = std::make_shared<HandlerEntry>();
     if (defaultHandler_) {
-        entry.fmt = PayloadFormat::Raw;
-        auto def = defaultHandler_;
-        entry.rawHandler = [def, msgType](const ConnectionPtr& conn, std::string_view body) -> boost::asio::awaitable<void> { co_await def(conn, msgType, std::string(body)); };
+        fallback->fmt = PayloadFormat::Fallback;
+        fallback->defaultHandler = defaultHandler_;
     }
-    return entry;
+    table->fallback = std::move(fallback);
+
+    // 先发布新表，再等发布前开始的查表都结束，旧表随之释放（执行中的 handler 各自持有 entry 引用）
+    table_.store(table.get(), std::memory_order_seq_cst);
+    epoch_.synchronize();
+    current_ = std::move(table);
 }
@@ -0,0 +1,148 @@
+#include "ReplySequencer.h"
+
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+    thread_local ReplySlot* tlReplySlot = nullptr;
+    thread_local ConnectionOrdering* tlStrictSubmitting = nullptr;  // 正在投递 Strict 任务的连接（见 StrictPoolJob）
+
+    // 投递到线程池的 Strict 请求：没执行就被销毁（过载丢弃、线程池停止）时调用 drop 并放行下一个，
+    // 连接的串行队列不会因为任务丢失而卡住。投递当场失败时由 runNextStrict 的循环继续，不在这里递归
+    class StrictPoolJob {
+      public:
+        StrictPoolJob(std::shared_ptr<ConnectionOrdering> ordering, std::function<void()> run, std::function<void()> drop)
+            : ordering_(std::move(ordering)), run_(std::move(run)), drop_(std::move(drop)) {}
+        StrictPoolJob(StrictPoolJob&& other) noexcept
+            : ordering_(std::move(other.ordering_)), run_(std::move(other.run_)), drop_(std::move(other.drop_)) {}
+        StrictPoolJob(const StrictPoolJob&) = delete;
+
+        ~StrictPoolJob() {
+            if (!ordering_) {
+                return;
+            }
+            if (drop_) {
+                drop_();
+            }
+            if (tlStrictSubmitting != ordering_.get()) {
+                ordering_->strictDone();
+            }
+        }
+
+        void operator()() {
+            ordering_.reset();  // 已执行：请求结束时由 run 调用 strictDone
+            run_();
+        }
+
+      private:
+        std::shared_ptr<ConnectionOrdering> ordering_;  // 执行或移走后为空，兼作“尚未执行”标记
+        std::function<void()> run_;
+        std::function<void()> drop_;
+    };
+}
+
+OrderingMode ParseOrderingMode(const std::string& name) {
+    if (name == "none") {
+        return OrderingMode::None;
+    }
+    if (name == "strict") {
+        return OrderingMode::Strict;
+    }
+    if (name == "inOrder") {
+        return OrderingMode::InOrder;
+    }
+    return OrderingMode::Default;
+}
+
+void ReplySlot::append(const void* data, std::size_t len) {
+    if (!buf_) {
+        buf_ = BufferPool::Instance().acquire(len);
+    }
+    buf_->append(data, len);
+}
+
+ReplySlot* ReplySlot::current() { return tlReplySlot; }
+
+ReplySlot::Scope::Scope(ReplySlot& slot) : prev_(tlReplySlot) { tlReplySlot = &slot; }
+
+ReplySlot::Scope::~Scope() { tlReplySlot = prev_; }
+
+ConnectionOrdering::ConnectionOrdering(const ConnectionPtr& conn, OrderingMode mode) : conn_(conn), mode_(mode) {}
+
+OrderingMode ConnectionOrdering::mode() const { return mode_.load(std::memory_order_relaxed); }
+
+void ConnectionOrdering::setMode(OrderingMode mode) { mode_.store(mode, std::memory_order_relaxed); }
+
+std::uint64_t ConnectionOrdering::reserve() {
+    std::lock_guard<std::mutex> lock(replyMtx_);
+    return nextSeq_++;
+}
+
+void ConnectionOrdering::complete(std::uint64_t seq, ReplySlot& slot) {
+    auto buf = slot.take();
+    auto conn = conn_.lock();
+
+    // 发送也在锁内：多个线程依次 complete 时，交给连接发送队列的顺序即序号顺序
+    std::lock_guard<std::mutex> lock(replyMtx_);
+    if (seq != nextSend_) {
+        held_.emplace(seq, std::move(buf));
+        return;
+    }
+    if (conn && buf) {
+        conn->sendBuffer(buf);
+    }
+    ++nextSend_;
+
+    for (auto it = held_.begin(); it != held_.end() && it->first == nextSend_; it = held_.erase(it)) {
+        if (conn && it->second) {
+            conn->sendBuffer(it->second);
+        }
+        ++nextSend_;
+    }
+}
+
+void ConnectionOrdering::runStrict(std::shared_ptr<ThreadPool> pool, std::function<void()> run, std::function<void()> drop) {
+    {
+        std::lock_guard<std::mutex> lock(strictMtx_);
+        strictQueue_.push_back(StrictJob{std::move(pool), std::move(run), std::move(drop)});
+        if (strictRunning_) {
+            return;
+        }
+        strictRunning_ = true;
+    }
+    runNextStrict();
+}
+
+void ConnectionOrdering::strictDone() { runNextStrict(); }
+
+void ConnectionOrdering::runNextStrict() {
+    for (;;) {
+        StrictJob job;
+        {
+            std::lock_guard<std::mutex> lock(strictMtx_);
+            if (strictQueue_.empty()) {
+                strictRunning_ = false;
+                return;
+            }
+            job = std::move(strictQueue_.front());
+            strictQueue_.pop_front();
+        }
+
+        // 请求结束时由 run 调用 strictDone 再取下一个：同一连接任何时刻最多一个请求在执行（含挂起中的）
+        if (!job.pool) {
+            job.run();
+            return;
+        }
+        ConnectionOrdering* prev = std::exchange(tlStrictSubmitting, this);
+        try {
+            job.pool->post(StrictPoolJob(shared_from_this(), std::move(job.run), std::move(job.drop)));
+            tlStrictSubmitting = prev;
+            return;
+        } catch (const std::exception& ex) {
+            // 任务已随投递失败销毁并调用了 drop，这里接着取下一个
+            tlStrictSubmitting = prev;
+            SPDLOG_ERROR("[Ordering] strict submit failed: {}", ex.what());
+        }
+    }
+}
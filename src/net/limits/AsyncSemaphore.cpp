@@ -0,0 +1,110 @@
+#include "AsyncSemaphore.h"
+
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+AsyncSemaphore::AsyncSemaphore(std::size_t permits, std::size_t maxQueue, std::chrono::milliseconds timeout)
+    : permits_(permits), maxQueue_(maxQueue), timeoutMs_(timeout.count()) {}
+
+void AsyncSemaphore::setLimits(std::size_t permits, std::size_t maxQueue, std::chrono::milliseconds timeout) {
+    permits_.store(permits, std::memory_order_relaxed);
+    maxQueue_.store(maxQueue, std::memory_order_relaxed);
+    timeoutMs_.store(timeout.count(), std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    grantLocked();
+}
+
+bool AsyncSemaphore::tryTake() {
+    std::size_t cur = inUse_.load(std::memory_order_seq_cst);
+    while (cur < permits_.load(std::memory_order_relaxed)) {
+        if (inUse_.compare_exchange_weak(cur, cur + 1, std::memory_order_seq_cst)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AsyncSemaphore::tryAcquire() {
+    // 有人排队时新请求不插队，保证 FIFO
+    if (waiting_.load(std::memory_order_seq_cst) > 0) {
+        return false;
+    }
+    return tryTake();
+}
+
+boost::asio::awaitable<AsyncSemaphore::AcquireResult> AsyncSemaphore::acquire() {
+    auto waiter = std::make_shared<Waiter>(boost::asio::steady_timer(co_await boost::asio::this_coro::executor));
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (queue_.size() >= maxQueue_.load(std::memory_order_relaxed)) {
+            co_return AcquireResult::QueueFull;
+        }
+        // 先登记再复查名额：与 release 的“先归还再看 waiting_”配对，名额不会在两者之间被漏掉
+        waiting_.fetch_add(1, std::memory_order_seq_cst);
+        if (queue_.empty() && tryTake()) {
+            waiting_.fetch_sub(1, std::memory_order_relaxed);
+            co_return AcquireResult::Acquired;
+        }
+        waiter->timer.expires_after(std::chrono::milliseconds(timeoutMs_.load(std::memory_order_relaxed)));
+        queue_.push_back(waiter);
+    }
+
+    co_return co_await waitFor(std::move(waiter));
+}
+
+boost::asio::awaitable<AsyncSemaphore::AcquireResult> AsyncSemaphore::waitFor(std::shared_ptr<Waiter> waiter) {
+    // 协程挂起后才开始等待：acquire 解锁到这里之间若已被转交，直接投递恢复；否则等定时器到期或被 grantLocked 取消。
+    // 写成普通函数而非协程体内的 lambda：GCC 12 在协程体内嵌套 lambda 的按值捕获上有缺陷（共享指针计数被提前归零）
+    return boost::asio::async_initiate<decltype(boost::asio::use_awaitable), void(AcquireResult)>(
+        [this, waiter = std::move(waiter)](auto handler) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (waiter->result) {
+                auto ex = boost::asio::get_associated_executor(handler, waiter->timer.get_executor());
+                boost::asio::post(ex, [handler = std::move(handler), result = *waiter->result]() mutable { std::move(handler)(result); });
+                return;
+            }
+            waiter->timer.async_wait([this, waiter, handler = std::move(handler)](const boost::system::error_code&) mutable {
+                AcquireResult result;
+                {
+                    std::lock_guard<std::mutex> lock(mtx_);
+                    if (!waiter->result) {
+                        // 超时：从队列中摘掉自己（转交与超时以 result 为准，在锁内判定，不会两边都生效）
+                        queue_.erase(std::find(queue_.begin(), queue_.end(), waiter));
+                        waiting_.fetch_sub(1, std::memory_order_relaxed);
+                        waiter->result = AcquireResult::TimedOut;
+                    }
+                    result = *waiter->result;
+                }
+                std::move(handler)(result);
+            });
+        },
+        boost::asio::use_awaitable);
+}
+
+void AsyncSemaphore::release() {
+    // 不减到 0 以下：限流策略热更新时，更新前放行的请求可能并没有占用本信号量的名额
+    std::size_t cur = inUse_.load(std::memory_order_relaxed);
+    while (cur > 0 && !inUse_.compare_exchange_weak(cur, cur - 1, std::memory_order_seq_cst)) {
+    }
+    if (waiting_.load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    grantLocked();
+}
+
+void AsyncSemaphore::grantLocked() {
+    while (!queue_.empty() && tryTake()) {
+        auto waiter = std::move(queue_.front());
+        queue_.pop_front();
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+        waiter->result = AcquireResult::Acquired;
+        // 等待还没开始时取消不生效，由 acquire 的发起函数看到 result 后直接恢复
+        waiter->timer.cancel();
+    }
+}
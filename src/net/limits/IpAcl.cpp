@@ -0,0 +1,281 @@
+#include "IpAcl.h"
+
+#include <algorithm>
+#include <charconv>
+#include <map>
+#include <tuple>
+
+#include <spdlog/spdlog.h>
+
+#include "Config.h"
+
+namespace {
+    // IpKey 的 16 字节按大端拆成两个 64 位字，第 0 位是最高位
+    void ToWords(const IpKey& key, std::uint64_t& hi, std::uint64_t& lo) {
+        hi = 0;
+        lo = 0;
+        for (int i = 0; i < 8; ++i) {
+            hi = (hi << 8) | key.bytes[i];
+            lo = (lo << 8) | key.bytes[8 + i];
+        }
+    }
+
+    IpKey FromWords(std::uint64_t hi, std::uint64_t lo) {
+        IpKey key;
+        for (int i = 7; i >= 0; --i) {
+            key.bytes[i] = static_cast<std::uint8_t>(hi);
+            key.bytes[8 + i] = static_cast<std::uint8_t>(lo);
+            hi >>= 8;
+            lo >>= 8;
+        }
+        return key;
+    }
+
+    int BitAt(std::uint64_t hi, std::uint64_t lo, std::uint32_t pos) {
+        return pos < 64 ? static_cast<int>((hi >> (63 - pos)) & 1) : static_cast<int>((lo >> (127 - pos)) & 1);
+    }
+
+    void SetBit(std::uint64_t& hi, std::uint64_t& lo, std::uint32_t pos) {
+        if (pos < 64) {
+            hi |= std::uint64_t{1} << (63 - pos);
+        } else {
+            lo |= std::uint64_t{1} << (127 - pos);
+        }
+    }
+
+    // 只保留高 len 位
+    void MaskTo(std::uint64_t& hi, std::uint64_t& lo, std::uint32_t len) {
+        if (len == 0) {
+            hi = lo = 0;
+        } else if (len < 64) {
+            hi &= ~std::uint64_t{0} << (64 - len);
+            lo = 0;
+        } else if (len == 64) {
+            lo = 0;
+        } else if (len < 128) {
+            lo &= ~std::uint64_t{0} << (128 - len);
+        }
+    }
+
+    // (hi, lo) 的高 len 位与前缀相同
+    bool PrefixMatches(std::uint64_t hi, std::uint64_t lo, std::uint64_t phi, std::uint64_t plo, std::uint32_t len) {
+        if (len == 0) {
+            return true;
+        }
+        if (len <= 64) {
+            return ((hi ^ phi) >> (64 - len)) == 0;
+        }
+        if (hi != phi) {
+            return false;
+        }
+        return len == 128 ? lo == plo : ((lo ^ plo) >> (128 - len)) == 0;
+    }
+
+    constexpr std::uint32_t kV4MappedBits = 96;
+}  // namespace
+
+IpAcl& IpAcl::Instance() {
+    static IpAcl inst;
+    return inst;
+}
+
+bool IpAcl::ParsePrefix(const std::string& text, bool deny, Prefix& out) {
+    auto slash = text.find('/');
+    auto key = IpKey::Parse(text.substr(0, slash));
+    if (!key) {
+        return false;
+    }
+    const bool v4 = key->isV4() && text.find(':') == std::string::npos;
+    const std::uint32_t maxBits = v4 ? 32 : 128;
+    std::uint32_t bits = maxBits;
+    if (slash != std::string::npos) {
+        const char* first = text.data() + slash + 1;
+        const char* last = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(first, last, bits);
+        if (ec != std::errc() || ptr != last || first == last || bits > maxBits) {
+            return false;
+        }
+    }
+
+    out.deny = deny;
+    out.len = v4 ? kV4MappedBits + bits : bits;
+    ToWords(*key, out.hi, out.lo);
+    MaskTo(out.hi, out.lo, out.len);
+    // 规范化文本：主机位清零，便于去重与按规则计数
+    auto base = FromWords(out.hi, out.lo);
+    out.cidr = (v4 ? base.toString() : boost::asio::ip::address_v6(base.bytes).to_string()) + "/" + std::to_string(bits);
+    return true;
+}
+
+void IpAcl::update(const IpLimitConfig& cfg) {
+    std::vector<Prefix> prefixes;
+    auto add = [&prefixes](const std::string& text, bool deny, const char* list) {
+        Prefix p;
+        if (ParsePrefix(text, deny, p)) {
+            prefixes.push_back(std::move(p));
+        } else {
+            SPDLOG_WARN("[IpAcl] invalid {} entry '{}', ignored", list, text);
+        }
+    };
+    for (const auto& text : cfg.deny) {
+        add(text, true, "ipLimit.deny");
+    }
+    for (const auto& text : cfg.allow) {
+        add(text, false, "ipLimit.allow");
+    }
+    for (const auto& text : cfg.whitelist) {
+        add(text, false, "ipLimit.whitelist");
+    }
+
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    std::unique_ptr<const Table> table = compile(std::move(prefixes));
+    table_.store(table.get(), std::memory_order_seq_cst);
+    // 等发布前开始的查找都结束，旧快照随之释放
+    epoch_.synchronize();
+    current_ = std::move(table);
+}
+
+std::unique_ptr<IpAcl::Table> IpAcl::compile(std::vector<Prefix> prefixes) {
+    auto table = std::make_unique<Table>();
+
+    // 去重：同一前缀只留一条，deny 优先
+    std::map<std::tuple<std::uint32_t, std::uint64_t, std::uint64_t>, Prefix> unique;
+    for (auto& p : prefixes) {
+        auto key = std::make_tuple(p.len, p.hi, p.lo);
+        auto it = unique.find(key);
+        if (it == unique.end()) {
+            unique.emplace(key, std::move(p));
+        } else if (p.deny != it->second.deny) {
+            SPDLOG_WARN("[IpAcl] {} is in both allow and deny lists, deny wins", p.cidr);
+            if (p.deny) {
+                it->second = std::move(p);
+            }
+        }
+    }
+    if (unique.empty()) {
+        return table;
+    }
+
+    for (auto& [_, p] : unique) {
+        auto& counter = counters_[(p.deny ? "deny " : "allow ") + p.cidr];
+        if (!counter) {
+            counter = std::make_unique<std::atomic<std::uint64_t>>(0);
+        }
+        table->rules.push_back(Rule{p.cidr, p.deny, counter.get()});
+    }
+
+    // 1) 逐位插入一棵未压缩的二叉树
+    struct Plain {
+        std::int32_t child[2]{-1, -1};
+        std::int32_t rule{-1};
+    };
+    std::vector<Plain> plain(1);
+    std::int32_t ruleIdx = 0;
+    for (const auto& [_, p] : unique) {
+        std::int32_t n = 0;
+        for (std::uint32_t pos = 0; pos < p.len; ++pos) {
+            int bit = BitAt(p.hi, p.lo, pos);
+            if (plain[n].child[bit] < 0) {
+                plain[n].child[bit] = static_cast<std::int32_t>(plain.size());
+                plain.emplace_back();
+            }
+            n = plain[n].child[bit];
+        }
+        plain[n].rule = ruleIdx++;
+    }
+
+    // 2) 压缩：跳过既无规则又只有一个孩子的节点，其余节点连同完整前缀写入连续数组
+    auto& nodes = table->nodes;
+    auto emit = [&](auto&& self, std::int32_t n, std::uint32_t depth, std::uint64_t hi, std::uint64_t lo) -> std::uint32_t {
+        while (plain[n].rule < 0 && ((plain[n].child[0] < 0) != (plain[n].child[1] < 0))) {
+            int bit = plain[n].child[1] >= 0 ? 1 : 0;
+            if (bit) {
+                SetBit(hi, lo, depth);
+            }
+            n = plain[n].child[bit];
+            ++depth;
+        }
+        auto idx = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(Node{hi, lo, depth, plain[n].rule, {kNil, kNil}});
+        for (int bit = 0; bit < 2; ++bit) {
+            if (plain[n].child[bit] >= 0) {
+                std::uint64_t chi = hi;
+                std::uint64_t clo = lo;
+                if (bit) {
+                    SetBit(chi, clo, depth);
+                }
+                std::uint32_t c = self(self, plain[n].child[bit], depth + 1, chi, clo);
+                nodes[idx].child[bit] = c;
+            }
+        }
+        return idx;
+    };
+    emit(emit, 0, 0, 0, 0);
+    return table;
+}
+
+IpAcl::Verdict IpAcl::check(const IpKey& ip) const {
+    EpochDomain::ReadGuard guard(epoch_);
+    const Table* t = table();
+    if (!t || t->nodes.empty()) {
+        return Verdict::None;
+    }
+    std::uint64_t hi;
+    std::uint64_t lo;
+    ToWords(ip, hi, lo);
+
+    std::int32_t best = -1;
+    std::uint32_t n = 0;
+    while (n != kNil) {
+        const Node& node = t->nodes[n];
+        if (!PrefixMatches(hi, lo, node.hi, node.lo, node.len)) {
+            break;
+        }
+        if (node.rule >= 0) {
+            best = node.rule;
+        }
+        if (node.len == 128) {
+            break;
+        }
+        n = node.child[BitAt(hi, lo, node.len)];
+    }
+    if (best < 0) {
+        return Verdict::None;
+    }
+    const Rule& rule = t->rules[best];
+    rule.hits->fetch_add(1, std::memory_order_relaxed);
+    return rule.deny ? Verdict::Deny : Verdict::Allow;
+}
+
+std::size_t IpAcl::ruleCount() const {
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    const Table* t = table();
+    return t ? t->rules.size() : 0;
+}
+
+void IpAcl::print(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    const Table* t = table();
+    if (!t || t->rules.empty()) {
+        os << "no rules\n";
+        return;
+    }
+    os << "rules=" << t->rules.size() << " trieNodes=" << t->nodes.size() << "\n";
+    for (const auto& rule : t->rules) {
+        os << (rule.deny ? "deny  " : "allow ") << rule.cidr << " hits=" << rule.hits->load(std::memory_order_relaxed) << "\n";
+    }
+}
+
+void IpAcl::printPrometheus(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    const Table* t = table();
+    if (!t || t->rules.empty()) {
+        return;
+    }
+    os << "# TYPE server_ip_acl_hits_total counter\n";
+    for (const auto& rule : t->rules) {
+        os << "server_ip_acl_hits_total{rule=\"" << rule.cidr << "\",action=\"" << (rule.deny ? "deny" : "allow") << "\"} "
+           << rule.hits->load(std::memory_order_relaxed) << "\n";
+    }
+    os << "\n";
+}
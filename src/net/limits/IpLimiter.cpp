@@ -1,5 +1,6 @@
 #include "IpLimiter.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include "Config.h"
@@ -11,118 +12,145 @@ IpLimiter& IpLimiter::Instance() {
 }
 
 void IpLimiter::updateConfig(const IpLimitConfig& cfg) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    whitelist_ = cfg.whitelist;
-    maxConnPerIp_ = cfg.maxConnPerIp;
-    maxQpsPerIp_ = cfg.maxQpsPerIp;
-    stateTtlSec_ = cfg.stateTtlSec;
+    auto s = std::make_unique<Settings>();
+    s->maxConnPerIp = cfg.maxConnPerIp;
+    if (cfg.maxQpsPerIp > 0) {
+        std::size_t burst = cfg.qpsBurst > 0 ? cfg.qpsBurst : cfg.maxQpsPerIp;
+        s->emissionNs = std::max<std::int64_t>(1, 1'000'000'000LL / static_cast<std::int64_t>(cfg.maxQpsPerIp));
+        s->toleranceNs = s->emissionNs * static_cast<std::int64_t>(burst);
+    }
+    s->ttlNs = static_cast<std::int64_t>(cfg.stateTtlSec) * 1'000'000'000LL;
+
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    settings_.store(s.get(), std::memory_order_seq_cst);
+    // 等发布前开始的判定都结束，旧快照随之释放
+    epoch_.synchronize();
+    current_ = std::move(s);
 }
 
-bool IpLimiter::allowConn(const std::string& ip) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (whitelist_.count(ip))
-        return true;
-    if (maxConnPerIp_ == 0)
+bool IpLimiter::allowConn(const IpKey& ip) {
+    EpochDomain::ReadGuard guard(epoch_);
+    const Settings* s = settings();
+    if (!s || s->maxConnPerIp == 0)
         return true;
-    auto nowSec = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
-                                                 std::chrono::system_clock::now().time_since_epoch())
-                                                 .count());
-    gcIfNeeded(nowSec);
 
-    auto& c = connCount_[ip];
-    if (c >= maxConnPerIp_) {
+    auto now = nowNs();
+    Shard& shard = shardFor(ip);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    State& st = stateFor(shard, ip, *s, now);
+    if (st.conns >= s->maxConnPerIp) {
         return false;
     }
-    ++c;
-    touch(ip, nowSec);
+    ++st.conns;
     return true;
 }
 
-void IpLimiter::onConnClose(const std::string& ip) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = connCount_.find(ip);
-    if (it != connCount_.end()) {
-        if (it->second > 0)
-            --it->second;
+void IpLimiter::onConnClose(const IpKey& ip) {
+    Shard& shard = shardFor(ip);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.states.find(ip);
+    if (it != shard.states.end()) {
+        if (it->second.conns > 0)
+            --it->second.conns;
     }
 }
 
-bool IpLimiter::allowQps(const std::string& ip) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (whitelist_.count(ip))
+bool IpLimiter::allowQps(const IpKey& ip) {
+    EpochDomain::ReadGuard guard(epoch_);
+    const Settings* s = settings();
+    if (!s || s->emissionNs == 0)
         return true;
-    if (maxQpsPerIp_ == 0)
-        return true;
-
-    auto now = std::chrono::system_clock::now().time_since_epoch();
-    std::uint64_t sec = std::chrono::duration_cast<std::chrono::seconds>(now).count();
 
-    gcIfNeeded(sec);
+    auto now = nowNs();
+    Shard& shard = shardFor(ip);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    State& st = stateFor(shard, ip, *s, now);
 
-    auto& st = qpsCount_[ip];
-    if (st.windowSec != sec) {
-        st.windowSec = sec;
-        st.count = 0;
-    }
-    if (st.count >= maxQpsPerIp_) {
+    // GCRA：请求把 tat 推后 emission，推后的结果超出 now + tolerance 即额度用尽
+    std::int64_t newTat = std::max(st.tatNs, now) + s->emissionNs;
+    if (newTat - now > s->toleranceNs) {
         return false;
     }
-    ++st.count;
-    st.lastAccess = sec;
+    st.tatNs = newTat;
     return true;
 }
 
+std::size_t IpLimiter::connCount(const IpKey& ip) const {
+    const Shard& shard = shardFor(ip);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.states.find(ip);
+    return it == shard.states.end() ? 0 : it->second.conns;
+}
+
+bool IpLimiter::allowConn(const std::string& ip) {
+    auto key = IpKey::Parse(ip);
+    return !key || allowConn(*key);
+}
+
+void IpLimiter::onConnClose(const std::string& ip) {
+    if (auto key = IpKey::Parse(ip)) {
+        onConnClose(*key);
+    }
+}
+
+bool IpLimiter::allowQps(const std::string& ip) {
+    auto key = IpKey::Parse(ip);
+    return !key || allowQps(*key);
+}
+
 std::size_t IpLimiter::connCount(const std::string& ip) const {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = connCount_.find(ip);
-    return it == connCount_.end() ? 0 : it->second;
+    auto key = IpKey::Parse(ip);
+    return key ? connCount(*key) : 0;
 }
 
-void IpLimiter::gcIfNeeded(std::uint64_t nowSec) {
-    if (stateTtlSec_ == 0)
-        return;
-    if (lastGcSec_ != 0 && nowSec - lastGcSec_ < stateTtlSec_)
+IpLimiter::State& IpLimiter::stateFor(Shard& shard, const IpKey& ip, const Settings& s, std::int64_t now) {
+    // 先清理再插入：刚插入的元素不会被本次清理误删
+    gcStep(shard, s, now);
+    auto [it, inserted] = shard.states.try_emplace(ip);
+    if (inserted) {
+        MetricsRegistry::Instance().ipTrackedStates().inc();
+        // ttl=0 时状态永不过期，不必入队
+        if (s.ttlNs > 0) {
+            shard.expiry.push_back({ip, now});
+        }
+    }
+    it->second.lastAccessNs = now;
+    return it->second;
+}
+
+void IpLimiter::gcStep(Shard& shard, const Settings& s, std::int64_t now) {
+    if (s.ttlNs == 0)
         return;
-    lastGcSec_ = nowSec;
-
-    auto gcMap = [this, nowSec](auto& mp, auto accessor) {
-        for (auto it = mp.begin(); it != mp.end();) {
-            std::uint64_t last = accessor(it->second);
-            if (nowSec - last > stateTtlSec_) {
-                it = mp.erase(it);
-            } else {
-                ++it;
-            }
+
+    // 队头未到期时只比较一次时间戳，不访问状态表；到期的元素才去查最新状态：
+    // 确已过期（无连接且 TTL 内无访问）则删除，否则按最近访问时间重新入队，每个 IP 每个 TTL 最多复查一次
+    std::int64_t expired = 0;
+    for (std::size_t n = 0; n < kGcPerCall && !shard.expiry.empty(); ++n) {
+        Expiry e = shard.expiry.front();
+        if (now - e.stampNs <= s.ttlNs) {
+            break;
         }
-    };
-
-    // 清理长时间无访问且无连接计数的 IP
-    for (auto it = connCount_.begin(); it != connCount_.end();) {
-        auto qit = qpsCount_.find(it->first);
-        std::uint64_t last = 0;
-        if (qit != qpsCount_.end()) {
-            last = qit->second.lastAccess;
+        shard.expiry.pop_front();
+        auto it = shard.states.find(e.ip);
+        if (it == shard.states.end()) {
+            continue;
         }
-        bool expired = (last > 0 && nowSec - last > stateTtlSec_) && it->second == 0;
-        if (expired) {
-            it = connCount_.erase(it);
-            if (qit != qpsCount_.end()) {
-                qpsCount_.erase(qit);
-            }
+        const State& st = it->second;
+        if (st.conns == 0 && now - st.lastAccessNs > s.ttlNs) {
+            shard.states.erase(it);
+            ++expired;
         } else {
-            ++it;
+            shard.expiry.push_back({e.ip, st.conns > 0 ? now : st.lastAccessNs});
         }
     }
-    gcMap(qpsCount_, [](const QpsState& st) { return st.lastAccess; });
+    if (expired > 0) {
+        MetricsRegistry::Instance().ipTrackedStates().inc(-expired);
+        MetricsRegistry::Instance().ipStatesExpired().inc(expired);
+    }
 }
 
-void IpLimiter::touch(const std::string& ip, std::uint64_t nowSec) {
-    auto it = qpsCount_.find(ip);
-    if (it != qpsCount_.end()) {
-        it->second.lastAccess = nowSec;
-    } else {
-        QpsState st;
-        st.lastAccess = nowSec;
-        qpsCount_[ip] = st;
-    }
+std::int64_t IpLimiter::nowNs() {
+    using namespace std::chrono;
+    auto now = steady_clock::now().time_since_epoch();
+    return duration_cast<nanoseconds>(now).count();
 }
@@ -1,131 +1,229 @@
 #include "MessageLimiter.h"
 
+#include <algorithm>
+
 #include <spdlog/spdlog.h>
 #include "Metrics.h"
 
-void MessageLimiter::updateFromConfig(const Config& cfg) {
-    const auto& cfgMap = cfg.msgLimits();
-    std::lock_guard<std::mutex> lock(mtx_);
+MessageLimiter::~MessageLimiter() {
+    for (auto& page : pages_) {
+        delete[] page.load(std::memory_order_relaxed);
+    }
+}
+
+void MessageLimiter::updateFromConfig(const Config& cfg) { update(cfg.msgLimits()); }
 
-    for (auto& kv : cfgMap) {
-        auto msgType = kv.first;
-        const auto& limitCfg = kv.second;
+void MessageLimiter::update(const std::unordered_map<std::uint16_t, MsgLimitConfig>& limits) {
+    std::lock_guard<std::mutex> lock(updateMtx_);
+    std::vector<std::unique_ptr<const Limit>> retired;
 
-        auto it = states_.find(msgType);
-        if (it == states_.end()) {
-            auto st = std::make_shared<PerMsgState>();
-            st->cfg = limitCfg;
-            st->lastRefillNs = nowNs();
+    for (const auto& [msgType, limitCfg] : limits) {
+        auto limit = std::make_unique<Limit>();
+        limit->enabled = limitCfg.enabled;
+        limit->maxConcurrent = limitCfg.maxConcurrent;
+        limit->maxQueue = limitCfg.maxConcurrent > 0 ? limitCfg.maxQueue : 0;
+        if (limitCfg.maxQps > 0) {
             int burst = (limitCfg.burst > 0) ? limitCfg.burst : limitCfg.maxQps;
-            st->tokens = static_cast<double>(burst);
-            states_[msgType] = std::move(st);
-        } else {
-            it->second->cfg = limitCfg;
+            limit->emissionNs = std::max<std::int64_t>(1, 1'000'000'000LL / limitCfg.maxQps);
+            limit->toleranceNs = limit->emissionNs * std::max(1, burst);
         }
-    }
-}
 
-bool MessageLimiter::allow(std::uint16_t msgType) {
-    auto st = getOrCreateState(msgType);
-    if (!st) {
-        SPDLOG_ERROR("[MessageLimiter] getOrCreateState(msgType={}) returned null", msgType);
-        return true;
+        Bucket* b = bucket(msgType, true);
+        // 信号量先于策略就位：读到 maxQueue > 0 的策略时 sem 一定已存在
+        AsyncSemaphore* sem = b->sem.load(std::memory_order_relaxed);
+        auto permits = static_cast<std::size_t>(std::max(0, limitCfg.maxConcurrent));
+        auto maxQueue = static_cast<std::size_t>(limit->maxQueue);
+        std::chrono::milliseconds timeout(std::max(0, limitCfg.queueTimeoutMs));
+        if (sem) {
+            sem->setLimits(permits, maxQueue, timeout);
+        } else if (limit->maxQueue > 0) {
+            sems_.push_back(std::make_unique<AsyncSemaphore>(permits, maxQueue, timeout));
+            b->sem.store(sems_.back().get(), std::memory_order_release);
+        }
+
+        const Limit* prev = b->limit.exchange(limit.get(), std::memory_order_seq_cst);
+        if (!prev) {
+            // 首次配置：桶是满的（tat 不晚于当前时刻）
+            b->tatNs.store(0, std::memory_order_relaxed);
+        }
+        auto& owned = limits_[msgType];
+        if (owned) {
+            retired.push_back(std::move(owned));
+        }
+        owned = std::move(limit);
     }
-    const auto cfg = st->cfg;
-    if (!cfg.enabled) {
-        st->accepted.fetch_add(1, std::memory_order_relaxed);
-        return true;
+
+    // 等发布前开始的判定都结束，被替换的策略随 retired 释放
+    if (!retired.empty()) {
+        epoch_.synchronize();
     }
+}
 
-    // 先检查 QPS
-    if (cfg.maxQps > 0) {
-        int burst = (cfg.burst > 0) ? cfg.burst : cfg.maxQps;
-        const double capacity = static_cast<double>(std::max(1, burst));
-        const double ratePerNs = static_cast<double>(cfg.maxQps) / 1'000'000'000.0;
-
-        std::lock_guard<std::mutex> lock(st->mtx);
-        auto now = nowNs();
-
-        // 计算流逝时间产生的令牌
-        auto elapsed = static_cast<double>(now - st->lastRefillNs);
-        if (elapsed > 0) {
-            double refill = elapsed * ratePerNs;
-            st->tokens = std::min(capacity, st->tokens + refill);
-            st->lastRefillNs = now;
-        }
+MessageLimiter::Verdict MessageLimiter::admit(std::uint16_t msgType) {
+    Bucket* b = bucket(msgType, true);
+    EpochDomain::ReadGuard guard(epoch_);
+    const Limit* limit = b->limit.load(std::memory_order_acquire);
+    if (!limit || !limit->enabled) {
+        b->accepted.fetch_add(1, std::memory_order_relaxed);
+        return Verdict::Accept;
+    }
 
-        if (st->tokens < 1.0) {
-            st->dropped.fetch_add(1, std::memory_order_relaxed);
-            MetricsRegistry::Instance().tokenRejects().inc();
-            return false;
+    // 先检查 QPS（GCRA）：请求把 tat 推后 emission，推后的结果超出 now + tolerance 即桶已空
+    if (limit->emissionNs > 0) {
+        std::int64_t now = nowNs();
+        std::int64_t tat = b->tatNs.load(std::memory_order_relaxed);
+        bool refreshed = false;
+        for (;;) {
+            std::int64_t newTat = std::max(tat, now) + limit->emissionNs;
+            if (newTat - now > limit->toleranceNs) {
+                if (!refreshed) {
+                    // 取时间后被调度出去时 now 会落后于别的线程推进的 tat，拒绝前用最新时间再判一次
+                    refreshed = true;
+                    now = nowNs();
+                    continue;
+                }
+                b->dropped.fetch_add(1, std::memory_order_relaxed);
+                MetricsRegistry::Instance().tokenRejects().inc();
+                return Verdict::Reject;
+            }
+            if (b->tatNs.compare_exchange_weak(tat, newTat, std::memory_order_relaxed, std::memory_order_relaxed)) {
+                break;
+            }
         }
-        st->tokens -= 1.0;
     }
 
     // 再检查并发
-    if (cfg.maxConcurrent > 0) {
-        int prev = st->concurrent.fetch_add(1, std::memory_order_relaxed);
-        if (prev >= cfg.maxConcurrent) {
-            st->concurrent.fetch_sub(1, std::memory_order_relaxed);
-            st->dropped.fetch_add(1, std::memory_order_relaxed);
-            MetricsRegistry::Instance().concurrentRejects().inc();
-
-            // 【重要】回滚刚才扣掉的令牌 (Revert Token)
-            if (cfg.maxQps > 0) {
-                std::lock_guard<std::mutex> lock(st->mtx);
-                st->tokens += 1.0;
+    if (limit->maxConcurrent > 0) {
+        if (AsyncSemaphore* sem = b->sem.load(std::memory_order_acquire)) {
+            if (!sem->tryAcquire()) {
+                // 可排队时保留已扣的令牌，由 waitForSlot 决定最终放行还是回滚
+                if (limit->maxQueue > 0) {
+                    return Verdict::Queue;
+                }
+                rejectConcurrent(b, limit->emissionNs);
+                return Verdict::Reject;
             }
-            return false;
+        } else {
+            int prev = b->concurrent.fetch_add(1, std::memory_order_relaxed);
+            if (prev >= limit->maxConcurrent) {
+                b->concurrent.fetch_sub(1, std::memory_order_relaxed);
+                rejectConcurrent(b, limit->emissionNs);
+                return Verdict::Reject;
+            }
+        }
+    }
+    b->accepted.fetch_add(1, std::memory_order_relaxed);
+    return Verdict::Accept;
+}
+
+boost::asio::awaitable<bool> MessageLimiter::waitForSlot(std::uint16_t msgType) {
+    Bucket* b = bucket(msgType, true);
+    // 排队期间不持有策略快照：先记下 admit 时扣掉的额度，拒绝时按它回滚
+    const std::int64_t emissionNs = emissionOf(b);
+    AsyncSemaphore* sem = b->sem.load(std::memory_order_acquire);
+    if (!sem) {
+        rejectConcurrent(b, emissionNs);
+        co_return false;
+    }
+
+    auto& metrics = MetricsRegistry::Instance();
+    metrics.limitQueueDepth().inc();
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = co_await sem->acquire();
+    metrics.limitQueueDepth().inc(-1);
+
+    if (result == AsyncSemaphore::AcquireResult::QueueFull) {
+        metrics.limitQueueFull().inc();
+    } else {
+        metrics.limitQueueWaitMs().observe(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        if (result == AsyncSemaphore::AcquireResult::TimedOut) {
+            metrics.limitQueueTimeouts().inc();
         }
     }
-    st->accepted.fetch_add(1, std::memory_order_relaxed);
-    return true;
+    if (result != AsyncSemaphore::AcquireResult::Acquired) {
+        rejectConcurrent(b, emissionNs);
+        co_return false;
+    }
+    b->accepted.fetch_add(1, std::memory_order_relaxed);
+    co_return true;
+}
+
+bool MessageLimiter::allow(std::uint16_t msgType) {
+    Verdict verdict = admit(msgType);
+    if (verdict == Verdict::Queue) {
+        Bucket* b = bucket(msgType, false);
+        rejectConcurrent(b, emissionOf(b));
+        return false;
+    }
+    return verdict == Verdict::Accept;
+}
+
+void MessageLimiter::rejectConcurrent(Bucket* b, std::int64_t emissionNs) {
+    b->dropped.fetch_add(1, std::memory_order_relaxed);
+    MetricsRegistry::Instance().concurrentRejects().inc();
+
+    // 【重要】回滚刚才扣掉的令牌 (Revert Token)
+    if (emissionNs > 0) {
+        b->tatNs.fetch_sub(emissionNs, std::memory_order_relaxed);
+    }
+}
+
+std::int64_t MessageLimiter::emissionOf(Bucket* b) const {
+    EpochDomain::ReadGuard guard(epoch_);
+    const Limit* limit = b->limit.load(std::memory_order_acquire);
+    return limit && limit->enabled ? limit->emissionNs : 0;
 }
 
 void MessageLimiter::onFinish(std::uint16_t msgType) {
-    auto st = getOrCreateState(msgType);
-    if (!st)
+    Bucket* b = bucket(msgType, false);
+    if (!b)
         return;
-    if (st->cfg.enabled && st->cfg.maxConcurrent > 0) {
-        st->concurrent.fetch_sub(1, std::memory_order_relaxed);
+    EpochDomain::ReadGuard guard(epoch_);
+    const Limit* limit = b->limit.load(std::memory_order_acquire);
+    if (limit && limit->enabled && limit->maxConcurrent > 0) {
+        if (AsyncSemaphore* sem = b->sem.load(std::memory_order_acquire)) {
+            sem->release();
+        } else {
+            b->concurrent.fetch_sub(1, std::memory_order_relaxed);
+        }
     }
 }
 
 MessageLimiter::States MessageLimiter::getStats(std::uint16_t msgType) const {
     States s;
-    auto st = getState(msgType);
-    if (!st) {
+    const Bucket* b = bucket(msgType, false);
+    if (!b) {
         return s;
     }
 
-    s.accepted = st->accepted.load(std::memory_order_relaxed);
-    s.dropped = st->dropped.load(std::memory_order_relaxed);
-    s.concurrent = static_cast<std::uint64_t>(st->concurrent.load(std::memory_order_relaxed));
+    s.accepted = b->accepted.load(std::memory_order_relaxed);
+    s.dropped = b->dropped.load(std::memory_order_relaxed);
+    if (const AsyncSemaphore* sem = b->sem.load(std::memory_order_acquire)) {
+        s.concurrent = sem->inUse();
+        s.queued = sem->waiting();
+    } else {
+        s.concurrent = static_cast<std::uint64_t>(b->concurrent.load(std::memory_order_relaxed));
+    }
     s.qps = 0;  // token bucket 不直接返回窗口 qps
     return s;
 }
 
-MessageLimiter::StatePtr MessageLimiter::getState(std::uint16_t msgType) const {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = states_.find(msgType);
-    if (it != states_.end()) {
-        return it->second;
-    }
-    return nullptr;
-}
-
-MessageLimiter::StatePtr MessageLimiter::getOrCreateState(std::uint16_t msgType) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto it = states_.find(msgType);
-    if (it != states_.end()) {
-        return it->second;
+MessageLimiter::Bucket* MessageLimiter::bucket(std::uint16_t msgType, bool create) const {
+    auto& slot = pages_[msgType >> kPageBits];
+    Bucket* page = slot.load(std::memory_order_acquire);
+    if (!page) {
+        if (!create) {
+            return nullptr;
+        }
+        // 并发首次访问同一页时只有一个安装成功，其余释放自己的那份
+        auto* fresh = new Bucket[kPageSize];
+        if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            page = fresh;
+        } else {
+            delete[] fresh;
+        }
     }
-    auto st = std::make_shared<PerMsgState>();
-    st->cfg = MsgLimitConfig{};
-    st->lastRefillNs = nowNs();
-    st->tokens = 0;
-    states_[msgType] = st;
-    return st;
+    return &page[msgType & (kPageSize - 1)];
 }
 
 std::int64_t MessageLimiter::nowNs() {
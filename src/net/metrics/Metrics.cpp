@@ -1,9 +1,14 @@
 #include "Metrics.h"
 
+#include <algorithm>
+#include <bit>
+
 Counter::Counter() : value_(0) {}
 
 void Counter::inc(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
 
+void Counter::set(std::int64_t v) { value_.store(v, std::memory_order_relaxed); }
+
 std::int64_t Counter::value() const { return value_.load(std::memory_order_relaxed); }
 
 std::int64_t Counter::fetchAdd(std::int64_t n) { return value_.fetch_add(n, std::memory_order_relaxed); }
@@ -85,6 +90,109 @@ std::size_t LatencyMetric::bucketIndex(double ms) {
     return 4;
 }
 
+namespace {
+    // 线程固定分到的分片序号：首次 observe 时按到达顺序轮转分配
+    std::size_t ThreadShardIndex() {
+        static std::atomic<std::size_t> next{0};
+        thread_local const std::size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+        return idx;
+    }
+}  // namespace
+
+Histogram::Histogram(std::vector<double> bounds, std::size_t shards)
+    : bounds_(std::move(bounds)), shards_(std::max<std::size_t>(1, shards)), lines_((bounds_.size() + 3 + 7) / 8), data_(new Line[shards_ * lines_]) {
+    for (std::size_t i = 0; i < shards_ * lines_; ++i) {
+        for (auto& v : data_[i].v) {
+            v.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::atomic<std::uint64_t>* Histogram::shard(std::size_t i) const { return data_[i * lines_].v; }
+
+void Histogram::observe(double v) {
+    std::atomic<std::uint64_t>* s = shard(shards_ == 1 ? 0 : ThreadShardIndex() % shards_);
+    const std::size_t n = bounds_.size();
+    // 桶数很少（<= 十几个），线性查找比二分更快
+    std::size_t idx = 0;
+    while (idx < n && v > bounds_[idx]) {
+        ++idx;
+    }
+    s[idx].fetch_add(1, std::memory_order_relaxed);
+    s[n + 1].fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t old = s[n + 2].load(std::memory_order_relaxed);
+    while (!s[n + 2].compare_exchange_weak(old, std::bit_cast<std::uint64_t>(std::bit_cast<double>(old) + v), std::memory_order_relaxed,
+                                           std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    const std::size_t n = bounds_.size();
+    Snapshot snap{0, 0, std::vector<std::uint64_t>(n + 1, 0)};
+    for (std::size_t i = 0; i < shards_; ++i) {
+        const std::atomic<std::uint64_t>* s = shard(i);
+        for (std::size_t b = 0; b <= n; ++b) {
+            snap.buckets[b] += s[b].load(std::memory_order_relaxed);
+        }
+        snap.count += s[n + 1].load(std::memory_order_relaxed);
+        snap.sum += std::bit_cast<double>(s[n + 2].load(std::memory_order_relaxed));
+    }
+    return snap;
+}
+
+const std::vector<double>& Histogram::bounds() const { return bounds_; }
+
+void Histogram::print(const std::string& name, std::ostream& os) const {
+    auto s = snapshot();
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << name << ": count=" << s.count;
+    if (s.count > 0) {
+        os << ", avg=" << std::fixed << std::setprecision(1) << s.sum / s.count;
+    }
+    os.unsetf(std::ios_base::floatfield);  // 桶上界按默认格式输出
+    os.precision(precision);
+    os << " | buckets";
+    for (std::size_t i = 0; i < s.buckets.size(); ++i) {
+        os << " <=";
+        if (i < bounds_.size()) {
+            os << bounds_[i];
+        } else {
+            os << "+Inf";
+        }
+        os << ":" << s.buckets[i];
+    }
+    os << "\n";
+    os.flags(flags);
+}
+
+void Histogram::printPrometheus(const std::string& name, std::ostream& os, const std::string& labels, bool withType) const {
+    auto s = snapshot();
+    const auto flags = os.flags();
+    os.unsetf(std::ios_base::floatfield);
+    const std::string sep = labels.empty() ? "" : ",";
+
+    if (withType) {
+        os << "# TYPE " << name << " histogram\n";
+    }
+    std::uint64_t cum = 0;
+    for (std::size_t i = 0; i < s.buckets.size(); ++i) {
+        cum += s.buckets[i];
+        os << name << "_bucket{" << labels << sep << "le=\"";
+        if (i < bounds_.size()) {
+            os << bounds_[i];
+        } else {
+            os << "+Inf";
+        }
+        os << "\"} " << cum << "\n";
+    }
+    const std::string lbl = labels.empty() ? "" : "{" + labels + "}";
+    os << name << "_sum" << lbl << " " << std::fixed << std::setprecision(6) << s.sum << "\n";
+    os << name << "_count" << lbl << " " << s.count << "\n";
+    os.flags(flags);
+}
+
 MetricsRegistry& MetricsRegistry::Instance() {
     static MetricsRegistry instance;
     return instance;
@@ -118,16 +226,60 @@ Counter& MetricsRegistry::tokenRejects() { return tokenRejects_; }
 
 Counter& MetricsRegistry::concurrentRejects() { return concurrentRejects_; }
 
+Counter& MetricsRegistry::limitQueueDepth() { return limitQueueDepth_; }
+
+Counter& MetricsRegistry::limitQueueTimeouts() { return limitQueueTimeouts_; }
+
+Counter& MetricsRegistry::limitQueueFull() { return limitQueueFull_; }
+
+Histogram& MetricsRegistry::limitQueueWaitMs() { return limitQueueWaitMs_; }
+
 Counter& MetricsRegistry::sendQueueMaxBytes() { return sendQueueMaxBytes_; }
 
 Counter& MetricsRegistry::workerQueueSize() { return workerQueueSize_; }
 
 Counter& MetricsRegistry::workerLiveThreads() { return workerLiveThreads_; }
 
+Counter& MetricsRegistry::workerTargetThreads() { return workerTargetThreads_; }
+
+Counter& MetricsRegistry::workerQueueWaitP99Us() { return workerQueueWaitP99Us_; }
+
+Counter& MetricsRegistry::workerUtilizationPct() { return workerUtilizationPct_; }
+
+Counter& MetricsRegistry::workerCpuPct() { return workerCpuPct_; }
+
+Counter& MetricsRegistry::workerCpuUsagePct() { return workerCpuUsagePct_; }
+
+Counter& MetricsRegistry::workerScaleUps() { return workerScaleUps_; }
+
+Counter& MetricsRegistry::workerScaleDowns() { return workerScaleDowns_; }
+
+Counter& MetricsRegistry::workerScaleHeld() { return workerScaleHeld_; }
+
+Counter& MetricsRegistry::workerSpinHits() { return workerSpinHits_; }
+
+Counter& MetricsRegistry::workerParks() { return workerParks_; }
+
+Histogram& MetricsRegistry::workerTaskWaitUs(int pri) { return workerTaskWaitUs_[pri]; }
+
+Histogram& MetricsRegistry::workerTaskRunUs(int pri) { return workerTaskRunUs_[pri]; }
+
 Counter& MetricsRegistry::ipRejectConn() { return ipRejectConn_; }
 
 Counter& MetricsRegistry::ipRejectQps() { return ipRejectQps_; }
 
+Counter& MetricsRegistry::ipTrackedStates() { return ipTrackedStates_; }
+
+Counter& MetricsRegistry::ipStatesExpired() { return ipStatesExpired_; }
+
+Counter& MetricsRegistry::ipAclRejects() { return ipAclRejects_; }
+
+Counter& MetricsRegistry::zeroCopySends() { return zeroCopySends_; }
+
+Counter& MetricsRegistry::zeroCopyCompleted() { return zeroCopyCompleted_; }
+
+Counter& MetricsRegistry::zeroCopyFallbacks() { return zeroCopyFallbacks_; }
+
 void MetricsRegistry::incMsgReject(std::uint16_t msgType) {
     std::lock_guard<std::mutex> lock(msgRejectsMtx_);
     auto& c = msgRejects_[msgType];
@@ -210,6 +362,20 @@ void MetricsRegistry::setFrameLatencyTrace(const std::string& traceId, const std
 
 LatencyMetric& MetricsRegistry::frameLatency() { return frameLatency_; }
 
+Histogram& MetricsRegistry::readBytes() { return readBytes_; }
+
+Histogram& MetricsRegistry::writeFrames() { return writeFrames_; }
+
+Histogram& MetricsRegistry::writeBytes() { return writeBytes_; }
+
+AcceptorStats& MetricsRegistry::acceptorStats(std::size_t idx) {
+    std::lock_guard<std::mutex> lock(acceptorMtx_);
+    while (acceptors_.size() <= idx) {
+        acceptors_.emplace_back();
+    }
+    return acceptors_[idx];
+}
+
 namespace {
     std::uint64_t nowMs() {
         auto now = std::chrono::steady_clock::now().time_since_epoch();
@@ -255,12 +421,37 @@ void MetricsRegistry::printSnapshot(std::ostream& os) const {
     os << "inflightRejects   = " << inflightRejects_.value() << "\n";
     os << "tokenRejects   = " << tokenRejects_.value() << "\n";
     os << "concurrentRejects   = " << concurrentRejects_.value() << "\n";
+    os << "limitQueue depth/timeouts/full = " << limitQueueDepth_.value() << "/" << limitQueueTimeouts_.value() << "/" << limitQueueFull_.value() << "\n";
     os << "sendQueueMaxBytes   = " << sendQueueMaxBytes_.value() << "\n";
     os << "workerQueueSize   = " << workerQueueSize_.value() << "\n";
     os << "workerLiveThreads   = " << workerLiveThreads_.value() << "\n";
+    os << "workerAutoTune target/waitP99Us/util%/cpu%/cpuUsage% = " << workerTargetThreads_.value() << "/" << workerQueueWaitP99Us_.value() << "/"
+       << workerUtilizationPct_.value() << "/" << workerCpuPct_.value() << "/" << workerCpuUsagePct_.value() << "\n";
+    os << "workerAutoTune up/down/held = " << workerScaleUps_.value() << "/" << workerScaleDowns_.value() << "/" << workerScaleHeld_.value() << "\n";
+    os << "workerIdle spinHits/parks = " << workerSpinHits_.value() << "/" << workerParks_.value() << "\n";
     os << "ipRejectConn   = " << ipRejectConn_.value() << "\n";
     os << "ipRejectQps    = " << ipRejectQps_.value() << "\n";
+    os << "ipStates tracked/expired = " << ipTrackedStates_.value() << "/" << ipStatesExpired_.value() << "\n";
+    os << "ipAclRejects   = " << ipAclRejects_.value() << "\n";
+    os << "zeroCopy sends/completed/fallbacks = " << zeroCopySends_.value() << "/" << zeroCopyCompleted_.value() << "/" << zeroCopyFallbacks_.value() << "\n";
+    {
+        std::lock_guard<std::mutex> lock(acceptorMtx_);
+        for (std::size_t i = 0; i < acceptors_.size(); ++i) {
+            const auto& a = acceptors_[i];
+            os << "acceptor[" << i << "] accepted=" << a.accepted.value() << " wakeups=" << a.wakeups.value() << " backlog=" << a.backlog.value() << "/"
+               << a.backlogMax.value() << "\n";
+        }
+    }
     frameLatency_.print("frameLatency", os);
+    readBytes_.print("readBytes", os);
+    writeFrames_.print("writeFrames", os);
+    writeBytes_.print("writeBytes", os);
+    limitQueueWaitMs_.print("limitQueueWaitMs", os);
+    static const char* kPriNames[3] = {"high", "normal", "low"};
+    for (int pri = 0; pri < 3; ++pri) {
+        workerTaskWaitUs_[pri].print(std::string("workerTaskWaitUs[") + kPriNames[pri] + "]", os);
+        workerTaskRunUs_[pri].print(std::string("workerTaskRunUs[") + kPriNames[pri] + "]", os);
+    }
     os << "====================================================================================================\n";
 }
 
@@ -365,7 +556,26 @@ void MetricsRegistry::printPrometheus(std::ostream& os) const {
     printMetric("server_send_queue_max_bytes", "gauge", sendQueueMaxBytes_.value(), emptyEx);
     printMetric("server_worker_queue_size", "gauge", workerQueueSize_.value(), emptyEx);
     printMetric("server_worker_live_threads", "gauge", workerLiveThreads_.value(), emptyEx);
+    printMetric("server_worker_autotune_target_threads", "gauge", workerTargetThreads_.value(), emptyEx);
+    printMetric("server_worker_autotune_queue_wait_p99_us", "gauge", workerQueueWaitP99Us_.value(), emptyEx);
+    printMetric("server_worker_autotune_utilization_pct", "gauge", workerUtilizationPct_.value(), emptyEx);
+    printMetric("server_worker_autotune_cpu_pct", "gauge", workerCpuPct_.value(), emptyEx);
+    printMetric("server_worker_autotune_cpu_usage_pct", "gauge", workerCpuUsagePct_.value(), emptyEx);
+    printMetric("server_worker_autotune_scale_up_total", "counter", workerScaleUps_.value(), emptyEx);
+    printMetric("server_worker_autotune_scale_down_total", "counter", workerScaleDowns_.value(), emptyEx);
+    printMetric("server_worker_autotune_scale_held_total", "counter", workerScaleHeld_.value(), emptyEx);
+    printMetric("server_worker_idle_spin_hits_total", "counter", workerSpinHits_.value(), emptyEx);
+    printMetric("server_worker_parks_total", "counter", workerParks_.value(), emptyEx);
     printMetric("server_inflight_frames", "gauge", inflightFrames_.value(), emptyEx);
+    printMetric("server_ip_limit_tracked_ips", "gauge", ipTrackedStates_.value(), emptyEx);
+    printMetric("server_ip_limit_expired_total", "counter", ipStatesExpired_.value(), emptyEx);
+    printMetric("server_ip_acl_rejects_total", "counter", ipAclRejects_.value(), emptyEx);
+    printMetric("server_msg_limit_queue_depth", "gauge", limitQueueDepth_.value(), emptyEx);
+    printMetric("server_msg_limit_queue_timeout_total", "counter", limitQueueTimeouts_.value(), emptyEx);
+    printMetric("server_msg_limit_queue_full_total", "counter", limitQueueFull_.value(), emptyEx);
+    printMetric("server_zerocopy_sends_total", "counter", zeroCopySends_.value(), emptyEx);
+    printMetric("server_zerocopy_completed_total", "counter", zeroCopyCompleted_.value(), emptyEx);
+    printMetric("server_zerocopy_fallback_total", "counter", zeroCopyFallbacks_.value(), emptyEx);
 
     // -----------------------------------------------------------------
     // 5. Map 和 Histogram 保持原样
@@ -387,6 +597,34 @@ void MetricsRegistry::printPrometheus(std::ostream& os) const {
         os << "\n";
     }
 
+    {
+        std::lock_guard<std::mutex> lock(acceptorMtx_);
+        if (!acceptors_.empty()) {
+            auto printAcceptor = [&](const char* name, const char* type, auto getter) {
+                os << "# TYPE " << name << " " << type << "\n";
+                for (std::size_t i = 0; i < acceptors_.size(); ++i) {
+                    os << name << "{acceptor=\"" << i << "\"} " << getter(acceptors_[i]) << "\n";
+                }
+            };
+            printAcceptor("server_acceptor_accepted_total", "counter", [](const AcceptorStats& a) { return a.accepted.value(); });
+            printAcceptor("server_acceptor_wakeups_total", "counter", [](const AcceptorStats& a) { return a.wakeups.value(); });
+            printAcceptor("server_acceptor_backlog", "gauge", [](const AcceptorStats& a) { return a.backlog.value(); });
+            printAcceptor("server_acceptor_backlog_limit", "gauge", [](const AcceptorStats& a) { return a.backlogMax.value(); });
+        }
+    }
+
+    readBytes_.printPrometheus("server_read_bytes", os);
+    writeFrames_.printPrometheus("server_write_frames", os);
+    writeBytes_.printPrometheus("server_write_bytes", os);
+    limitQueueWaitMs_.printPrometheus("server_msg_limit_queue_wait_ms", os);
+    static const char* kPriLabels[3] = {"prio=\"high\"", "prio=\"normal\"", "prio=\"low\""};
+    for (int pri = 0; pri < 3; ++pri) {
+        workerTaskWaitUs_[pri].printPrometheus("server_worker_task_wait_us", os, kPriLabels[pri], pri == 0);
+    }
+    for (int pri = 0; pri < 3; ++pri) {
+        workerTaskRunUs_[pri].printPrometheus("server_worker_task_run_us", os, kPriLabels[pri], pri == 0);
+    }
+
     frameLatency_.printPrometheus("server_frame_latency_ms", os);
     if (!frameTraceSnapshot.empty()) {
         os << "server_frame_latency_ms_sum " << frameMsSnapshot << " # {trace_id=\"" << frameTraceSnapshot << "\"";
@@ -0,0 +1,578 @@
+#include "TrafficAnalytics.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "Config.h"
+
+namespace {
+    std::uint64_t Mix(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    std::uint64_t HashIp(const IpKey& ip) { return Mix(ip.hi() * 0x9E3779B97F4A7C15ULL ^ ip.lo()); }
+
+    // 会话键：定长拷贝 sessionId（UUID 为 36 字符，更长的截断），哈希表里不再分配字符串
+    struct SessionKey {
+        std::array<char, 40> id{};
+        std::uint8_t len{0};
+
+        static SessionKey From(std::string_view s) {
+            SessionKey k;
+            k.len = static_cast<std::uint8_t>(std::min(s.size(), k.id.size()));
+            std::memcpy(k.id.data(), s.data(), k.len);
+            return k;
+        }
+        std::string toString() const { return std::string(id.data(), len); }
+        bool operator==(const SessionKey& other) const { return len == other.len && std::memcmp(id.data(), other.id.data(), len) == 0; }
+    };
+
+    // 按 8 字节一组混合（id 未用部分为 0），比逐字节的 FNV 短得多的依赖链
+    std::uint64_t HashSession(const SessionKey& key) {
+        std::uint64_t h = key.len;
+        for (std::size_t i = 0; i < key.id.size(); i += 8) {
+            std::uint64_t w;
+            std::memcpy(&w, key.id.data() + i, sizeof(w));
+            h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        return Mix(h);
+    }
+
+    struct KeyHash {
+        std::size_t operator()(const IpKey& k) const { return static_cast<std::size_t>(HashIp(k)); }
+        std::size_t operator()(const SessionKey& k) const { return static_cast<std::size_t>(HashSession(k)); }
+    };
+
+    std::string KeyText(const IpKey& k) { return k.toString(); }
+    std::string KeyText(const SessionKey& k) { return k.toString(); }
+
+    /**
+     * SpaceSaving（带 Count-Min 过滤）：最多监控 capacity 个键，count 为计数上界，count - error 为下界。
+     * 未监控的键真实计数总不超过最小计数 floor：新键到来时若其 Count-Min 估计（上界）不超过 floor，
+     * 顶替也只会得到同样的保证，直接跳过；否则按 SpaceSaving 顶替计数最小的键（继承 floor 作为误差）。
+     * 长尾键因此大多只付一次查表，不每次搬动堆。
+     * 键存放在位置固定的 entries_ 中；计数另组织成最小堆（堆元素只有计数与下标，调整时不搬动键），
+     * 再用线性探测的开放寻址表（槽数为容量的 2~4 倍，槽里带哈希低 32 位，探测与删除基本不用读 entries_）从键找到 entries_ 下标。
+     */
+    template <typename Key>
+    class SpaceSaving {
+      public:
+        struct Entry {
+            Key key;
+            std::uint64_t hash;
+            std::uint64_t error;
+            std::uint32_t heapPos;
+        };
+
+        explicit SpaceSaving(std::size_t capacity) : cap_(capacity) {
+            std::size_t n = std::bit_ceil(capacity * 2);
+            slots_.assign(n, Slot{});
+            mask_ = n - 1;
+            entries_.reserve(capacity);
+            heap_.reserve(capacity);
+        }
+
+        void clear() {
+            entries_.clear();
+            heap_.clear();
+            std::fill(slots_.begin(), slots_.end(), Slot{});
+        }
+
+        // w 为本次增量，estimate 为加上本次之后该键的 Count-Min 估计
+        void offer(const Key& key, std::uint64_t hash, std::uint64_t w, std::uint64_t estimate) {
+            std::size_t s = probe(key, hash);
+            if (slots_[s].idx != kEmpty) {
+                std::uint32_t pos = entries_[slots_[s].idx].heapPos;
+                heap_[pos].count += w;
+                siftDown(pos);
+                return;
+            }
+            if (entries_.size() < cap_) {
+                auto idx = static_cast<std::uint32_t>(entries_.size());
+                auto pos = static_cast<std::uint32_t>(heap_.size());
+                entries_.push_back(Entry{key, hash, 0, pos});
+                heap_.push_back(Node{w, idx});
+                slots_[s] = Slot{idx, static_cast<std::uint32_t>(hash)};
+                siftUp(pos);
+                return;
+            }
+            const std::uint64_t floor = heap_[0].count;
+            if (estimate <= floor) {
+                return;
+            }
+            // 顶替堆顶（计数最小）的键；删除旧键会移动探测链，新键的槽位要重新找
+            std::uint32_t idx = heap_[0].idx;
+            Entry& e = entries_[idx];
+            eraseSlot(probe(e.key, e.hash));
+            slots_[probe(key, hash)] = Slot{idx, static_cast<std::uint32_t>(hash)};
+            e.key = key;
+            e.hash = hash;
+            e.error = floor;
+            heap_[0].count = floor + w;
+            siftDown(0);
+        }
+
+        std::size_t size() const { return entries_.size(); }
+        const Entry& entry(std::size_t i) const { return entries_[i]; }
+        std::uint64_t count(std::size_t i) const { return heap_[entries_[i].heapPos].count; }
+        // 未监控的键的计数上界：满时为最小计数，未满时为 0
+        std::uint64_t floor() const { return entries_.size() < cap_ || heap_.empty() ? 0 : heap_[0].count; }
+
+      private:
+        static constexpr std::uint32_t kEmpty = 0xFFFFFFFFu;
+
+        struct Node {
+            std::uint64_t count;
+            std::uint32_t idx;  // entries_ 下标
+        };
+
+        struct Slot {
+            std::uint32_t idx{kEmpty};  // entries_ 下标，kEmpty 为空槽
+            std::uint32_t tag{0};       // 哈希低 32 位（理想槽位由它决定）
+        };
+
+        // 返回键所在的槽；不存在时返回探测链末尾的空槽
+        std::size_t probe(const Key& key, std::uint64_t hash) const {
+            const auto tag = static_cast<std::uint32_t>(hash);
+            std::size_t i = hash & mask_;
+            while (slots_[i].idx != kEmpty) {
+                if (slots_[i].tag == tag) {
+                    const Entry& e = entries_[slots_[i].idx];
+                    if (e.hash == hash && e.key == key) {
+                        break;
+                    }
+                }
+                i = (i + 1) & mask_;
+            }
+            return i;
+        }
+
+        // 线性探测的删除：把后续不在 (i, j] 理想区间内的元素前移，保持探测链连续
+        void eraseSlot(std::size_t i) {
+            std::size_t j = i;
+            while (true) {
+                j = (j + 1) & mask_;
+                if (slots_[j].idx == kEmpty) {
+                    break;
+                }
+                std::size_t k = slots_[j].tag & mask_;
+                bool inRange = i < j ? (k > i && k <= j) : (k > i || k <= j);
+                if (!inRange) {
+                    slots_[i] = slots_[j];
+                    i = j;
+                }
+            }
+            slots_[i] = Slot{};
+        }
+
+        void place(std::uint32_t pos, Node n) {
+            heap_[pos] = n;
+            entries_[n.idx].heapPos = pos;
+        }
+
+        void siftUp(std::uint32_t pos) {
+            Node n = heap_[pos];
+            while (pos > 0) {
+                std::uint32_t parent = (pos - 1) / 2;
+                if (heap_[parent].count <= n.count) {
+                    break;
+                }
+                place(pos, heap_[parent]);
+                pos = parent;
+            }
+            place(pos, n);
+        }
+
+        void siftDown(std::uint32_t pos) {
+            const auto size = static_cast<std::uint32_t>(heap_.size());
+            Node n = heap_[pos];
+            while (true) {
+                std::uint32_t child = pos * 2 + 1;
+                if (child >= size) {
+                    break;
+                }
+                if (child + 1 < size && heap_[child + 1].count < heap_[child].count) {
+                    ++child;
+                }
+                if (n.count <= heap_[child].count) {
+                    break;
+                }
+                place(pos, heap_[child]);
+                pos = child;
+            }
+            place(pos, n);
+        }
+
+        std::size_t cap_;
+        std::size_t mask_{0};
+        std::vector<Entry> entries_;
+        std::vector<Node> heap_;
+        std::vector<Slot> slots_;
+    };
+
+    // Count-Min：depth 行、每行 width 个格子，每格同时记帧数与字节数；估计值取各行最小，只会高估
+    class CountMin {
+      public:
+        static constexpr std::size_t kDepth = 4;
+        static constexpr std::size_t kWidth = 1024;
+
+        CountMin() : cells_(kDepth * kWidth) {}
+
+        void clear() { std::fill(cells_.begin(), cells_.end(), Cell{}); }
+
+        struct Estimate {
+            std::uint64_t frames;
+            std::uint64_t bytes;
+        };
+
+        // 累加并返回累加后的估计值
+        Estimate add(std::uint64_t hash, std::uint64_t frames, std::uint64_t bytes) {
+            Estimate est{UINT64_MAX, UINT64_MAX};
+            for (std::size_t row = 0; row < kDepth; ++row) {
+                Cell& c = cells_[index(hash, row)];
+                c.frames += frames;
+                c.bytes += bytes;
+                est.frames = std::min(est.frames, c.frames);
+                est.bytes = std::min(est.bytes, c.bytes);
+            }
+            return est;
+        }
+
+        std::uint64_t estimate(std::uint64_t hash, bool bytes) const {
+            std::uint64_t best = UINT64_MAX;
+            for (std::size_t row = 0; row < kDepth; ++row) {
+                const Cell& c = cells_[index(hash, row)];
+                best = std::min(best, bytes ? c.bytes : c.frames);
+            }
+            return best;
+        }
+
+        void merge(const CountMin& other) {
+            for (std::size_t i = 0; i < cells_.size(); ++i) {
+                cells_[i].frames += other.cells_[i].frames;
+                cells_[i].bytes += other.cells_[i].bytes;
+            }
+        }
+
+      private:
+        struct Cell {
+            std::uint64_t frames{0};
+            std::uint64_t bytes{0};
+        };
+
+        // 由一个 64 位哈希派生各行的列号（h1 + row * h2）
+        static std::size_t index(std::uint64_t hash, std::size_t row) {
+            auto h1 = static_cast<std::uint32_t>(hash);
+            auto h2 = static_cast<std::uint32_t>(hash >> 32) | 1u;
+            return row * kWidth + ((h1 + row * h2) & (kWidth - 1));
+        }
+
+        std::vector<Cell> cells_;
+    };
+
+    // HyperLogLog：哈希高 p 位选寄存器，其余位的前导零个数 + 1 取最大值
+    class HyperLogLog {
+      public:
+        explicit HyperLogLog(std::uint32_t precision) : p_(precision), regs_(std::size_t{1} << precision, 0) {}
+
+        void clear() { std::fill(regs_.begin(), regs_.end(), 0); }
+
+        void add(std::uint64_t hash) {
+            std::size_t idx = hash >> (64 - p_);
+            std::uint64_t rest = (hash << p_) | (std::uint64_t{1} << (p_ - 1));
+            auto rank = static_cast<std::uint8_t>(std::countl_zero(rest) + 1);
+            if (rank > regs_[idx]) {
+                regs_[idx] = rank;
+            }
+        }
+
+        void merge(const HyperLogLog& other) {
+            for (std::size_t i = 0; i < regs_.size(); ++i) {
+                regs_[i] = std::max(regs_[i], other.regs_[i]);
+            }
+        }
+
+        std::uint64_t estimate() const {
+            const double m = static_cast<double>(regs_.size());
+            double sum = 0.0;
+            std::size_t zeros = 0;
+            for (auto r : regs_) {
+                sum += std::ldexp(1.0, -static_cast<int>(r));
+                zeros += r == 0;
+            }
+            double alpha = 0.7213 / (1.0 + 1.079 / m);
+            double e = alpha * m * m / sum;
+            // 小基数时用线性计数修正
+            if (e <= 2.5 * m && zeros > 0) {
+                e = m * std::log(m / static_cast<double>(zeros));
+            }
+            return static_cast<std::uint64_t>(e + 0.5);
+        }
+
+      private:
+        std::uint32_t p_;
+        std::vector<std::uint8_t> regs_;
+    };
+
+    // 一个维度（源 IP 或会话）的全部草图
+    template <typename Key>
+    struct Dimension {
+        SpaceSaving<Key> byFrames;
+        SpaceSaving<Key> byBytes;
+        CountMin cm;
+        HyperLogLog hll;
+
+        Dimension(std::size_t capacity, std::uint32_t precision) : byFrames(capacity), byBytes(capacity), hll(precision) {}
+
+        void clear() {
+            byFrames.clear();
+            byBytes.clear();
+            cm.clear();
+            hll.clear();
+        }
+
+        void add(const Key& key, std::uint64_t hash, std::uint64_t frames, std::uint64_t bytes) {
+            auto est = cm.add(hash, frames, bytes);
+            byFrames.offer(key, hash, frames, est.frames);
+            byBytes.offer(key, hash, bytes, est.bytes);
+            hll.add(hash);
+        }
+    };
+
+    struct Window {
+        std::int64_t minute{-1};
+        std::uint64_t frames{0};
+        std::uint64_t bytes{0};
+        Dimension<IpKey> ips;
+        Dimension<SessionKey> sessions;
+
+        Window(std::size_t capacity, std::uint32_t precision) : ips(capacity, precision), sessions(capacity, precision) {}
+
+        void reset(std::int64_t m) {
+            minute = m;
+            frames = 0;
+            bytes = 0;
+            ips.clear();
+            sessions.clear();
+        }
+    };
+
+    // 合并各线程同一窗口的 SpaceSaving：出现的线程累加其计数，未出现的线程按其 floor 计入上界；
+    // 上界再与合并后的 Count-Min 估计取小
+    template <typename Key>
+    std::vector<TrafficAnalytics::HeavyHitter> MergeTopK(const std::vector<const SpaceSaving<Key>*>& parts, const CountMin& cm, bool bytes,
+                                                         std::size_t k) {
+        struct Agg {
+            std::uint64_t hash{0};
+            std::uint64_t upper{0};
+            std::uint64_t lower{0};
+            std::uint64_t floorSeen{0};  // 已出现的线程的 floor 之和
+        };
+        std::unordered_map<Key, Agg, KeyHash> merged;
+        std::uint64_t floorTotal = 0;
+        for (const auto* part : parts) {
+            std::uint64_t f = part->floor();
+            floorTotal += f;
+            for (std::size_t i = 0; i < part->size(); ++i) {
+                const auto& e = part->entry(i);
+                std::uint64_t c = part->count(i);
+                auto& a = merged[e.key];
+                a.hash = e.hash;
+                a.upper += c;
+                a.lower += c - e.error;
+                a.floorSeen += f;
+            }
+        }
+
+        std::vector<TrafficAnalytics::HeavyHitter> out;
+        out.reserve(merged.size());
+        for (const auto& [key, a] : merged) {
+            std::uint64_t upper = std::min(a.upper + (floorTotal - a.floorSeen), cm.estimate(a.hash, bytes));
+            out.push_back({KeyText(key), upper, std::min(a.lower, upper)});
+        }
+        auto byEstimate = [](const auto& x, const auto& y) { return x.estimate != y.estimate ? x.estimate > y.estimate : x.key < y.key; };
+        if (out.size() > k) {
+            std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(k), out.end(), byEstimate);
+            out.resize(k);
+        } else {
+            std::sort(out.begin(), out.end(), byEstimate);
+        }
+        return out;
+    }
+
+    void PrintHitters(std::ostream& os, const char* title, const std::vector<TrafficAnalytics::HeavyHitter>& list) {
+        os << "  " << title << ":\n";
+        for (const auto& h : list) {
+            os << "    " << h.key << " ~" << h.estimate << " (>=" << h.lowerBound << ")\n";
+        }
+    }
+}  // namespace
+
+struct TrafficAnalytics::Local {
+    std::mutex mtx;
+    Window cur;
+    Window prev;
+
+    Local(std::size_t capacity, std::uint32_t precision) : cur(capacity, precision), prev(capacity, precision) {}
+};
+
+TrafficAnalytics::TrafficAnalytics() = default;
+TrafficAnalytics::~TrafficAnalytics() = default;
+
+TrafficAnalytics& TrafficAnalytics::Instance() {
+    static TrafficAnalytics inst;
+    return inst;
+}
+
+void TrafficAnalytics::configure(const AnalyticsConfig& cfg) {
+    std::lock_guard<std::mutex> lock(regMtx_);
+    enabled_.store(cfg.enabled, std::memory_order_relaxed);
+    topK_ = cfg.topK;
+    capacity_ = cfg.capacity;
+    hllPrecision_ = cfg.hllPrecision;
+}
+
+TrafficAnalytics::Local& TrafficAnalytics::local() {
+    // 单例专用的线程局部指针：线程首次记录时登记一份草图，生命周期跟随单例
+    static thread_local Local* tl = nullptr;
+    if (tl == nullptr) {
+        std::lock_guard<std::mutex> lock(regMtx_);
+        locals_.push_back(std::make_unique<Local>(capacity_, hllPrecision_));
+        tl = locals_.back().get();
+    }
+    return *tl;
+}
+
+std::int64_t TrafficAnalytics::MinuteNow() {
+    using namespace std::chrono;
+    return duration_cast<minutes>(system_clock::now().time_since_epoch()).count();
+}
+
+void TrafficAnalytics::record(const std::optional<IpKey>& ip, std::string_view session, std::uint32_t frames, std::uint64_t bytes) {
+    if (!enabled()) {
+        return;
+    }
+    recordAt(MinuteNow(), ip, session, frames, bytes);
+}
+
+void TrafficAnalytics::recordAt(std::int64_t minute, const std::optional<IpKey>& ip, std::string_view session, std::uint32_t frames,
+                                std::uint64_t bytes) {
+    if (!enabled()) {
+        return;
+    }
+    Local& l = local();
+    std::lock_guard<std::mutex> lock(l.mtx);
+
+    // 进入新的一分钟：相邻则当前窗口降为上一窗口，否则两个窗口都清空
+    if (minute > l.cur.minute) {
+        if (minute == l.cur.minute + 1) {
+            std::swap(l.cur, l.prev);
+        } else {
+            l.prev.reset(minute - 1);
+        }
+        l.cur.reset(minute);
+    }
+    Window* w = minute == l.cur.minute ? &l.cur : (minute == l.prev.minute ? &l.prev : nullptr);
+    if (w == nullptr) {
+        return;  // 早于上一分钟（时钟回拨）的数据直接丢弃
+    }
+
+    w->frames += frames;
+    w->bytes += bytes;
+    if (ip) {
+        w->ips.add(*ip, HashIp(*ip), frames, bytes);
+    }
+    if (!session.empty()) {
+        auto key = SessionKey::From(session);
+        w->sessions.add(key, HashSession(key), frames, bytes);
+    }
+}
+
+TrafficAnalytics::WindowReport TrafficAnalytics::report(std::int64_t minute) const {
+    WindowReport r;
+    r.minute = minute;
+
+    // 持锁只做拷贝，合并在锁外进行，不拖慢 I/O 线程
+    std::vector<Window> windows;
+    std::size_t topK = 0;
+    {
+        std::lock_guard<std::mutex> reg(regMtx_);
+        topK = topK_;
+        for (const auto& l : locals_) {
+            std::lock_guard<std::mutex> lock(l->mtx);
+            if (l->cur.minute == minute) {
+                windows.push_back(l->cur);
+            } else if (l->prev.minute == minute) {
+                windows.push_back(l->prev);
+            }
+        }
+    }
+    if (windows.empty()) {
+        return r;
+    }
+
+    CountMin ipCm;
+    CountMin sessionCm;
+    HyperLogLog ipHll = windows.front().ips.hll;
+    HyperLogLog sessionHll = windows.front().sessions.hll;
+    std::vector<const SpaceSaving<IpKey>*> ipFrames, ipBytes;
+    std::vector<const SpaceSaving<SessionKey>*> sessFrames, sessBytes;
+    for (const auto& w : windows) {
+        r.frames += w.frames;
+        r.bytes += w.bytes;
+        ipCm.merge(w.ips.cm);
+        sessionCm.merge(w.sessions.cm);
+        ipHll.merge(w.ips.hll);
+        sessionHll.merge(w.sessions.hll);
+        ipFrames.push_back(&w.ips.byFrames);
+        ipBytes.push_back(&w.ips.byBytes);
+        sessFrames.push_back(&w.sessions.byFrames);
+        sessBytes.push_back(&w.sessions.byBytes);
+    }
+    r.uniqueIps = ipHll.estimate();
+    r.uniqueSessions = sessionHll.estimate();
+    r.ipsByFrames = MergeTopK(ipFrames, ipCm, false, topK);
+    r.ipsByBytes = MergeTopK(ipBytes, ipCm, true, topK);
+    r.sessionsByFrames = MergeTopK(sessFrames, sessionCm, false, topK);
+    r.sessionsByBytes = MergeTopK(sessBytes, sessionCm, true, topK);
+    return r;
+}
+
+void TrafficAnalytics::print(std::ostream& os) const {
+    if (!enabled()) {
+        os << "traffic analytics disabled\n";
+        return;
+    }
+    const std::int64_t now = MinuteNow();
+    for (std::int64_t minute : {now, now - 1}) {
+        auto r = report(minute);
+        os << (minute == now ? "current" : "previous") << " minute=" << minute << " frames=" << r.frames << " bytes=" << r.bytes
+           << " uniqueIps~" << r.uniqueIps << " uniqueSessions~" << r.uniqueSessions << "\n";
+        PrintHitters(os, "top ips by frames", r.ipsByFrames);
+        PrintHitters(os, "top ips by bytes", r.ipsByBytes);
+        PrintHitters(os, "top sessions by frames", r.sessionsByFrames);
+        PrintHitters(os, "top sessions by bytes", r.sessionsByBytes);
+    }
+}
+
+void TrafficAnalytics::printPrometheus(std::ostream& os) const {
+    if (!enabled()) {
+        return;
+    }
+    auto r = report(MinuteNow() - 1);
+    os << "# TYPE server_traffic_unique_ips gauge\n";
+    os << "server_traffic_unique_ips " << r.uniqueIps << "\n\n";
+    os << "# TYPE server_traffic_unique_sessions gauge\n";
+    os << "server_traffic_unique_sessions " << r.uniqueSessions << "\n\n";
+}
@@ -4,50 +4,52 @@
 
 #include "Codec.h"
 #include "Metrics.h"
+#include "MiddlewarePipeline.h"
 
-CoMiddleware BuildBackpressureMiddleware(const Config& cfg) {
-    const auto& bpCfg = cfg.backpressure();
-    if (!(bpCfg.rejectLowPriority && !bpCfg.lowPriorityMsgTypes.empty())) {
-        return {};
-    }
+BackpressureStage::BackpressureStage(const BackpressureConfig& cfg)
+    : enabled_(cfg.rejectLowPriority && !cfg.lowPriorityMsgTypes.empty()), lowPri_(cfg.lowPriorityMsgTypes), allow_(cfg.alwaysAllowMsgTypes), globalThreshold_(cfg.globalThreshold) {}
 
-    auto lowPri = bpCfg.lowPriorityMsgTypes;
-    auto allow = bpCfg.alwaysAllowMsgTypes;
-    std::size_t globalThreshold = bpCfg.globalThreshold;
+bool BackpressureStage::enter(MessageContext& ctx) const {
+    if (!enabled_) {
+        return true;
+    }
+    // 获取全局以及连接背压情况
+    bool isSelfCongested = ctx.conn && ctx.conn->isReadPaused();
+    bool isGlobalPanic = false;
 
-    return [lowPri = std::move(lowPri), allow = std::move(allow), globalThreshold](std::shared_ptr<MessageContext> ctx, CoNextFunc next) -> boost::asio::awaitable<void> {
-        // 获取全局以及连接背压情况
-        bool isSelfCongested = ctx->conn && ctx->conn->isReadPaused();
-        bool isGlobalPanic = false;
+    if (!isSelfCongested) {
+        auto globalBp = MetricsRegistry::Instance().backpressureActive().value();
+        isGlobalPanic = (globalBp > globalThreshold_);
+    }
 
-        if (!isSelfCongested) {
-            auto globalBp = MetricsRegistry::Instance().backpressureActive().value();
-            isGlobalPanic = (globalBp > globalThreshold);
+    if (isSelfCongested || isGlobalPanic) {
+        // 白名单检查
+        if (!allow_.empty() && allow_.find(ctx.msgType) != allow_.end()) {
+            return true;
         }
-
-        if (isSelfCongested || isGlobalPanic) {
-            // 白名单检查
-            if (!allow.empty() && allow.find(ctx->msgType) != allow.end()) {
-                co_await next(ctx);
-                co_return;
-            }
-            if (lowPri.find(ctx->msgType) != lowPri.end()) {
-                MetricsRegistry::Instance().backpressureDroppedLowPri().inc();
-                MetricsRegistry::Instance().droppedFrames().inc();
-                MetricsRegistry::Instance().incMsgReject(ctx->msgType);
-                MetricsRegistry::Instance().setBackpressureDropTrace(ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "");
-                MetricsRegistry::Instance().setMsgRejectTrace(ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "", ctx->msgType);
-
-                // 日志采样
-                static thread_local uint64_t s_dropCount = 0;
-                if (++s_dropCount % 10000 == 0) {
-                    SPDLOG_WARN("[Backpressure] Dropping low-pri (sampled): type={} selfPaused={} globalPanic={} trace={} sess={}", ctx->msgType,
-                                isSelfCongested, isGlobalPanic, ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
-                }
-                co_return;
+        if (lowPri_.find(ctx.msgType) != lowPri_.end()) {
+            MetricsRegistry::Instance().backpressureDroppedLowPri().inc();
+            MetricsRegistry::Instance().droppedFrames().inc();
+            MetricsRegistry::Instance().incMsgReject(ctx.msgType);
+            MetricsRegistry::Instance().setBackpressureDropTrace(ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "");
+            MetricsRegistry::Instance().setMsgRejectTrace(ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "", ctx.msgType);
+
+            // 日志采样
+            static thread_local uint64_t s_dropCount = 0;
+            if (++s_dropCount % 10000 == 0) {
+                SPDLOG_WARN("[Backpressure] Dropping low-pri (sampled): type={} selfPaused={} globalPanic={} trace={} sess={}", ctx.msgType, isSelfCongested,
+                            isGlobalPanic, ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "nil");
             }
+            return false;
         }
-        co_await next(ctx);
-        co_return;
-    };
+    }
+    return true;
+}
+
+CoMiddleware BuildBackpressureMiddleware(const Config& cfg) {
+    BackpressureStage stage(cfg.backpressure());
+    if (!stage.enabled()) {
+        return {};
+    }
+    return MakeStageMiddleware(std::move(stage));
 }
@@ -2,15 +2,21 @@
 
 #include <spdlog/spdlog.h>
 
+#include "MiddlewarePipeline.h"
+
+LoggingStage::LoggingStage(const LogConfig& cfg) : enabled_(cfg.level == "debug" || cfg.level == "trace") {}
+
+bool LoggingStage::enter(MessageContext& ctx) const {
+    if (enabled_) {
+        SPDLOG_DEBUG("recv msgType={} bodySize={}", ctx.msgType, ctx.body.size());
+    }
+    return true;
+}
+
 CoMiddleware BuildLoggingMiddleware(const Config& cfg) {
-    const auto& logCfg = cfg.log();
-    bool debugLogEnabled = (logCfg.level == "debug" || logCfg.level == "trace");
-    if (!debugLogEnabled) {
+    LoggingStage stage(cfg.log());
+    if (!stage.enabled()) {
         return {};
     }
-    return [](std::shared_ptr<MessageContext> ctx, CoNextFunc next) -> boost::asio::awaitable<void> {
-        SPDLOG_DEBUG("recv msgType={} bodySize={}", ctx->msgType, ctx->body ? ctx->body->size() : 0);
-        co_await next(ctx);
-        co_return;
-    };
+    return MakeStageMiddleware(std::move(stage));
 }
@@ -5,29 +5,47 @@
 #include "Codec.h"
 #include "Metrics.h"
 
+RateLimitStage::RateLimitStage(std::shared_ptr<MessageLimiter> limiter) : limiter_(std::move(limiter)) {}
+
+Admission RateLimitStage::enter(MessageContext& ctx) const {
+    switch (limiter_->admit(ctx.msgType)) {
+        case MessageLimiter::Verdict::Accept:
+            // 通过的才占用并发，leave 时归还
+            return Admission::Pass;
+        case MessageLimiter::Verdict::Queue:
+            return Admission::Wait;
+        case MessageLimiter::Verdict::Reject:
+            break;
+    }
+    onReject(ctx);
+    return Admission::Reject;
+}
+
+boost::asio::awaitable<bool> RateLimitStage::wait(MessageContext& ctx) const {
+    if (co_await limiter_->waitForSlot(ctx.msgType)) {
+        co_return true;
+    }
+    onReject(ctx);
+    co_return false;
+}
+
+void RateLimitStage::onReject(const MessageContext& ctx) {
+    std::uint16_t t = ctx.msgType;
+    MetricsRegistry::Instance().totalErrors().inc();
+    MetricsRegistry::Instance().incMsgReject(t);
+    MetricsRegistry::Instance().setMsgRejectTrace(ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "", t);
+    MetricsRegistry::Instance().setTokenRejectTrace(ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "");
+
+    // 日志采样
+    static thread_local uint64_t s_limitCount = 0;
+    if (++s_limitCount % 10000 == 0) {
+        SPDLOG_WARN("[RateLimit] Dropped (sampled): type={} trace={} sess={}", t, ctx.traceId, ctx.conn ? ctx.conn->sessionId() : "nil");
+    }
+}
+
+void RateLimitStage::leave(MessageContext& ctx) const { limiter_->onFinish(ctx.msgType); }
+
 CoMiddleware BuildRateLimitMiddleware(const Config& cfg, std::shared_ptr<MessageLimiter> limiter) {
     limiter->updateFromConfig(cfg);
-    return [limiter](std::shared_ptr<MessageContext> ctx, CoNextFunc next) -> boost::asio::awaitable<void> {
-        std::uint16_t t = ctx->msgType;
-        if (!limiter->allow(t)) {
-            MetricsRegistry::Instance().totalErrors().inc();
-            MetricsRegistry::Instance().incMsgReject(t);
-            MetricsRegistry::Instance().setMsgRejectTrace(ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "", t);
-            MetricsRegistry::Instance().setTokenRejectTrace(ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "");
-
-            // 日志采样
-            static thread_local uint64_t s_limitCount = 0;
-            if (++s_limitCount % 10000 == 0) {
-                SPDLOG_WARN("[RateLimit] Dropped (sampled): type={} trace={} sess={}", t, ctx->traceId, ctx->conn ? ctx->conn->sessionId() : "nil");
-            }
-
-            co_return;
-        }
-
-        //通过的才占用并发，处理完归还
-        std::shared_ptr<void> concurrencyGuard(nullptr, [limiter, t](void*) { limiter->onFinish(t); });
-
-        co_await next(ctx);
-        co_return;
-    };
+    return MakeStageMiddleware(RateLimitStage(std::move(limiter)));
 }
@@ -8,6 +8,8 @@ size_t Buffer::writableBytes() const { return buffer_.size() - writePos_; }
 
 size_t Buffer::prependableBytes() const { return readPos_; }
 
+size_t Buffer::capacity() const { return buffer_.size(); }
+
 const char* Buffer::peek() const { return buffer_.data() + readPos_; }
 
 char* Buffer::beginWrite() { return buffer_.data() + writePos_; }
@@ -55,7 +57,7 @@ void Buffer::hasWritten(size_t len) { writePos_ += len; }
 
 void Buffer::shrinkToFit() {
     if (readableBytes() == 0) {
-        buffer_.assign(0, 0);
+        std::vector<char>().swap(buffer_);  // assign(0) 不会归还 vector 的容量
         readPos_ = 0;
         writePos_ = 0;
         return;
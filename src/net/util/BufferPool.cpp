@@ -80,13 +80,10 @@ void BufferPool::release(Buffer* buf) {
     }
     // 连接层应保证放回前完成读取，这里统一复位
     buf->retrieveAll();
-    if (shrinkThreshold_ > 0) {
-        // 通过一次“完全拷贝可读区”的方式 shrink（你之前的 Buffer 实现已提供）
-        // 由于我们刚 retrieveAll()，这里一般 no-op；目的是处理“被扩容得很大”的情况
-        // 如果你改 Buffer 支持直接检查/获取 capacity，则可更精准地决定是否 shrink。
-        // 为了稳妥，我们在这里仅在 retrieveAll() 后跳过 shrink，避免额外分配。
-        // 如果你想强制收缩大 Buffer，可以解除下行注释：
-        // buf->shrinkToFit();
+    if (shrinkThreshold_ > 0 && buf->capacity() > shrinkThreshold_) {
+        // 被大帧撑大的 Buffer 不原样缓存，收缩回默认容量再入池
+        buf->shrinkToFit();
+        buf->ensureWritableBytes(defaultCapacity_);
     }
 
     // 先尝试放入线程本地缓存（无锁）
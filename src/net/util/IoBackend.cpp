@@ -0,0 +1,126 @@
+#include "IoBackend.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // 防止两个二进制之间来回 exec
+    constexpr const char* kExecGuardEnv = "DOMAIN_IO_BACKEND_EXEC";
+
+    bool compiledWithIoUring() {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // 兄弟二进制路径：配置优先，否则与当前可执行文件同目录
+    std::string siblingPath(const std::string& configured, const char* defaultName) {
+        if (!configured.empty()) {
+            return configured;
+        }
+#ifdef __linux__
+        char self[4096];
+        ssize_t n = ::readlink("/proc/self/exe", self, sizeof(self) - 1);
+        if (n > 0) {
+            self[n] = '\0';
+            std::string dir(self);
+            auto pos = dir.find_last_of('/');
+            if (pos != std::string::npos) {
+                return dir.substr(0, pos + 1) + defaultName;
+            }
+        }
+#endif
+        return defaultName;
+    }
+
+    // exec 成功不返回；失败返回 false
+    bool execSibling(const std::string& path, char** argv) {
+#ifdef __linux__
+        if (std::getenv(kExecGuardEnv) != nullptr) {
+            SPDLOG_ERROR("[IoBackend] already switched backend once, refuse to exec {}", path);
+            return false;
+        }
+        if (::access(path.c_str(), X_OK) != 0) {
+            return false;
+        }
+        ::setenv(kExecGuardEnv, "1", 1);
+        SPDLOG_WARN("[IoBackend] exec {} to switch backend", path);
+        spdlog::shutdown();  // exec 前刷掉异步日志
+        ::execv(path.c_str(), argv);
+        ::unsetenv(kExecGuardEnv);
+        SPDLOG_ERROR("[IoBackend] exec {} failed: {}", path, std::strerror(errno));
+#else
+        (void) path;
+        (void) argv;
+#endif
+        return false;
+    }
+}  // namespace
+
+namespace IoBackend {
+    const char* compiled() { return compiledWithIoUring() ? "io_uring" : "epoll"; }
+
+    bool kernelSupportsIoUring() {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+        struct io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        long fd = ::syscall(__NR_io_uring_setup, 4, &params);
+        if (fd < 0) {
+            return false;
+        }
+        ::close(static_cast<int>(fd));
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool select(const ServerConfig& sc, char** argv) {
+        bool wantUring = (sc.ioBackend == "io_uring");
+        bool haveUring = compiledWithIoUring();
+
+        if (haveUring) {
+            if (kernelSupportsIoUring() && wantUring) {
+                SPDLOG_INFO("[IoBackend] using io_uring");
+                return true;
+            }
+            // io_uring 构建：内核不支持或配置要求 epoll，都必须换到 epoll 构建（本进程无法创建 io_context）
+            if (!wantUring) {
+                SPDLOG_INFO("[IoBackend] config asks for epoll, switching from io_uring build");
+            } else {
+                SPDLOG_WARN("[IoBackend] kernel lacks io_uring support, falling back to epoll build");
+            }
+            if (execSibling(siblingPath(sc.epollBinary, "domain"), argv)) {
+                return true;
+            }
+            if (!kernelSupportsIoUring()) {
+                SPDLOG_CRITICAL("[IoBackend] no usable epoll binary found (server.epollBinary), cannot start");
+                return false;
+            }
+            SPDLOG_WARN("[IoBackend] epoll binary not found, keep running on io_uring");
+            return true;
+        }
+
+        if (wantUring) {
+            if (kernelSupportsIoUring() && execSibling(siblingPath(sc.ioUringBinary, "domain_uring"), argv)) {
+                return true;
+            }
+            SPDLOG_WARN("[IoBackend] io_uring requested but unavailable (kernel support={}, build with -DDOMAIN_IO_URING=ON), using epoll",
+                        kernelSupportsIoUring());
+        }
+        SPDLOG_INFO("[IoBackend] using epoll");
+        return true;
+    }
+}  // namespace IoBackend
@@ -3,6 +3,50 @@
 #include "Metrics.h"
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <pthread.h>
+
+namespace {
+    // 当前线程所属的池与槽位：池内线程提交的任务直接进自己的本地队列
+    thread_local ThreadPool* tlPool = nullptr;
+    thread_local std::size_t tlSlot = 0;
+    thread_local ThreadPool* tlInlineEntry = nullptr;  // InlineEntry 登记、尚未被取走的就地执行名额
+
+    // 窃取起点用的线程私有 xorshift，避免所有空闲线程按同一顺序扫描
+    std::size_t nextRandom() {
+        thread_local std::uint32_t state = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // 自旋等待时让出流水线/超线程资源
+    inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    std::int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 自动伸缩的利用率阈值（利用率 = 执行任务的时间 / (周期 × 线程数)）
+    constexpr double kBusyUtil = 0.6;    // 等待超标且高于它：线程是瓶颈，扩容有用
+    constexpr double kIdleUtil = 0.5;    // 等待远低于目标且低于它：缩容
+    constexpr double kTargetUtil = 0.7;  // 缩容后期望的利用率，与 kBusyUtil 之间留出回差
+    constexpr double kCpuBound = 0.8;    // 执行时间里 CPU 时间占比高于它视为计算密集
+    // 每次调整后观察几个周期再做决定，等新线程数的效果体现出来
+    constexpr int kCooldownTicks = 2;
+    constexpr std::uint32_t kPureSpinIters = 1024;  // 空闲自旋中纯 pause 的轮数（约数微秒），之后边转边 yield
+}  // namespace
+
 ThreadPool::ThreadPool(std::size_t numThreads, std::size_t maxQueueSize, std::size_t minThreads, std::size_t maxThreads)
     : stopping_(false),
       maxQueueSize_(maxQueueSize),
@@ -21,8 +65,17 @@ ThreadPool::ThreadPool(std::size_t numThreads, std::size_t maxQueueSize, std::si
     if (targetThreads_ > maxThreads_)
         targetThreads_ = maxThreads_;
 
+    // 槽位按线程数上限一次建好，之后只标记占用，窃取时无需加锁遍历
+    const std::size_t slots = std::max<std::size_t>({numThreads, maxThreads_, 1});
+    slots_.reserve(slots);
+    for (std::size_t i = 0; i < slots; ++i) {
+        slots_.push_back(std::make_unique<Worker>());
+    }
+    activeSlots_ = std::vector<std::atomic<std::size_t>>(slots);
+
+    std::lock_guard<std::mutex> lock(mutex_);
     for (size_t i = 0; i < numThreads; ++i) {
-        workers_.emplace_back(&ThreadPool::workerLoop, this);
+        startWorkerLocked();
     }
 }
 
@@ -37,6 +90,7 @@ void ThreadPool::shutdown() {
         stopping_ = true;
         autoTune_ = false;
     }
+    cvAdjust_.notify_all();
     if (adjustThread_.joinable()) {
         adjustThread_.join();
     }
@@ -48,28 +102,78 @@ void ThreadPool::shutdown() {
     workers_.clear();
 }
 
-std::size_t ThreadPool::maxQueueSize() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return maxQueueSize_;
-}
+std::size_t ThreadPool::maxQueueSize() const { return maxQueueSize_.load(std::memory_order_relaxed); }
 
-void ThreadPool::setMxQueueSize(std::size_t n) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    maxQueueSize_ = n;
-}
+void ThreadPool::setMxQueueSize(std::size_t n) { maxQueueSize_.store(n, std::memory_order_relaxed); }
 
-std::size_t ThreadPool::queueSize() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return totalQueueSize_;
-}
+std::size_t ThreadPool::queueSize() const { return totalQueueSize_.load(std::memory_order_relaxed); }
 
 std::size_t ThreadPool::workerCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return targetThreads_;
 }
 
+bool ThreadPool::runningInThisThread() const noexcept { return tlPool == this; }
+
+ThreadPool::InlineEntry::InlineEntry(ThreadPool& pool) noexcept : prev_(tlInlineEntry) {
+    if (tlPool == &pool) {
+        tlInlineEntry = &pool;
+    }
+}
+
+ThreadPool::InlineEntry::~InlineEntry() { tlInlineEntry = prev_; }
+
+bool ThreadPool::takeInlineEntry() noexcept {
+    if (tlInlineEntry != this) {
+        return false;
+    }
+    tlInlineEntry = nullptr;
+    return true;
+}
+
 std::size_t ThreadPool::liveWorkerCount() const { return liveWorkers_.load(std::memory_order_relaxed); }
 
+std::size_t ThreadPool::claimSlotLocked() {
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        if (!slots_[i]->active) {
+            slots_[i]->active = true;
+            std::size_t n = activeCount_.load(std::memory_order_relaxed);
+            activeSlots_[n].store(i, std::memory_order_relaxed);
+            activeCount_.store(n + 1, std::memory_order_release);
+            return i;
+        }
+    }
+    return slots_.size();
+}
+
+void ThreadPool::releaseSlotLocked(std::size_t slot) {
+    slots_[slot]->active = false;
+    // 用最后一项填补空位：并发读到旧内容的提交者拿到的仍是合法槽位，最坏落在刚退出的槽上等待窃取
+    std::size_t n = activeCount_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (activeSlots_[i].load(std::memory_order_relaxed) == slot) {
+            activeSlots_[i].store(activeSlots_[n - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            activeCount_.store(n - 1, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void ThreadPool::startWorkerLocked() {
+    std::size_t slot = claimSlotLocked();
+    if (slot == slots_.size()) {
+        // 退出中的线程尚未让出槽位，不应发生（resize 会先抵消待退出数）
+        SPDLOG_WARN("ThreadPool no free worker slot, skip starting a worker");
+        return;
+    }
+    workers_.emplace_back(&ThreadPool::workerLoop, this, slot);
+    Worker& w = *slots_[slot];
+    ++w.generation;
+    if (pthread_getcpuclockid(workers_.back().native_handle(), &w.cpuClock) != 0) {
+        w.cpuClock = CLOCK_THREAD_CPUTIME_ID;  // 取不到时该槽位不参与 CPU 采样（见 sampleCpuNs）
+    }
+}
+
 void ThreadPool::resize(std::size_t newCount) {
     std::unique_lock<std::mutex> lock(mutex_);
     if (stopping_)
@@ -87,15 +191,21 @@ void ThreadPool::resize(std::size_t newCount) {
         std::size_t add = newCount - old;
         targetThreads_ = newCount;
         SPDLOG_INFO("ThreadPool resize expand: {} -> {}", old, newCount);
-        for (std::size_t i = 0; i < add; ++i) {
-            workers_.emplace_back(&ThreadPool::workerLoop, this);
+        // 先抵消还没退出的缩容名额，再补新线程
+        std::size_t cancel = std::min(add, threadsToStop_);
+        threadsToStop_ -= cancel;
+        for (std::size_t i = cancel; i < add; ++i) {
+            startWorkerLocked();
         }
     } else {
         std::size_t reduce = old - newCount;
         targetThreads_ = newCount;
         threadsToStop_ += reduce;
         // SPDLOG_INFO("ThreadPool resize shrink: {} -> {}, threadsToStop_={}", old, newCount, threadsToStop_);
-        cv_.notify_all();
+        // 只唤醒要退出的那几个休眠线程，不惊动整个池；没在休眠的线程下次取不到任务时自行退出
+        for (std::size_t i = 0; i < std::min(reduce, sleepers_.load(std::memory_order_relaxed)); ++i) {
+            cv_.notify_one();
+        }
     }
 }
 
@@ -123,120 +233,475 @@ void ThreadPool::setAutoTuneParams(std::size_t highWatermark, std::size_t lowWat
     downThreshold_ = downThreshold;
 }
 
-void ThreadPool::workerLoop() {
+void ThreadPool::setAutoTuneTarget(std::chrono::microseconds queueWaitSlo, std::chrono::milliseconds interval) {
+    queueWaitSloUs_.store(std::max<std::int64_t>(1, queueWaitSlo.count()), std::memory_order_relaxed);
+    adjustIntervalMs_.store(std::max<std::int64_t>(10, interval.count()), std::memory_order_relaxed);
+}
+
+void ThreadPool::setIdleSpin(std::chrono::microseconds spin, std::size_t maxSpinners) {
+    if (maxSpinners == 0) {
+        // 单核上自旋只会和提交方抢 CPU
+        const std::size_t cores = std::thread::hardware_concurrency();
+        maxSpinners = cores > 1 ? cores / 2 : 0;
+    }
+    maxSpinners_.store(maxSpinners, std::memory_order_relaxed);
+    idleSpinNs_.store(std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(spin).count()), std::memory_order_relaxed);
+}
+
+void ThreadPool::enqueue(TaskPriority pri, Task task) {
+    if (stopping_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("Submit on stopped ThreadPool");
+    }
+    // 先占容量再入队：并发提交时总数不会越过上限
+    std::size_t before = totalQueueSize_.fetch_add(1, std::memory_order_seq_cst);
+    std::size_t cap = maxQueueSize_.load(std::memory_order_relaxed);
+    if (cap > 0 && before >= cap && !handleOverflow(pri)) {
+        totalQueueSize_.fetch_sub(1, std::memory_order_relaxed);
+        throw std::runtime_error("ThreadPool queue full");
+    }
+    MetricsRegistry::Instance().workerQueueSize().inc();
+    push(pri, std::move(task));
+}
+
+void ThreadPool::enqueueContinuation(Task task) {
+    totalQueueSize_.fetch_add(1, std::memory_order_seq_cst);
+    MetricsRegistry::Instance().workerQueueSize().inc();
+    push(TaskPriority::High, std::move(task));
+}
+
+void ThreadPool::push(TaskPriority pri, Task task) {
+    std::size_t target;
+    if (tlPool == this) {
+        target = tlSlot;
+    } else {
+        // 只在有线程占用的槽位间轮转；一个都没有（尚未启动/已全部退出）时放进 0 号槽
+        std::size_t active = activeCount_.load(std::memory_order_acquire);
+        target = active == 0 ? 0 : activeSlots_[nextSlot_.fetch_add(1, std::memory_order_relaxed) % active].load(std::memory_order_relaxed);
+    }
+    Worker& w = *slots_[target];
+    {
+        std::lock_guard<std::mutex> lock(w.mtx);
+        w.queues[static_cast<int>(pri)].push_back({std::move(task), nowNs(), static_cast<int>(pri)});
+        w.size.fetch_add(1, std::memory_order_release);
+    }
+    queuedByPri_[static_cast<int>(pri)].fetch_add(1, std::memory_order_release);
+
+    wakeOne();
+}
+
+void ThreadPool::wakeOne() {
+    // 与 workerLoop 休眠前的检查配对：要么对方看到 totalQueueSize_ > 0 不睡，要么这里看到 sleepers_ > 0 去唤醒。
+    // 正在找任务的线程休眠前同样会复查 totalQueueSize_，因此有它在时不必再唤醒
+    if (sleepers_.load(std::memory_order_seq_cst) == 0 || searching_.load(std::memory_order_seq_cst) > 0) {
+        return;
+    }
+    // 唤醒时就把对方记为“找任务中”：被唤醒线程真正跑起来之前，后续提交不会重复唤醒
+    if (searching_.fetch_add(1, std::memory_order_seq_cst) != 0) {
+        searching_.fetch_sub(1, std::memory_order_seq_cst);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++notified_;
+    cv_.notify_one();
+}
+
+bool ThreadPool::spinForWork(bool& searching) {
+    const std::int64_t spinNs = idleSpinNs_.load(std::memory_order_relaxed);
+    if (spinNs <= 0 || stopping_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    if (spinners_.fetch_add(1, std::memory_order_relaxed) >= maxSpinners_.load(std::memory_order_relaxed)) {
+        spinners_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    // 自旋的线程算作“找任务中”：提交方看到它就不去唤醒休眠线程，由它取到任务后按需接力唤醒
+    if (!searching) {
+        searching = true;
+        searching_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    bool found = false;
+    const std::int64_t deadline = nowNs() + spinNs;
+    for (std::uint32_t i = 1;; ++i) {
+        if (totalQueueSize_.load(std::memory_order_acquire) > 0) {
+            found = true;
+            break;
+        }
+        if (stopping_.load(std::memory_order_relaxed) || ((i & 63) == 0 && nowNs() >= deadline)) {
+            break;
+        }
+        // 先纯自旋；之后改为让出时间片，CPU 紧张时不挡住提交任务的线程
+        if (i < kPureSpinIters) {
+            CpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    spinners_.fetch_sub(1, std::memory_order_relaxed);
+    if (found) {
+        MetricsRegistry::Instance().workerSpinHits().inc();
+    }
+    return found;
+}
+
+bool ThreadPool::popFrom(Worker& w, int pri, threadpool_detail::QueuedTask& out) {
+    if (w.size.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(w.mtx);
+    auto& q = w.queues[pri];
+    if (q.empty()) {
+        return false;
+    }
+    out = q.pop_front();
+    w.size.fetch_sub(1, std::memory_order_relaxed);
+    queuedByPri_[pri].fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::stealFrom(Worker& victim, Worker& self, int pri, threadpool_detail::QueuedTask& out) {
+    if (victim.size.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    // 线程私有的暂存区，容量复用，稳态下窃取不分配
+    thread_local std::vector<threadpool_detail::QueuedTask> stolen;
+    stolen.clear();
+    {
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        auto& q = victim.queues[pri];
+        if (q.empty()) {
+            return false;
+        }
+        std::size_t n = (q.size() + 1) / 2;
+        for (std::size_t i = 0; i < n; ++i) {
+            stolen.push_back(q.pop_front());
+        }
+        victim.size.fetch_sub(n, std::memory_order_relaxed);
+    }
+    out = std::move(stolen.front());
+    queuedByPri_[pri].fetch_sub(1, std::memory_order_relaxed);
+    if (stolen.size() > 1) {
+        std::lock_guard<std::mutex> lock(self.mtx);
+        auto& q = self.queues[pri];
+        for (std::size_t i = 1; i < stolen.size(); ++i) {
+            q.push_back(std::move(stolen[i]));
+        }
+        self.size.fetch_add(stolen.size() - 1, std::memory_order_release);
+    }
+    stolen.clear();
+    return true;
+}
+
+bool ThreadPool::popTask(std::size_t self, threadpool_detail::QueuedTask& out) {
+    const std::size_t n = slots_.size();
+    // 按优先级 High -> Normal -> Low：每一级先本地、再从随机起点窃取
+    Worker& mine = *slots_[self];
+    for (int pri = 0; pri < 3; ++pri) {
+        if (queuedByPri_[pri].load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        if (popFrom(mine, pri, out)) {
+            return true;
+        }
+        std::size_t start = nextRandom() % n;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t idx = (start + i) % n;
+            if (idx != self && stealFrom(*slots_[idx], mine, pri, out)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(std::size_t self) {
     liveWorkers_.fetch_add(1, std::memory_order_relaxed);
     MetricsRegistry::Instance().workerLiveThreads().inc();
+    tlPool = this;
+    tlSlot = self;
     // 确保无论哪条 return 路径都能把计数减回去
     struct Guard {
         ThreadPool* pool;
         ~Guard() {
+            tlPool = nullptr;
             pool->liveWorkers_.fetch_sub(1, std::memory_order_relaxed);
             MetricsRegistry::Instance().workerLiveThreads().inc(-1);
         }
     } guard{this};
-    
+
+    Worker& mine = *slots_[self];
+    auto& metrics = MetricsRegistry::Instance();
+    threadpool_detail::QueuedTask item;
+    bool searching = false;
     while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this]() { return stopping_ || totalQueueSize_ > 0; });
-            // 全局停止：队列空且 stopping_，线程结束
-            if (stopping_ && totalQueueSize_ == 0)
-                return;
-
-            // 缩容逻辑：没有任务但有待退出线程
-            if (!stopping_ && totalQueueSize_ <= lowWatermark_ && threadsToStop_ > 0) {
-                --threadsToStop_;
-                return;
+        if (popTask(self, item)) {
+            std::size_t left = totalQueueSize_.fetch_sub(1, std::memory_order_seq_cst) - 1;
+            MetricsRegistry::Instance().workerQueueSize().inc(-1);
+            if (searching) {
+                // 最后一个找任务的线程取到了任务，还有积压就接力唤醒下一个
+                searching = false;
+                if (searching_.fetch_sub(1, std::memory_order_seq_cst) == 1 && left > 0) {
+                    wakeOne();
+                }
+            }
+            // 每个任务记录排队等待与执行耗时（按线程分片的直方图）：开始时刻取自出队之后，
+            // 执行时间不含取任务/窃取与上一个任务结束后的空档
+            const std::int64_t start = nowNs();
+            const bool tune = autoTune_.load(std::memory_order_relaxed);
+            metrics.workerTaskWaitUs(item.pri).observe(static_cast<double>(std::max<std::int64_t>(0, start - item.enqueuedNs)) / 1000.0);
+            if (tune) {
+                recordWait(item.enqueuedNs, start);
+                mine.taskStartNs.store(start, std::memory_order_relaxed);
             }
+            item.task();
+            item.task.reset();
+            const std::int64_t end = nowNs();
+            metrics.workerTaskRunUs(item.pri).observe(static_cast<double>(end - start) / 1000.0);
+            if (tune) {
+                mine.taskStartNs.store(0, std::memory_order_relaxed);
+                busyNs_.fetch_add(end - start, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        if (spinForWork(searching)) {
+            continue;
+        }
+        if (searching) {
+            searching = false;
+            searching_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        // 全局停止：队列空且 stopping_，线程结束
+        if (stopping_ && totalQueueSize_.load() == 0) {
+            releaseSlotLocked(self);
+            return;
+        }
+        // 缩容逻辑：没有任务但有待退出线程（本地剩余任务留在槽里，由其他线程窃取）
+        if (!stopping_ && threadsToStop_ > 0 && totalQueueSize_.load() <= lowWatermark_) {
+            --threadsToStop_;
+            releaseSlotLocked(self);
+            return;
+        }
+
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        metrics.workerParks().inc();
+        cv_.wait(lock, [this]() {
+            std::size_t queued = totalQueueSize_.load();
+            return stopping_ || notified_ > 0 || queued > 0 || (threadsToStop_ > 0 && queued <= lowWatermark_);
+        });
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        searching = true;
+        if (notified_ > 0) {
+            --notified_;  // 领取 wakeOne 预先记下的 searching_
+        } else {
+            searching_.fetch_add(1, std::memory_order_seq_cst);
+        }
+    }
+}
 
-            // 正常取任务：按优先级 High -> Normal -> Low
-            if (!highQ_.empty()) {
-                task = std::move(highQ_.front());
-                highQ_.pop();
-            } else if (!normalQ_.empty()) {
-                task = std::move(normalQ_.front());
-                normalQ_.pop();
-            } else if (!lowQ_.empty()) {
-                task = std::move(lowQ_.front());
-                lowQ_.pop();
-            } else {
-                // 理论上 totalQueueSize_ > 0 时不应发生
+bool ThreadPool::dropOneFrom(int pri) {
+    for (auto& slot : slots_) {
+        Worker& w = *slot;
+        if (w.size.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        threadpool_detail::QueuedTask dropped;
+        {
+            std::lock_guard<std::mutex> lock(w.mtx);
+            auto& q = w.queues[pri];
+            if (q.empty()) {
                 continue;
             }
-
-            --totalQueueSize_;
-            MetricsRegistry::Instance().workerQueueSize().inc(-1);
+            dropped = q.pop_front();
+            w.size.fetch_sub(1, std::memory_order_relaxed);
         }
-        task();
+        queuedByPri_[pri].fetch_sub(1, std::memory_order_relaxed);
+        totalQueueSize_.fetch_sub(1, std::memory_order_relaxed);
+        MetricsRegistry::Instance().workerQueueSize().inc(-1);
+        // 这里可选：记录 "丢弃任务" 的 Metrics 或日志
+        return true;
     }
+    return false;
 }
 
 bool ThreadPool::handleOverflow(TaskPriority incomingPri) {
     if (maxQueueSize_ == 0)
         return true;
 
-    auto dropOneFrom = [this](std::queue<std::function<void()>>& q) -> bool {
-        if (!q.empty()) {
-            q.pop();
-            --totalQueueSize_;
-            MetricsRegistry::Instance().workerQueueSize().inc(-1);
-            // 这里可选：记录 "丢弃任务" 的 Metrics 或日志
-            return true;
-        }
-        return false;
-    };
-
     switch (incomingPri) {
         case TaskPriority::Low:
             return false;
         case TaskPriority::Normal:
-            if (dropOneFrom(lowQ_)) {
-                return true;
-            }
-            return false;
+            return dropOneFrom(static_cast<int>(TaskPriority::Low));
         case TaskPriority::High:
-            if (dropOneFrom(lowQ_))
+            if (dropOneFrom(static_cast<int>(TaskPriority::Low)))
                 return true;
-            if (dropOneFrom(normalQ_))
+            if (dropOneFrom(static_cast<int>(TaskPriority::Normal)))
                 return true;
             return false;
     }
     return false;
 }
 
+void ThreadPool::recordWait(std::int64_t enqueuedNs, std::int64_t nowNs) {
+    auto us = static_cast<std::uint64_t>(std::max<std::int64_t>(0, nowNs - enqueuedNs) / 1000);
+    std::size_t bucket = std::min<std::size_t>(kWaitBuckets - 1, std::bit_width(us));
+    waitBuckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::int64_t ThreadPool::sampleCpuNs(std::vector<std::pair<std::uint64_t, std::int64_t>>& lastCpu) {
+    std::int64_t delta = 0;
+    // 持有 mutex_ 时槽位上的线程不会退出（退出前要在锁内让出槽位），读它的 CPU 时钟是安全的
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        Worker& w = *slots_[i];
+        timespec ts{};
+        if (!w.active || w.cpuClock == CLOCK_THREAD_CPUTIME_ID || clock_gettime(w.cpuClock, &ts) != 0) {
+            lastCpu[i] = {0, 0};
+            continue;
+        }
+        std::int64_t ns = static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+        // 同一个线程取增量；换了线程（或新启动）则它的全部 CPU 时间都发生在本周期内
+        delta += lastCpu[i].first == w.generation ? ns - lastCpu[i].second : ns;
+        lastCpu[i] = {w.generation, ns};
+    }
+    return delta;
+}
+
+/**
+ * 自动伸缩控制器：每个采样周期测量
+ *   - 排队等待 p99（任务从入队到开始执行，按 2 的幂分桶）；
+ *   - 利用率：线程执行任务的时间 / (周期 × 线程数)，执行中的任务按已执行部分计入；
+ *   - CPU 占比：线程 CPU 时间 / 执行时间，区分计算密集与阻塞在 I/O、锁上的任务；
+ *   - CPU 用量：线程池 CPU 时间 / 周期（单位：核），判断 CPU 是否已饱和。
+ * 决策：
+ *   - 等待 p99 超过目标（或队列超过 highWatermark）且利用率高：线程不够用。连续 upThreshold 个周期后
+ *     按超标倍数一次扩容（至少 +1、至多翻倍）；计算密集时不超过核数，CPU 已饱和时不扩容，多开线程只会互相抢 CPU；
+ *   - 等待 p99 低于目标一半、利用率低且队列不超过 lowWatermark：连续 downThreshold 个周期后
+ *     按实际忙碌线程数缩到利用率约 kTargetUtil（一次至多减半）；
+ *   - 两个方向的阈值之间留出回差，每次调整后冷却 kCooldownTicks 个周期，避免来回震荡。
+ * 决策与测量值导出为 server_worker_autotune_* 指标。
+ */
 void ThreadPool::adjustLoop() {
     int highCnt = 0;
     int lowCnt = 0;
+    int cooldown = 0;
+
+    auto& metrics = MetricsRegistry::Instance();
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::pair<std::uint64_t, std::int64_t>> lastCpu(slots_.size());
+    sampleCpuNs(lastCpu);
+    for (auto& b : waitBuckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    busyNs_.store(0, std::memory_order_relaxed);
+    std::int64_t lastTick = nowNs();
+    std::int64_t inflightPrev = 0;
 
     while (autoTune_.load(std::memory_order_relaxed)) {
         {
             std::unique_lock<std::mutex> lockAdjust(mtxAdjust_);
-            cvAdjust_.wait_for(lockAdjust, std::chrono::milliseconds(500),
+            cvAdjust_.wait_for(lockAdjust, std::chrono::milliseconds(adjustIntervalMs_.load(std::memory_order_relaxed)),
                                [this] { return !autoTune_.load(std::memory_order_relaxed); });
             if (!autoTune_.load(std::memory_order_relaxed))
                 break;
         }
-        std::size_t q = queueSize();
-        std::size_t cur = liveWorkerCount();
+        const std::int64_t now = nowNs();
+        const double elapsedNs = static_cast<double>(std::max<std::int64_t>(1, now - lastTick));
+        lastTick = now;
 
-        if (q > highWatermark_) {
-            ++highCnt;
-            lowCnt = 0;
-        } else if (q <= lowWatermark_) {
-            ++lowCnt;
-            highCnt = 0;
-        } else {
-            highCnt = lowCnt = 0;
+        // 本周期的等待分布：取走清零
+        std::uint64_t counts[kWaitBuckets];
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < kWaitBuckets; ++i) {
+            counts[i] = waitBuckets_[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+        double waitP99Us = 0;
+        if (total > 0) {
+            std::uint64_t rank = (total * 99 + 99) / 100;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < kWaitBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    waitP99Us = static_cast<double>(std::uint64_t{1} << i);  // 取桶上界，偏保守
+                    break;
+                }
+            }
+        }
+        const std::size_t q = queueSize();
+        if (q > 0 && total == 0) {
+            // 有积压却一个任务都没取到：线程全被长任务占住，排队时间至少是一个周期
+            waitP99Us = elapsedNs / 1000.0;
         }
 
-        if (highCnt >= upThreshold_ && cur < maxThreads_) {
-            resize(cur + 1);
-            highCnt = 0;
+        // 执行时间 = 本周期执行完的任务 + 执行中任务的增量
+        std::int64_t inflightNow = 0;
+        for (auto& slot : slots_) {
+            std::int64_t start = slot->taskStartNs.load(std::memory_order_relaxed);
+            if (start != 0) {
+                inflightNow += std::max<std::int64_t>(0, now - start);
+            }
         }
-        if (lowCnt >= downThreshold_ && cur > minThreads_) {
-            resize(cur - 1);
+        const std::int64_t busy = std::max<std::int64_t>(0, busyNs_.exchange(0, std::memory_order_relaxed) + inflightNow - inflightPrev);
+        inflightPrev = inflightNow;
+        const std::int64_t cpu = sampleCpuNs(lastCpu);
+
+        const std::size_t live = std::max<std::size_t>(1, liveWorkerCount());
+        const double util = static_cast<double>(busy) / (elapsedNs * static_cast<double>(live));
+        const double cpuShare = busy > 0 ? std::min(1.0, static_cast<double>(cpu) / static_cast<double>(busy)) : 0.0;
+        // 线程数超过核数时计算密集的任务也会因被抢占而拉长执行时间、显得 CPU 占比低，
+        // 所以另看线程池总 CPU 用量：接近全部核数说明 CPU 已饱和
+        const double cpuUsage = static_cast<double>(cpu) / elapsedNs;
+        const bool cpuSaturated = cpuUsage >= kCpuBound * static_cast<double>(cores);
+        const double slo = static_cast<double>(queueWaitSloUs_.load(std::memory_order_relaxed));
+
+        metrics.workerQueueWaitP99Us().set(static_cast<std::int64_t>(waitP99Us));
+        metrics.workerUtilizationPct().set(static_cast<std::int64_t>(util * 100));
+        metrics.workerCpuPct().set(static_cast<std::int64_t>(cpuShare * 100));
+        metrics.workerCpuUsagePct().set(static_cast<std::int64_t>(cpuUsage * 100));
+
+        const std::size_t target = workerCount();
+        const bool overSlo = waitP99Us > slo || q > highWatermark_;
+        if (cooldown > 0) {
+            --cooldown;
+            highCnt = lowCnt = 0;
+        } else if (overSlo && util >= kBusyUtil) {
             lowCnt = 0;
+            if (++highCnt >= upThreshold_ && target < maxThreads_) {
+                highCnt = 0;
+                double factor = std::clamp(waitP99Us / slo, 1.25, 2.0);
+                std::size_t want = std::max(live + 1, static_cast<std::size_t>(std::ceil(static_cast<double>(live) * factor)));
+                if (cpuShare >= kCpuBound) {
+                    want = std::min(want, std::max(cores, live));
+                }
+                if (want > target && !cpuSaturated) {
+                    SPDLOG_INFO("ThreadPool autotune up: waitP99={}us slo={}us util={:.2f} cpu={:.2f} threads {} -> {}", waitP99Us, slo, util,
+                                cpuShare, target, want);
+                    resize(want);
+                    metrics.workerScaleUps().inc();
+                    cooldown = kCooldownTicks;
+                } else {
+                    // 计算密集且已达核数，或线程已吃满全部 CPU：瓶颈在 CPU，加线程无益
+                    metrics.workerScaleHeld().inc();
+                }
+            }
+        } else if (!overSlo && waitP99Us * 2 <= slo && util <= kIdleUtil && q <= lowWatermark_) {
+            highCnt = 0;
+            if (++lowCnt >= downThreshold_ && target > minThreads_) {
+                lowCnt = 0;
+                std::size_t want = static_cast<std::size_t>(std::ceil(util * static_cast<double>(live) / kTargetUtil));
+                want = std::max({want, minThreads_, (target + 1) / 2});
+                if (want < target) {
+                    SPDLOG_INFO("ThreadPool autotune down: waitP99={}us slo={}us util={:.2f} threads {} -> {}", waitP99Us, slo, util, target, want);
+                    resize(want);
+                    metrics.workerScaleDowns().inc();
+                    cooldown = kCooldownTicks;
+                }
+            }
+        } else {
+            highCnt = lowCnt = 0;
         }
+        metrics.workerTargetThreads().set(static_cast<std::int64_t>(workerCount()));
     }
 }